@@ -0,0 +1,32 @@
+// Contribution of a fragment to the order independent blending without storage : overflow tail, weighted blended and moment based OIT.
+// The fragments are blended without knowing the fragments behind them : the translucency is approximated with the color at the max thickness.
+
+#include "MaterialTableCommon.glsl"
+
+
+// Retrieve the premultiplied color and the opacity of a fragment from its material.
+// Returns false if the fragment has no contribution.
+bool GetBlendedContribution( uint _MaterialIndex, bool _IsFacingCamera, out vec3 _PremultipliedColor, out float _Alpha )
+{
+	StoredMaterial Material = Materials[_MaterialIndex];
+	_Alpha = Material.m_BaseColor.a;
+	_PremultipliedColor = Material.m_BaseColor.rgb * Material.m_BaseColor.a;
+
+	// Translucent objects : the back faces only let the color behind go through, and the thickness is unknown without the next fragment.
+	// The front face is approximated by the surface color over the color transmitted at the max thickness.
+	if( Material.m_Parameters.x == 1.0 )
+	{
+		if( !_IsFacingCamera )
+			return false;
+
+		_Alpha *= 1.0 - dot( Material.m_TranslucentColor.rgb, vec3( 1.0 / 3.0 ) );
+	}
+
+	return _Alpha > 0.0;
+}
+
+// Depth weight of McGuire and Bavoil : the nearest fragments dominate the average color.
+float GetBlendedWeight( float _Alpha, float _Depth )
+{
+	return clamp( pow( min( 1.0, _Alpha * 10.0 ) + 0.01, 3.0 ) * 1e8 * pow( 1.0 - _Depth * 0.9, 3.0 ), 1e-2, 3e3 );
+}
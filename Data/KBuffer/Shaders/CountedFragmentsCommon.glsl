@@ -0,0 +1,48 @@
+// Counted A-Buffer : the fragments of a pixel are contiguous in the pool, from the offset given by the prefix sum of the counts of the pixels.
+// The pixels are in rows. A record is 2 words : depth and material index | facing flag << 8. The position is rebuilt from the depth in the resolve pass.
+
+// Offset of the first record of each pixel, followed by the total count of fragments.
+layout(std430, binding = 4) coherent buffer CountedOffsetsBuffer
+{
+	uint Offsets[];
+};
+
+// Total count of fragments of the frame, written by the prefix sum, followed by the records.
+layout(std430, binding = 2) coherent buffer FragmentPoolBuffer
+{
+	uint AllocatedCount;
+	uint Records[];
+};
+
+// Number of records in the pool : the fragments with an offset after are dropped.
+uniform int FragmentPoolCapacity;
+
+// Width of the K-Buffer, to find the offset of a pixel.
+uniform int KBufferWidth;
+
+const uint RecordSize = 2u;
+
+
+uint GetCountedPixelIndex( ivec2 _Pixel )
+{
+	return uint( _Pixel.y * KBufferWidth + _Pixel.x );
+}
+
+void StoreRecord( uint _Slot, float _Depth, uint _MaterialIndex, bool _IsFacingCamera )
+{
+	uint Offset = _Slot * RecordSize;
+	Records[Offset] = floatBitsToUint( _Depth );
+	Records[Offset + 1u] = ( _MaterialIndex & 0xFFu ) | ( _IsFacingCamera ? 0x100u : 0u );
+}
+
+float LoadRecordDepth( uint _Slot )
+{
+	return uintBitsToFloat( Records[_Slot * RecordSize] );
+}
+
+void LoadRecordMaterialAndFacing( uint _Slot, out uint _MaterialIndex, out bool _IsFacingCamera )
+{
+	uint MaterialAndFacing = Records[_Slot * RecordSize + 1u];
+	_MaterialIndex = MaterialAndFacing & 0xFFu;
+	_IsFacingCamera = ( MaterialAndFacing & 0x100u ) != 0u;
+}
@@ -0,0 +1,54 @@
+#version 450 core
+
+// Histogram of the depth complexity : the count of pixels for each number of fragments received by a pixel, stored or dropped.
+// One invocation per pixel, each work group builds its histogram in shared memory before adding it to the global one.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+
+// K-Buffer max capacity.
+#include "KBufferCapacity.glsl"
+
+// Are the fragments stored in the pixel-major buffer instead of the layer-major images ?
+uniform bool UseBufferStorage;
+
+#include "FragmentsBufferCommon.glsl"
+#include "OccupancyCommon.glsl"
+
+// The last bin counts the pixels with a depth complexity of BinsCount - 1 or more.
+const uint BinsCount = 64u;
+
+layout(std430, binding = 7) coherent buffer HistogramBuffer
+{
+	uint Histogram[];
+};
+
+uniform ivec2 ImageSize;
+
+shared uint GroupHistogram[BinsCount];
+
+
+void main()
+{
+	for( uint b = gl_LocalInvocationIndex; b < BinsCount; b += gl_WorkGroupSize.x * gl_WorkGroupSize.y )
+		GroupHistogram[b] = 0u;
+
+	barrier();
+
+	ivec2 Pixel = ivec2( gl_GlobalInvocationID.xy );
+	if( all( lessThan( Pixel, ImageSize ) ) )
+	{
+		uint Count = DecodeCount( UseBufferStorage ? LoadBufferCount( Pixel ) : imageLoad( Counts, Pixel ).r );
+		uint DepthComplexity = Count + imageLoad( DroppedCounts, Pixel ).r;
+		atomicAdd( GroupHistogram[min( DepthComplexity, BinsCount - 1u )], 1u );
+	}
+
+	barrier();
+
+	for( uint b = gl_LocalInvocationIndex; b < BinsCount; b += gl_WorkGroupSize.x * gl_WorkGroupSize.y )
+	{
+		if( GroupHistogram[b] != 0u )
+			atomicAdd( Histogram[b], GroupHistogram[b] );
+	}
+}
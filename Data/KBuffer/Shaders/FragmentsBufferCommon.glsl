@@ -0,0 +1,127 @@
+// Pixel-major storage of the K-Buffer : the count of a pixel followed by its K fragment records, contiguous in one buffer.
+// A record is 2 words : depth and material index | facing flag << 8. The position is rebuilt from the depth in the resolve pass.
+// The including shader must include KBufferCapacity.glsl.
+
+#include "KBufferAddressing.glsl"
+
+layout(std430, binding = 2) coherent buffer FragmentsBuffer
+{
+	uint Fragments[];
+};
+
+const int RecordSize = 2;
+
+// Tile-sparse storage : the buffer is a pool of pages, one page holds the pixels of a tile in Morton order.
+// Only the tiles covered by the translucent objects have a page, the other ones have no storage : they read as empty and drop their fragments.
+uniform bool UseSparseTiles;
+
+// Page of each tile of the K-Buffer, shares the binding of the block sums of the counted mode.
+layout(std430, binding = 5) readonly buffer TilePagesBuffer
+{
+	uint TilePages[];
+};
+
+const uint NoPage = 0xFFFFFFFFu;
+
+
+// Offset of the count of the pixel, its records follow. -1 if the tile of the pixel has no page.
+int GetPixelOffset( ivec2 _Pixel )
+{
+	int PixelIndex = GetPixelIndex( _Pixel );
+
+	if( UseSparseTiles )
+	{
+		uint Page = TilePages[GetTileIndex( _Pixel )];
+		if( Page == NoPage )
+			return -1;
+
+		PixelIndex = int( Page ) * TileSize * TileSize + GetIndexInTile( _Pixel );
+	}
+
+	return PixelIndex * ( 1 + RecordSize * K );
+}
+
+int GetRecordOffset( int _PixelOffset, int _Index )
+{
+	return _PixelOffset + 1 + RecordSize * _Index;
+}
+
+uint LoadBufferCount( ivec2 _Pixel )
+{
+	int PixelOffset = GetPixelOffset( _Pixel );
+	return PixelOffset < 0 ? 0u : Fragments[PixelOffset];
+}
+
+void StoreBufferCount( ivec2 _Pixel, uint _Count )
+{
+	int PixelOffset = GetPixelOffset( _Pixel );
+	if( PixelOffset >= 0 )
+		Fragments[PixelOffset] = _Count;
+}
+
+float LoadBufferDepth( ivec2 _Pixel, int _Index )
+{
+	int PixelOffset = GetPixelOffset( _Pixel );
+	return PixelOffset < 0 ? 1.0 : uintBitsToFloat( Fragments[GetRecordOffset( PixelOffset, _Index )] );
+}
+
+uvec2 LoadBufferRecord( ivec2 _Pixel, int _Index )
+{
+	int PixelOffset = GetPixelOffset( _Pixel );
+	if( PixelOffset < 0 )
+		return uvec2( floatBitsToUint( 1.0 ), 0u );
+
+	int Offset = GetRecordOffset( PixelOffset, _Index );
+	return uvec2( Fragments[Offset], Fragments[Offset + 1] );
+}
+
+void StoreBufferRecord( ivec2 _Pixel, int _Index, uvec2 _Record )
+{
+	int PixelOffset = GetPixelOffset( _Pixel );
+	if( PixelOffset < 0 )
+		return;
+
+	int Offset = GetRecordOffset( PixelOffset, _Index );
+	Fragments[Offset] = _Record.x;
+	Fragments[Offset + 1] = _Record.y;
+}
+
+
+// The facing flag shares the word of the material index, in the images and in the buffer.
+// 8 bits of the index are kept : the material table of the K-Buffer holds at most 256 materials.
+uint PackMaterialAndFacing( uint _MaterialIndex, bool _IsFacingCamera )
+{
+	return ( _MaterialIndex & 0xFFu ) | ( _IsFacingCamera ? 0x100u : 0u );
+}
+
+void UnpackMaterialAndFacing( uint _MaterialAndFacing, out uint _MaterialIndex, out bool _IsFacingCamera )
+{
+	_MaterialIndex = _MaterialAndFacing & 0xFFu;
+	_IsFacingCamera = ( _MaterialAndFacing & 0x100u ) != 0u;
+}
+
+uvec2 PackRecord( float _Depth, uint _MaterialIndex, bool _IsFacingCamera )
+{
+	return uvec2( floatBitsToUint( _Depth ), PackMaterialAndFacing( _MaterialIndex, _IsFacingCamera ) );
+}
+
+void UnpackRecord( uvec2 _Record, out float _Depth, out uint _MaterialIndex, out bool _IsFacingCamera )
+{
+	_Depth = uintBitsToFloat( _Record.x );
+	UnpackMaterialAndFacing( _Record.y, _MaterialIndex, _IsFacingCamera );
+}
+
+
+// The counts are tagged with the generation of the frame that wrote them, in the images and in the buffer : count | generation << 8.
+// A count written by a previous frame reads as 0 : the counts and the fragments do not need to be cleared every frame.
+uniform int Generation;
+
+uint DecodeCount( uint _TaggedCount )
+{
+	return int( _TaggedCount >> 8 ) == Generation ? _TaggedCount & 0xFFu : 0u;
+}
+
+uint EncodeCount( uint _Count )
+{
+	return ( uint( Generation ) << 8 ) | _Count;
+}
@@ -0,0 +1,54 @@
+#version 450 core
+
+// Difference between two resolved images, to compare a cheaper technique with the K-Buffer result.
+// Each work group of 16x16 pixels reduces its differences in shared memory, the CPU sums the groups.
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#define GROUP_SIZE 256
+
+uniform sampler2D ReferenceColors;
+uniform sampler2D ComparedColors;
+
+// Size of the compared area, the smallest of the two images.
+uniform ivec2 ImageSize;
+
+// Sum of the differences, sum of the squared differences and max difference of each work group.
+layout(std430, binding = 0) writeonly buffer DifferenceSumsBuffer
+{
+	vec4 GroupSums[];
+};
+
+shared vec4 SharedSums[GROUP_SIZE];
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_GlobalInvocationID.xy );
+	uint Thread = gl_LocalInvocationIndex;
+
+	// Average of the absolute differences of the channels, in [0, 1].
+	float Difference = 0.0;
+	if( all( lessThan( Pixel, ImageSize ) ) )
+	{
+		vec3 Reference = clamp( texelFetch( ReferenceColors, Pixel, 0 ).rgb, 0.0, 1.0 );
+		vec3 Compared = clamp( texelFetch( ComparedColors, Pixel, 0 ).rgb, 0.0, 1.0 );
+		Difference = dot( abs( Reference - Compared ), vec3( 1.0 / 3.0 ) );
+	}
+
+	SharedSums[Thread] = vec4( Difference, Difference * Difference, Difference, 0.0 );
+	barrier();
+
+	for( uint Stride = GROUP_SIZE / 2u; Stride > 0u; Stride /= 2u )
+	{
+		if( Thread < Stride )
+		{
+			vec4 Other = SharedSums[Thread + Stride];
+			SharedSums[Thread].xy += Other.xy;
+			SharedSums[Thread].z = max( SharedSums[Thread].z, Other.z );
+		}
+
+		barrier();
+	}
+
+	if( Thread == 0u )
+		GroupSums[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = SharedSums[0];
+}
@@ -0,0 +1,47 @@
+// Addressing of the pixels in the K-Buffer storage buffers.
+
+// Width of the K-Buffer, to find the fragments of a pixel.
+uniform int KBufferWidth;
+
+// Are the pixels stored by tiles in Morton order instead of rows ?
+uniform bool UseTiledAddressing;
+
+// Tiles of 8x8 pixels : the storage is rounded up to a multiple of the tile size.
+const int TileSize = 8;
+
+
+// Interleave the 3 low bits of the value with zeros (abc -> 0a0b0c).
+uint SpreadBits( uint _Value )
+{
+	_Value = ( _Value | ( _Value << 2 ) ) & 0x33u;
+	_Value = ( _Value | ( _Value << 1 ) ) & 0x55u;
+
+	return _Value;
+}
+
+// Index of the tile of the pixel, tiles row by row.
+int GetTileIndex( ivec2 _Pixel )
+{
+	int TilesPerRow = ( KBufferWidth + TileSize - 1 ) / TileSize;
+	ivec2 Tile = _Pixel / TileSize;
+
+	return Tile.y * TilesPerRow + Tile.x;
+}
+
+// Index of the pixel in its tile, in Morton order.
+int GetIndexInTile( ivec2 _Pixel )
+{
+	uvec2 PixelInTile = uvec2( _Pixel % TileSize );
+
+	return int( SpreadBits( PixelInTile.x ) | ( SpreadBits( PixelInTile.y ) << 1 ) );
+}
+
+// Index of the pixel in the storage.
+// Tiled addressing keeps the neighbour pixels, which are shaded together, in the same cache lines.
+int GetPixelIndex( ivec2 _Pixel )
+{
+	if( !UseTiledAddressing )
+		return _Pixel.y * KBufferWidth + _Pixel.x;
+
+	return GetTileIndex( _Pixel ) * TileSize * TileSize + GetIndexInTile( _Pixel );
+}
@@ -0,0 +1,11 @@
+// Capacity of the K-Buffer.
+// The K-Buffer defines K when it compiles the shaders specialized for one value of K :
+// the loops over the fragments have a constant bound and can be unrolled, the arrays of the resolve pass are sized for K.
+// Otherwise K is a uniform and the arrays are sized for the maximum capacity.
+
+#ifdef K
+	#define MAX_SIZE K
+#else
+	uniform int K;
+	#define MAX_SIZE 16
+#endif
@@ -0,0 +1,50 @@
+// Per-pixel linked lists of the A-Buffer mode : the link to the first node of each pixel and a global pool of nodes.
+// A node is 3 words : depth, material index | facing flag << 8 and link to the next node. The position is rebuilt from the depth in the resolve pass.
+// A link is the index of the node + 1 : 0 ends the lists, the heads are cleared to 0.
+
+#include "KBufferAddressing.glsl"
+
+// Link to the first node of each pixel, EndOfList when nothing is stored on the pixel.
+layout(std430, binding = 0) coherent buffer ListHeadsBuffer
+{
+	uint Heads[];
+};
+
+// Count of nodes allocated by the frame, it keeps counting after the pool is full, followed by the nodes.
+layout(std430, binding = 2) coherent buffer FragmentPoolBuffer
+{
+	uint AllocatedCount;
+	uint Nodes[];
+};
+
+// Number of nodes in the pool : the fragments allocated after are dropped.
+uniform int FragmentPoolCapacity;
+
+const uint EndOfList = 0u;
+const uint NodeSize = 3u;
+
+
+void StoreNode( uint _Link, float _Depth, uint _MaterialIndex, bool _IsFacingCamera, uint _Next )
+{
+	uint Offset = ( _Link - 1u ) * NodeSize;
+	Nodes[Offset] = floatBitsToUint( _Depth );
+	Nodes[Offset + 1u] = ( _MaterialIndex & 0xFFu ) | ( _IsFacingCamera ? 0x100u : 0u );
+	Nodes[Offset + 2u] = _Next;
+}
+
+float LoadNodeDepth( uint _Link )
+{
+	return uintBitsToFloat( Nodes[( _Link - 1u ) * NodeSize] );
+}
+
+void LoadNodeMaterialAndFacing( uint _Link, out uint _MaterialIndex, out bool _IsFacingCamera )
+{
+	uint MaterialAndFacing = Nodes[( _Link - 1u ) * NodeSize + 1u];
+	_MaterialIndex = MaterialAndFacing & 0xFFu;
+	_IsFacingCamera = ( MaterialAndFacing & 0x100u ) != 0u;
+}
+
+uint LoadNodeNext( uint _Link )
+{
+	return Nodes[( _Link - 1u ) * NodeSize + 2u];
+}
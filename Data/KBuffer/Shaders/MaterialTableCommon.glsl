@@ -0,0 +1,15 @@
+// Material table of the K-Buffer : the stored fragments only keep the index of their material.
+
+// Material parameters as stored in the K-Buffer material table.
+struct StoredMaterial
+{
+	vec4 m_BaseColor;
+	vec4 m_TranslucentColor;
+	vec4 m_Parameters; // x : is translucent, y : max translucent thickness.
+};
+
+// Material table, uploaded from the CPU when a material changes.
+layout(std430, binding = 1) readonly buffer MaterialsBuffer
+{
+	StoredMaterial Materials[];
+};
@@ -0,0 +1,75 @@
+// Moment based OIT of Munstermann et al. : the transmittance along a pixel is reconstructed from its total absorbance and 4 power moments of the depth.
+// First pass : the absorbance and the moments are summed by the hardware blending, in the revealage target.
+// Second pass : each fragment is weighted by the transmittance in front of it and accumulated, the resolve pass composites it like the weighted blended OIT.
+
+#include "BlendedContributionCommon.glsl"
+
+uniform float CameraNear;
+uniform float CameraFar;
+
+// Bias of the moments toward a constant distribution, and part of the own absorbance of a fragment counted in front of it.
+// The bias keeps the Hankel matrix invertible despite the rounding of the 32 bits sums : the moments of a single layer are a degenerate distribution.
+#define MOMENTS_BIAS 5e-5
+#define MOMENTS_OVERESTIMATION 0.25
+
+
+// Absorbance of a fragment, the opaque fragments are clamped to keep the sums finite.
+float GetAbsorbance( float _Alpha )
+{
+	return -log( 1.0 - min( _Alpha, 0.9999 ) );
+}
+
+// Logarithmic view depth in [-1, 1] : the moments of the linear depth are better distributed than the ones of the window depth.
+float WarpDepth( float _Depth )
+{
+	float Z = _Depth * 2.0 - 1.0;
+	float LinearDepth = ( 2.0 * CameraNear * CameraFar ) / ( CameraFar + CameraNear - Z * ( CameraFar - CameraNear ) );
+
+	return clamp( log( LinearDepth / CameraNear ) / log( CameraFar / CameraNear ), 0.0, 1.0 ) * 2.0 - 1.0;
+}
+
+// Transmittance in front of a warped depth, from the total absorbance and the power moments (z, z^2, z^3, z^4) normalized by it.
+// The absorbance is bounded by the Hamburger moment problem : a distribution of 3 depths matching the moments.
+float GetTransmittance( float _TotalAbsorbance, vec4 _Moments, float _WarpedDepth )
+{
+	vec4 b = mix( _Moments, vec4( 0.0, 0.375, 0.0, 0.375 ), MOMENTS_BIAS );
+
+	// Cholesky factorization of the Hankel matrix of the moments.
+	float L21D11 = fma( -b.x, b.y, b.z );
+	float D11 = fma( -b.x, b.x, b.y );
+	float InvD11 = 1.0 / D11;
+	float L21 = L21D11 * InvD11;
+	float SquaredDepthVariance = fma( -b.y, b.y, b.w );
+	float D22 = fma( -L21D11, L21, SquaredDepthVariance );
+
+	// Solve the system of the Hankel matrix with ( 1, z, z^2 ) : coefficients of the polynomial whose roots are the other depths.
+	vec3 c = vec3( 1.0, _WarpedDepth, _WarpedDepth * _WarpedDepth );
+	c.y -= b.x;
+	c.z -= b.y + L21 * c.y;
+	c.y *= InvD11;
+	c.z *= D11 / D22;
+	c.y -= L21 * c.z;
+	c.x -= dot( c.yz, b.xy );
+
+	// Roots of c.x + c.y * z + c.z * z^2.
+	float InvC2 = 1.0 / c.z;
+	float p = c.y * InvC2;
+	float q = c.x * InvC2;
+	float r = sqrt( max( p * p * 0.25 - q, 0.0 ) );
+	vec3 z = vec3( _WarpedDepth, -p * 0.5 - r, -p * 0.5 + r );
+
+	// Interpolate the step function of the depths in front through the 3 depths : the absorbance is the sum of its weights.
+	float f0 = MOMENTS_OVERESTIMATION;
+	float f1 = z.y < z.x ? 1.0 : 0.0;
+	float f2 = z.z < z.x ? 1.0 : 0.0;
+	float f01 = ( f1 - f0 ) / ( z.y - z.x );
+	float f12 = ( f2 - f1 ) / ( z.z - z.y );
+	float f012 = ( f12 - f01 ) / ( z.z - z.x );
+
+	float f01Shifted = f01 - f012 * z.y;
+	vec3 Polynomial = vec3( f0 - f01Shifted * z.x, f01Shifted - f012 * z.x, f012 );
+
+	float Absorbance = Polynomial.x + dot( b.xy, Polynomial.yz );
+
+	return clamp( exp( -_TotalAbsorbance * Absorbance ), 0.0, 1.0 );
+}
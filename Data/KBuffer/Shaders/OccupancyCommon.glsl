@@ -0,0 +1,8 @@
+// Occupancy of the pixels of the K-Buffer, recorded for the debug views and the depth complexity histogram, see KBuffer::DebugView.
+// The fragments stored in a pixel are its count, the other fragments received by the pixel and the failed attempts to lock it are counted in two images.
+
+layout(binding = 5, r32ui) coherent uniform uimage2D DroppedCounts;
+layout(binding = 6, r32ui) coherent uniform uimage2D SpinCounts;
+
+// Is the occupancy recorded for this frame ?
+uniform bool RecordOccupancy;
@@ -0,0 +1,13 @@
+#version 450 core
+
+// Opaque pre-pass : opaque objects are not stored, they write their color and their depth with a regular depth test.
+
+uniform vec4 BaseColor;
+
+out vec4 Color;
+
+void main()
+{
+	// Alpha 1 marks the pixels covered by an opaque object, the resolve pass uses the background color elsewhere.
+	Color = vec4( BaseColor.rgb, 1.0 );
+}
@@ -0,0 +1,29 @@
+// Overflow tail of the hybrid K-Buffer : the fragment dropped by a full pixel is accumulated with weighted blended OIT instead of being lost.
+// The blending is done by the hardware (accumulation : one, one / revealage : zero, one minus source color) : no lock.
+// The dropped fragments are always further than the K fragments kept : the resolve pass composites the tail behind them.
+// The weighted blended OIT uses the same targets : every fragment is dropped.
+
+#include "BlendedContributionCommon.glsl"
+
+uniform bool UseOverflowTail;
+
+layout(location = 1) out vec4 TailAccumulation;
+layout(location = 2) out float TailRevealage;
+
+
+// Write the contribution of the dropped fragment in the tail targets, or discard the invocation if nothing is dropped.
+void OutputDroppedFragment( bool _IsDropped, float _Depth, uint _MaterialIndex, bool _IsFacingCamera )
+{
+	if( !UseOverflowTail || !_IsDropped )
+		discard;
+
+	vec3 PremultipliedColor;
+	float Alpha;
+	if( !GetBlendedContribution( _MaterialIndex, _IsFacingCamera, PremultipliedColor, Alpha ) )
+		discard;
+
+	float Weight = GetBlendedWeight( Alpha, _Depth );
+
+	TailAccumulation = vec4( PremultipliedColor, Alpha ) * Weight;
+	TailRevealage = Alpha;
+}
@@ -0,0 +1,119 @@
+#version 450 core
+
+// Prefix sum of the counts of the counted A-Buffer : the count of fragments of each pixel becomes the offset of its first fragment.
+// PREFIX_SUM_PASS is defined by the K-Buffer when the shader is compiled :
+// 0 : exclusive scan of each block of 1024 pixels, and sum of each block.
+// 1 : exclusive scan of the block sums in one work group, the total count of fragments is written after the offsets and in the pool.
+// 2 : the offset of its block is added to each pixel.
+
+#define THREADS_COUNT 256
+#define VALUES_PER_THREAD 4
+#define BLOCK_SIZE ( THREADS_COUNT * VALUES_PER_THREAD )
+
+layout(local_size_x = THREADS_COUNT) in;
+
+// Counts of fragments of each pixel.
+layout(binding = 1, r32ui) uniform readonly uimage2D Counts;
+
+#include "CountedFragmentsCommon.glsl"
+
+// Sum of the counts of each block, then offset of each block.
+layout(std430, binding = 5) coherent buffer BlockSumsBuffer
+{
+	uint BlockSums[];
+};
+
+uniform int PixelsCount;
+uniform int BlocksCount;
+
+shared uint ThreadSums[THREADS_COUNT];
+
+uint ScanThreadSums( uint _Sum );
+
+
+void main()
+{
+	uint Thread = gl_LocalInvocationID.x;
+	uint First = gl_WorkGroupID.x * BLOCK_SIZE + Thread * VALUES_PER_THREAD;
+
+#if PREFIX_SUM_PASS == 0
+	// Each thread scans its values, then the sums of the threads are scanned in shared memory.
+	uint Scanned[VALUES_PER_THREAD];
+	uint Sum = 0u;
+	for( uint i = 0u; i < VALUES_PER_THREAD; i++ )
+	{
+		uint Index = First + i;
+		uint Count = Index < uint( PixelsCount ) ? imageLoad( Counts, ivec2( Index % uint( KBufferWidth ), Index / uint( KBufferWidth ) ) ).r : 0u;
+
+		Scanned[i] = Sum;
+		Sum += Count;
+	}
+
+	uint ThreadOffset = ScanThreadSums( Sum );
+
+	for( uint i = 0u; i < VALUES_PER_THREAD; i++ )
+	{
+		if( First + i < uint( PixelsCount ) )
+			Offsets[First + i] = ThreadOffset + Scanned[i];
+	}
+
+	if( Thread == THREADS_COUNT - 1 )
+		BlockSums[gl_WorkGroupID.x] = ThreadOffset + Sum;
+
+#elif PREFIX_SUM_PASS == 1
+	// One work group : each thread scans a contiguous part of the block sums.
+	uint PartSize = ( uint( BlocksCount ) + THREADS_COUNT - 1u ) / THREADS_COUNT;
+	uint PartFirst = Thread * PartSize;
+	uint PartEnd = min( PartFirst + PartSize, uint( BlocksCount ) );
+
+	uint Sum = 0u;
+	for( uint b = PartFirst; b < PartEnd; b++ )
+		Sum += BlockSums[b];
+
+	uint ThreadOffset = ScanThreadSums( Sum );
+
+	for( uint b = PartFirst; b < PartEnd; b++ )
+	{
+		uint BlockSum = BlockSums[b];
+		BlockSums[b] = ThreadOffset;
+		ThreadOffset += BlockSum;
+	}
+
+	// The last thread ends with the total count.
+	if( Thread == THREADS_COUNT - 1 )
+	{
+		Offsets[PixelsCount] = ThreadOffset;
+		AllocatedCount = ThreadOffset;
+	}
+
+#else
+	uint BlockOffset = BlockSums[gl_WorkGroupID.x];
+
+	for( uint i = 0u; i < VALUES_PER_THREAD; i++ )
+	{
+		if( First + i < uint( PixelsCount ) )
+			Offsets[First + i] += BlockOffset;
+	}
+#endif
+}
+
+// Exclusive scan of the sums of the threads of the work group (Hillis-Steele).
+// Returns the sum of the threads before the calling one.
+uint ScanThreadSums( uint _Sum )
+{
+	uint Thread = gl_LocalInvocationID.x;
+	ThreadSums[Thread] = _Sum;
+
+	barrier();
+
+	for( uint Stride = 1u; Stride < THREADS_COUNT; Stride <<= 1 )
+	{
+		uint Previous = Thread >= Stride ? ThreadSums[Thread - Stride] : 0u;
+		barrier();
+
+		ThreadSums[Thread] += Previous;
+		barrier();
+	}
+
+	return ThreadSums[Thread] - _Sum;
+}
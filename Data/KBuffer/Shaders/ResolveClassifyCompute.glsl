@@ -0,0 +1,57 @@
+#version 450 core
+
+// Tiled resolve, first pass : one invocation per pixel, one work group per tile.
+// The tile is appended to the list of the sorting network holding its maximum count.
+// Tiles without any fragment nor opaque object keep the background of the target : they are not resolved.
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+
+// K-Buffer max capacity.
+#include "KBufferCapacity.glsl"
+
+// Are the fragments stored in the pixel-major buffer instead of the layer-major images ?
+uniform bool UseBufferStorage;
+
+#include "FragmentsBufferCommon.glsl"
+
+// Color of the opaque pre-pass, alpha 0 without opaque object.
+uniform bool UseOpaquePrePass;
+uniform sampler2D OpaqueColors;
+
+#include "ResolveTilesCommon.glsl"
+
+shared uint TileMaxCount;
+shared uint TileHasOpaque;
+
+
+void main()
+{
+	if( gl_LocalInvocationIndex == 0u )
+	{
+		TileMaxCount = 0u;
+		TileHasOpaque = 0u;
+	}
+
+	barrier();
+
+	ivec2 Pixel = ivec2( gl_GlobalInvocationID.xy );
+	if( all( lessThan( Pixel, ResolveSize ) ) )
+	{
+		uint Count = DecodeCount( UseBufferStorage ? LoadBufferCount( Pixel ) : imageLoad( Counts, Pixel ).r );
+		atomicMax( TileMaxCount, Count );
+
+		if( UseOpaquePrePass && texelFetch( OpaqueColors, Pixel, 0 ).a > 0.0 )
+			atomicOr( TileHasOpaque, 1u );
+	}
+
+	barrier();
+
+	if( gl_LocalInvocationIndex != 0u || ( TileMaxCount == 0u && TileHasOpaque == 0u ) )
+		return;
+
+	int Network = GetSortingNetwork( TileMaxCount );
+	uint Index = atomicAdd( DispatchArguments[Network].x, 1u );
+	Tiles[Network * TilesCount + int( Index )] = PackTile( gl_WorkGroupID.xy );
+}
@@ -0,0 +1,32 @@
+#version 450 core
+
+#include "ResolvePassCommon.glsl"
+
+out vec4 Color;
+
+// Does the revealage target hold the total absorbance of the moment based OIT instead of the revealage of the weighted blended OIT ?
+uniform bool UseMoments;
+
+// Resolve of the weighted blended and moment based OIT : nothing is stored, the accumulated color is composited over the opaque color like the overflow tail.
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+
+	float Revealage = texelFetch( TailRevealages, Pixel, 0 ).r;
+	if( UseMoments )
+		Revealage = exp( -Revealage );
+
+	// Nothing accumulated and no opaque object : the target keeps the background.
+	if( Revealage >= 1.0 && !HasOpaqueFragment( Pixel ) )
+		discard;
+
+	// The weighted blended accumulation is composited by the background, as the overflow tail.
+	vec3 ResolvedColor;
+	float BackDepth;
+	GetBackground( Pixel, ResolvedColor, BackDepth );
+
+	if( UseMoments )
+		ResolvedColor = CompositeAccumulation( Pixel, Revealage, ResolvedColor );
+
+	Color = FinalizeColor( ResolvedColor );
+}
@@ -0,0 +1,339 @@
+// Common part of the resolve pass : material data, sorting and blending of the stored fragments.
+// Shared by the fragment shader resolve and the compute shader tiled resolve.
+
+// K-Buffer max capacity and size of the arrays of fragments.
+#include "KBufferCapacity.glsl"
+
+#include "MaterialTableCommon.glsl"
+
+uniform vec4 BackgroundColor;
+
+uniform vec3 CameraPosition;
+uniform float CameraNear;
+uniform float CameraFar;
+
+uniform bool ToneMap;
+uniform float Exposure;
+
+uniform bool GammaCorrection;
+uniform float Gamma;
+
+// Size of a view and inverse of the view projection of its camera, to rebuild the positions from the depths.
+// Several views are side by side in the K-Buffer.
+const int MaxViewsCount = 4;
+uniform vec2 ViewSize;
+uniform int ViewsCount;
+uniform mat4 InverseViewProjection[MaxViewsCount];
+
+// Are the fragments of a pixel stored as a max-heap on depth ?
+uniform bool UseMaxHeap;
+
+// Color (alpha 0 without opaque object) and depth of the opaque pre-pass, the stored fragments are blended over them.
+uniform bool UseOpaquePrePass;
+uniform sampler2D OpaqueColors;
+uniform sampler2D OpaqueDepths;
+
+// Weighted blended accumulation and revealage of the fragments dropped from the full pixels, composited behind the stored fragments.
+uniform bool UseOverflowTail;
+uniform sampler2D TailAccumulations;
+uniform sampler2D TailRevealages;
+
+// Data common to several fragments.
+struct MaterialData
+{
+	vec4 m_BaseColor;
+	bool m_IsTranslucent;
+	vec3 m_TranslucentColor;
+	float m_MaxTranslucentThickness;
+};
+
+// Per fragment dependent data.
+struct FragmentData
+{
+	float m_Depth;
+	uint m_MaterialIndex;
+	vec3 m_Position;
+	bool m_IsFacingCamera;
+};
+
+void InsertionSort( uint _Count, inout FragmentData _OrdoredDatas[MAX_SIZE] );
+void HeapSort( uint _Count, inout FragmentData _OrdoredDatas[MAX_SIZE] );
+void Reverse( uint _Count, inout FragmentData _OrdoredDatas[MAX_SIZE] );
+vec4 Resolve( uint _Count, ivec2 _Pixel, FragmentData _OrdoredDatas[MAX_SIZE] );
+bool GetBackground( ivec2 _Pixel, out vec3 _Color, out float _Depth );
+vec3 CompositeTail( ivec2 _Pixel, vec3 _BackColor );
+vec3 CompositeAccumulation( ivec2 _Pixel, float _Revealage, vec3 _BackColor );
+void BlendFragment( FragmentData _FragData, bool _IsOverOpaque, inout vec3 _ResolvedColor, inout float _BackDepth );
+vec4 FinalizeColor( vec3 _ResolvedColor );
+vec3 RebuildPosition( ivec2 _Pixel, float _Depth );
+bool HasOpaqueFragment( ivec2 _Pixel );
+
+
+void Swap( int _A, int _B, inout FragmentData _OrdoredDatas[MAX_SIZE] );
+
+// Sort the fragment according to their depth.
+void InsertionSort( uint _Count, inout FragmentData _OrdoredDatas[MAX_SIZE] )
+{
+	// https://en.wikipedia.org/wiki/Insertion_sort
+
+	// The bound of the outer loop is constant in the specialized shaders.
+	for( int i = 1; i < MAX_SIZE; i++ )
+	{
+		if( i >= _Count )
+			break;
+
+		int j = i;
+
+		while( j > 0 && _OrdoredDatas[j - 1].m_Depth < _OrdoredDatas[j].m_Depth )
+		{
+			Swap( j, j - 1, _OrdoredDatas );
+			j--;	
+		}
+	}
+}
+
+
+// Sort the fragments stored as a max-heap, from the furthest to the nearest.
+void HeapSort( uint _Count, inout FragmentData _OrdoredDatas[MAX_SIZE] )
+{
+	// https://en.wikipedia.org/wiki/Heapsort
+	// The fragments are already a max-heap : only the extraction part is needed.
+
+	for( int End = int( _Count ) - 1; End > 0; End-- )
+	{
+		// Move the furthest fragment after the heap, then sift down the new root.
+		Swap( 0, End, _OrdoredDatas );
+
+		int Index = 0;
+		while( true )
+		{
+			int Child = 2 * Index + 1;
+			if( Child >= End )
+				break;
+
+			if( Child + 1 < End && _OrdoredDatas[Child + 1].m_Depth > _OrdoredDatas[Child].m_Depth )
+				Child++;
+
+			if( _OrdoredDatas[Child].m_Depth <= _OrdoredDatas[Index].m_Depth )
+				break;
+
+			Swap( Index, Child, _OrdoredDatas );
+			Index = Child;
+		}
+	}
+
+	// The extraction leaves the nearest first.
+	Reverse( _Count, _OrdoredDatas );
+}
+
+// Reverse the order of the fragments.
+void Reverse( uint _Count, inout FragmentData _OrdoredDatas[MAX_SIZE] )
+{
+	for( int p = 0; p < _Count / 2; p++ )
+		Swap( p, int( _Count ) - 1 - p, _OrdoredDatas );
+}
+
+
+MaterialData GetMaterialData( uint _MatIndex );
+vec3 AlphaBlend( vec3 _FrontColor, vec3 _BackColor, float _Aplha );
+vec3 GetTranslucentColor( FragmentData _FragData, MaterialData _MatData, float _BackDepth, vec3 _BackColor );
+
+// Blend the fragments, sorted from the furthest to the nearest.
+vec4 Resolve( uint _Count, ivec2 _Pixel, FragmentData _OrdoredDatas[MAX_SIZE] )
+{
+	vec3 ResolvedColor;
+	float BackDepth;
+	bool IsOverOpaque = GetBackground( _Pixel, ResolvedColor, BackDepth );
+
+	for( int p = 0; p < MAX_SIZE; p++ )
+	{
+		if( p >= _Count )
+			break;
+
+		BlendFragment( _OrdoredDatas[p], IsOverOpaque, ResolvedColor, BackDepth );
+	}
+
+	return FinalizeColor( ResolvedColor );
+}
+
+// Color and depth behind the stored fragments : the opaque object, it is the back of the translucent objects in front of it, or the background.
+// The dropped fragments of the overflow tail are further than the stored ones : they are composited over it.
+// Returns true if an opaque object is drawn on this pixel.
+bool GetBackground( ivec2 _Pixel, out vec3 _Color, out float _Depth )
+{
+	_Color = BackgroundColor.rgb;
+	_Depth = 1.0;
+
+	bool IsOverOpaque = HasOpaqueFragment( _Pixel );
+	if( IsOverOpaque )
+	{
+		_Color = texelFetch( OpaqueColors, _Pixel, 0 ).rgb;
+		_Depth = texelFetch( OpaqueDepths, _Pixel, 0 ).r;
+	}
+
+	_Color = CompositeTail( _Pixel, _Color );
+
+	return IsOverOpaque;
+}
+
+// Weighted blended composition of the overflow tail over the color behind it.
+vec3 CompositeTail( ivec2 _Pixel, vec3 _BackColor )
+{
+	if( !UseOverflowTail )
+		return _BackColor;
+
+	return CompositeAccumulation( _Pixel, texelFetch( TailRevealages, _Pixel, 0 ).r, _BackColor );
+}
+
+// Composition of the average of the accumulated colors over the color behind them, according to the revealage of the pixel.
+vec3 CompositeAccumulation( ivec2 _Pixel, float _Revealage, vec3 _BackColor )
+{
+	if( _Revealage >= 1.0 )
+		return _BackColor;
+
+	vec4 Accumulation = texelFetch( TailAccumulations, _Pixel, 0 );
+	vec3 AverageColor = Accumulation.rgb / clamp( Accumulation.a, 1e-4, 5e4 );
+
+	return AverageColor * ( 1.0 - _Revealage ) + _BackColor * _Revealage;
+}
+
+// Blend a fragment over the color of the fragments behind it.
+void BlendFragment( FragmentData _FragData, bool _IsOverOpaque, inout vec3 _ResolvedColor, inout float _BackDepth )
+{
+	// Fragments stored before the opaque object hiding them was drawn.
+	if( _IsOverOpaque && _FragData.m_Depth >= _BackDepth )
+		return;
+
+	MaterialData CurrentData = GetMaterialData( _FragData.m_MaterialIndex );
+
+	vec3 CurrentColor;
+
+	if( CurrentData.m_IsTranslucent )
+	{
+		CurrentColor = GetTranslucentColor( _FragData, CurrentData, _BackDepth, _ResolvedColor );
+		_BackDepth = _FragData.m_Depth;
+	}
+	else
+		CurrentColor = CurrentData.m_BaseColor.rgb;
+
+
+	_ResolvedColor = AlphaBlend( CurrentColor, _ResolvedColor, CurrentData.m_BaseColor.a );
+}
+
+// Tone mapping and gamma correction of the blended color.
+vec4 FinalizeColor( vec3 _ResolvedColor )
+{
+	if( ToneMap )
+		_ResolvedColor = vec3( 1.0 ) - exp( -_ResolvedColor * Exposure );
+
+	if( GammaCorrection )
+		_ResolvedColor = pow( _ResolvedColor, vec3( 1.0 / Gamma ) );
+
+
+	return vec4( _ResolvedColor, 1.0 );
+}
+
+
+
+
+void Swap( int _A, int _B, inout FragmentData _OrdoredDatas[MAX_SIZE] )
+{
+	FragmentData DataA = _OrdoredDatas[_A];
+	FragmentData DataB = _OrdoredDatas[_B];
+	
+	_OrdoredDatas[_A] = DataB;
+	_OrdoredDatas[_B] = DataA;
+}
+
+
+// World position of the fragment of a pixel at the given depth.
+// The K-Buffer only stores the depths : the positions are rebuilt from the pixel coordinates.
+vec3 RebuildPosition( ivec2 _Pixel, float _Depth )
+{
+	int ViewIndex = clamp( int( float( _Pixel.x ) / ViewSize.x ), 0, max( ViewsCount, 1 ) - 1 );
+
+	vec2 PixelCenter = vec2( _Pixel ) + 0.5 - vec2( float( ViewIndex ) * ViewSize.x, 0.0 );
+	vec4 ClipPosition = vec4( ( PixelCenter / ViewSize ) * 2.0 - 1.0, _Depth * 2.0 - 1.0, 1.0 );
+	vec4 WorldPosition = ClipPosition * InverseViewProjection[ViewIndex];
+
+	return WorldPosition.xyz / WorldPosition.w;
+}
+
+
+// Is an opaque object drawn on this pixel by the opaque pre-pass ?
+bool HasOpaqueFragment( ivec2 _Pixel )
+{
+	return UseOpaquePrePass && texelFetch( OpaqueColors, _Pixel, 0 ).a > 0.0;
+}
+
+
+MaterialData GetMaterialData( uint _MatIndex )
+{
+	MaterialData Data;
+
+	StoredMaterial Material = Materials[_MatIndex];
+	Data.m_BaseColor = Material.m_BaseColor;
+	Data.m_TranslucentColor = Material.m_TranslucentColor.rgb;
+	Data.m_IsTranslucent = Material.m_Parameters.x == 1.0;
+	Data.m_MaxTranslucentThickness = Material.m_Parameters.y;
+
+	return Data;
+}
+
+
+
+vec3 AlphaBlend( vec3 _FrontColor, vec3 _BackColor, float _Aplha )
+{
+	return vec3( _FrontColor * _Aplha + _BackColor * ( 1.0 - _Aplha ) );
+}
+
+
+
+// Translucency functions.
+
+float LinearizeDepth( in float _Depth, in float _Near, in float _Far ) 
+{
+    float Z = _Depth * 2.0 - 1.0; // back to NDC 
+    return (2.0 * _Near * _Far ) / (_Far + _Near - Z * (_Far - _Near));	
+}
+
+float GetThickness( float _FrontDepth, float _BackDepth )
+{
+	float LinearFrontDepth = LinearizeDepth( _FrontDepth, CameraNear, CameraFar );
+	float LinearBackDepth = LinearizeDepth( _BackDepth, CameraNear, CameraFar );
+
+	return max( 0.0001, LinearBackDepth - LinearFrontDepth );
+}
+
+vec3 GetPhysicalExtinction( float _MaxThickness, vec3 _TargetColor )
+{
+	return max( vec3(0.001), -log( _TargetColor ) ) / _MaxThickness;
+}
+
+vec3 GetTransmittedColor( FragmentData _FragData, MaterialData _MatData, float _BackDepth, vec3 _ViewDirection )
+{
+	float Thickness = GetThickness( _FragData.m_Depth, _BackDepth );
+	vec3 PhysicalExtinction = GetPhysicalExtinction( _MatData.m_MaxTranslucentThickness, _MatData.m_TranslucentColor );
+
+	return exp( -PhysicalExtinction * Thickness );
+}
+
+vec3 GetTranslucentColor( FragmentData _FragData, MaterialData _MatData, float _BackDepth, vec3 _BackColor )
+{	
+	vec3 ViewDirection = normalize( CameraPosition - _FragData.m_Position );
+
+	// Fragment at the other side of the object : we just need to return the color behing them.
+	if( !_FragData.m_IsFacingCamera )
+		return _BackColor;
+
+
+	vec3 SurfaceColor = _MatData.m_BaseColor.rgb;
+
+	// Transmitted color according to the object thickness.
+	vec3 Transmitted = GetTransmittedColor( _FragData, _MatData, _BackDepth, ViewDirection );
+
+	// Translucent color : surface color + background filtered by the transmitted color.
+	vec3 TranslucentColor = SurfaceColor + Transmitted * _BackColor;
+
+	return TranslucentColor;
+}
@@ -0,0 +1,116 @@
+#version 450 core
+
+#include "ResolvePassCommon.glsl"
+
+out vec4 Color;
+
+// Counts of the fragments not written by the second pass, reset for the next frame.
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+
+#include "CountedFragmentsCommon.glsl"
+
+// The ranges up to this size are sorted in a private array, the longer ones are sorted in the pool.
+#define RANGE_ARRAY_SIZE 32
+
+FragmentData GetRecordData( ivec2 _Pixel, uint _Slot, float _Depth );
+void ResolveLongRange( ivec2 _Pixel, uint _First, uint _End, bool _IsOverOpaque, inout vec3 _ResolvedColor, inout float _BackDepth );
+
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+	uint PixelIndex = GetCountedPixelIndex( Pixel );
+
+	// The slots of the fragments hidden by an opaque object drawn after the first pass are at the start of the range.
+	uint Leftover = imageLoad( Counts, Pixel ).r;
+	if( Leftover != 0u )
+		imageStore( Counts, Pixel, uvec4( 0u ) );
+
+	// The fragments over the pool capacity have been dropped.
+	uint End = min( Offsets[PixelIndex + 1u], uint( FragmentPoolCapacity ) );
+	uint First = min( Offsets[PixelIndex] + Leftover, End );
+
+	// Nothing stored and no opaque object : the target keeps the background.
+	if( First == End && !HasOpaqueFragment( Pixel ) )
+		discard;
+
+	vec3 ResolvedColor;
+	float BackDepth;
+	bool IsOverOpaque = GetBackground( Pixel, ResolvedColor, BackDepth );
+
+	uint Count = End - First;
+
+	if( Count > RANGE_ARRAY_SIZE )
+		ResolveLongRange( Pixel, First, End, IsOverOpaque, ResolvedColor, BackDepth );
+
+	else
+	{
+		float Depths[RANGE_ARRAY_SIZE];
+		uint Slots[RANGE_ARRAY_SIZE];
+
+		// Insertion sort while reading the range, from the furthest to the nearest.
+		for( uint i = 0u; i < Count; i++ )
+		{
+			float Depth = LoadRecordDepth( First + i );
+
+			uint j = i;
+			for( ; j > 0u && Depths[j - 1u] < Depth; j-- )
+			{
+				Depths[j] = Depths[j - 1u];
+				Slots[j] = Slots[j - 1u];
+			}
+
+			Depths[j] = Depth;
+			Slots[j] = First + i;
+		}
+
+		for( uint p = 0u; p < Count; p++ )
+			BlendFragment( GetRecordData( Pixel, Slots[p], Depths[p] ), IsOverOpaque, ResolvedColor, BackDepth );
+	}
+
+	Color = FinalizeColor( ResolvedColor );
+}
+
+// Blend a range too long for the private array : each step searches the next furthest fragment in the range.
+// O(N²) reads of the pool, but exact for any length.
+void ResolveLongRange( ivec2 _Pixel, uint _First, uint _End, bool _IsOverOpaque, inout vec3 _ResolvedColor, inout float _BackDepth )
+{
+	// The fragments are ordered by depth then by slot : the fragments with the same depth are blended once each.
+	float PreviousDepth = 2.0;
+	uint PreviousSlot = _End;
+
+	for( uint i = _First; i < _End; i++ )
+	{
+		float NextDepth = -1.0;
+		uint NextSlot = _First;
+
+		for( uint Slot = _First; Slot < _End; Slot++ )
+		{
+			float Depth = LoadRecordDepth( Slot );
+
+			bool IsNearerThanPrevious = Depth < PreviousDepth || ( Depth == PreviousDepth && Slot < PreviousSlot );
+			bool IsFurtherThanNext = Depth > NextDepth || ( Depth == NextDepth && Slot >= NextSlot );
+
+			if( IsNearerThanPrevious && IsFurtherThanNext )
+			{
+				NextDepth = Depth;
+				NextSlot = Slot;
+			}
+		}
+
+		BlendFragment( GetRecordData( _Pixel, NextSlot, NextDepth ), _IsOverOpaque, _ResolvedColor, _BackDepth );
+
+		PreviousDepth = NextDepth;
+		PreviousSlot = NextSlot;
+	}
+}
+
+FragmentData GetRecordData( ivec2 _Pixel, uint _Slot, float _Depth )
+{
+	FragmentData Data;
+	Data.m_Depth = _Depth;
+	LoadRecordMaterialAndFacing( _Slot, Data.m_MaterialIndex, Data.m_IsFacingCamera );
+	Data.m_Position = RebuildPosition( _Pixel, _Depth );
+
+	return Data;
+}
@@ -0,0 +1,51 @@
+#version 450 core
+
+// Debug views of the K-Buffer : the occupancy of each pixel as a heatmap, from blue to red. The pixels without any fragment are black.
+
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+
+// K-Buffer max capacity.
+#include "KBufferCapacity.glsl"
+
+// Are the fragments stored in the pixel-major buffer instead of the layer-major images ?
+uniform bool UseBufferStorage;
+
+#include "FragmentsBufferCommon.glsl"
+#include "OccupancyCommon.glsl"
+
+out vec4 Color;
+
+// Shown occupancy, see KBuffer::DebugView : 1 for the stored fragments, 2 for the dropped fragments, 3 for the spin iterations.
+uniform int DebugView;
+
+// Occupancy shown in red for the dropped fragments and the spin iterations, the stored fragments are red at K.
+uniform float HeatmapMaxValue;
+
+// Blue, cyan, green, yellow then red for a value from 0 to 1.
+vec3 GetHeatColor( float _Value )
+{
+	float Scaled = 4.0 * clamp( _Value, 0.0, 1.0 );
+	return clamp( vec3( Scaled - 2.0, 2.0 - abs( Scaled - 2.0 ), 2.0 - Scaled ), 0.0, 1.0 );
+}
+
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+
+	uint Value = 0u;
+	float MaxValue = HeatmapMaxValue;
+	if( DebugView == 1 )
+	{
+		Value = DecodeCount( UseBufferStorage ? LoadBufferCount( Pixel ) : imageLoad( Counts, Pixel ).r );
+		MaxValue = float( K );
+	}
+
+	else if( DebugView == 2 )
+		Value = imageLoad( DroppedCounts, Pixel ).r;
+
+	else
+		Value = imageLoad( SpinCounts, Pixel ).r;
+
+	Color = Value == 0u ? vec4( 0.0, 0.0, 0.0, 1.0 ) : vec4( GetHeatColor( float( Value ) / max( MaxValue, 1.0 ) ), 1.0 );
+}
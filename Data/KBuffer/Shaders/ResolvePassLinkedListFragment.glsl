@@ -0,0 +1,116 @@
+#version 450 core
+
+#include "ResolvePassCommon.glsl"
+
+out vec4 Color;
+
+#include "LinkedListCommon.glsl"
+
+// The lists up to this size are sorted in a private array, the longer ones are sorted in the pool.
+#define LIST_ARRAY_SIZE 32
+
+FragmentData GetNodeData( ivec2 _Pixel, uint _Link, float _Depth );
+void ResolveLongList( ivec2 _Pixel, uint _Head, uint _Count, bool _IsOverOpaque, inout vec3 _ResolvedColor, inout float _BackDepth );
+
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+	uint Head = Heads[GetPixelIndex( Pixel )];
+
+	// Nothing stored and no opaque object : the target keeps the background.
+	if( Head == EndOfList && !HasOpaqueFragment( Pixel ) )
+		discard;
+
+	vec3 ResolvedColor;
+	float BackDepth;
+	bool IsOverOpaque = GetBackground( Pixel, ResolvedColor, BackDepth );
+
+	// Depth and link of the first fragments of the list, and length of the whole list.
+	float Depths[LIST_ARRAY_SIZE];
+	uint ListLinks[LIST_ARRAY_SIZE];
+	uint Count = 0u;
+
+	for( uint Link = Head; Link != EndOfList; Link = LoadNodeNext( Link ) )
+	{
+		if( Count < LIST_ARRAY_SIZE )
+		{
+			Depths[Count] = LoadNodeDepth( Link );
+			ListLinks[Count] = Link;
+		}
+
+		Count++;
+	}
+
+	if( Count > LIST_ARRAY_SIZE )
+		ResolveLongList( Pixel, Head, Count, IsOverOpaque, ResolvedColor, BackDepth );
+
+	else
+	{
+		// Insertion sort, from the furthest to the nearest.
+		for( uint i = 1u; i < Count; i++ )
+		{
+			float Depth = Depths[i];
+			uint Link = ListLinks[i];
+
+			uint j = i;
+			for( ; j > 0u && Depths[j - 1u] < Depth; j-- )
+			{
+				Depths[j] = Depths[j - 1u];
+				ListLinks[j] = ListLinks[j - 1u];
+			}
+
+			Depths[j] = Depth;
+			ListLinks[j] = Link;
+		}
+
+		for( uint p = 0u; p < Count; p++ )
+			BlendFragment( GetNodeData( Pixel, ListLinks[p], Depths[p] ), IsOverOpaque, ResolvedColor, BackDepth );
+	}
+
+	Color = FinalizeColor( ResolvedColor );
+}
+
+// Blend a list too long for the private array : each step searches the next furthest fragment in the pool.
+// O(N²) reads of the pool, but exact for any length.
+void ResolveLongList( ivec2 _Pixel, uint _Head, uint _Count, bool _IsOverOpaque, inout vec3 _ResolvedColor, inout float _BackDepth )
+{
+	// The fragments are ordered by depth then by link : the fragments with the same depth are blended once each.
+	float PreviousDepth = 2.0;
+	uint PreviousLink = EndOfList;
+
+	for( uint i = 0u; i < _Count; i++ )
+	{
+		float NextDepth = -1.0;
+		uint NextLink = EndOfList;
+
+		for( uint Link = _Head; Link != EndOfList; Link = LoadNodeNext( Link ) )
+		{
+			float Depth = LoadNodeDepth( Link );
+
+			bool IsNearerThanPrevious = Depth < PreviousDepth || ( Depth == PreviousDepth && Link < PreviousLink );
+			bool IsFurtherThanNext = Depth > NextDepth || ( Depth == NextDepth && Link > NextLink );
+
+			if( IsNearerThanPrevious && IsFurtherThanNext )
+			{
+				NextDepth = Depth;
+				NextLink = Link;
+			}
+		}
+
+		BlendFragment( GetNodeData( _Pixel, NextLink, NextDepth ), _IsOverOpaque, _ResolvedColor, _BackDepth );
+
+		PreviousDepth = NextDepth;
+		PreviousLink = NextLink;
+	}
+}
+
+FragmentData GetNodeData( ivec2 _Pixel, uint _Link, float _Depth )
+{
+	FragmentData Data;
+	Data.m_Depth = _Depth;
+	LoadNodeMaterialAndFacing( _Link, Data.m_MaterialIndex, Data.m_IsFacingCamera );
+	Data.m_Position = RebuildPosition( _Pixel, _Depth );
+
+	return Data;
+}
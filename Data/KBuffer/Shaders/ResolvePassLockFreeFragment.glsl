@@ -0,0 +1,62 @@
+#version 450 core
+
+#extension GL_ARB_gpu_shader_int64 : require
+
+// K packed fragments per pixel, sorted from the nearest to the furthest.
+layout(std430, binding = 0) readonly buffer PackedFragmentsBuffer
+{
+	uint64_t PackedFragments[];
+};
+
+#include "ResolvePassCommon.glsl"
+
+out vec4 Color;
+
+#include "KBufferAddressing.glsl"
+
+const uint64_t EmptyFragment = 0xFFFFFFFFFFFFFFFFul;
+
+uint UnpackFragments( ivec2 _Pixel, out FragmentData _OrdoredDatas[MAX_SIZE] );
+
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+
+	FragmentData OrdoredDatas[MAX_SIZE];
+	uint Count = UnpackFragments( Pixel, OrdoredDatas );
+
+	// Nothing stored and no opaque object : the target keeps the background.
+	if( Count == 0 && !HasOpaqueFragment( Pixel ) )
+		discard;
+
+	// The fragments are already sorted, from the nearest to the furthest : reverse them to start with the furthest.
+	Reverse( Count, OrdoredDatas );
+
+	// Accumulate all stored fragment to find the final pixel color.
+	Color = Resolve( Count, Pixel, OrdoredDatas );
+}
+
+// Retrieve and unpack the stored fragments until the first empty slot.
+uint UnpackFragments( ivec2 _Pixel, out FragmentData _OrdoredDatas[MAX_SIZE] )
+{
+	int FirstSlot = GetPixelIndex( _Pixel ) * K;
+
+	uint Count = 0;
+	for( int p = 0; p < K; p++ )
+	{
+		uint64_t Fragment = PackedFragments[FirstSlot + p];
+		if( Fragment == EmptyFragment )
+			break;
+
+		uvec2 PayloadAndDepth = unpackUint2x32( Fragment );
+		_OrdoredDatas[p].m_Depth = uintBitsToFloat( PayloadAndDepth.y );
+		_OrdoredDatas[p].m_MaterialIndex = PayloadAndDepth.x & 0xFFu;
+		_OrdoredDatas[p].m_IsFacingCamera = ( PayloadAndDepth.x & 0x100u ) != 0u;
+		_OrdoredDatas[p].m_Position = RebuildPosition( _Pixel, _OrdoredDatas[p].m_Depth );
+
+		Count++;
+	}
+
+	return Count;
+}
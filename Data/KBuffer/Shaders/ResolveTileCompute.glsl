@@ -0,0 +1,134 @@
+#version 450 core
+
+// Tiled resolve, second pass : one work group per tile of a sorting network list.
+// SORT_SIZE (2, 4, 8 or 16) is defined by the K-Buffer when the shader is compiled.
+// The fragments of each pixel are loaded in shared memory, padded to SORT_SIZE, and sorted by a bitonic sorting network :
+// SORT_SIZE / 2 invocations per pixel, each one compares and exchanges a pair of fragments at each step.
+
+#define TILE_PIXELS 64
+#define PAIRS_COUNT ( SORT_SIZE / 2 )
+
+layout(local_size_x = PAIRS_COUNT, local_size_y = TILE_PIXELS) in;
+
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+layout(binding = 2, r16ui) coherent uniform uimage2DArray MaterialIndices;
+layout(binding = 3, r32f) coherent uniform image2DArray Depths;
+
+// Color texture of the target framebuffer.
+layout(binding = 4) writeonly uniform image2D Target;
+
+#include "ResolvePassCommon.glsl"
+
+// Are the fragments stored in the pixel-major buffer instead of the layer-major images ?
+uniform bool UseBufferStorage;
+
+#include "FragmentsBufferCommon.glsl"
+#include "ResolveTilesCommon.glsl"
+
+// Sorting network of the resolved list.
+uniform int Network;
+
+// Depth and material index | facing flag of the fragments of each pixel of the tile.
+shared float SortedDepths[TILE_PIXELS][SORT_SIZE];
+shared uint SortedMaterials[TILE_PIXELS][SORT_SIZE];
+
+void LoadFragment( ivec2 _Pixel, uint _Index, uint _Count, uint _PixelInTile );
+void CompareAndExchange( uint _PixelInTile, uint _A, uint _B, bool _IsDescending );
+
+
+void main()
+{
+	uint Lane = gl_LocalInvocationID.x;
+	uint PixelInTile = gl_LocalInvocationID.y;
+
+	uvec2 Tile = UnpackTile( Tiles[Network * TilesCount + int( gl_WorkGroupID.x )] );
+	ivec2 Pixel = ivec2( Tile * ResolveTileSize + uvec2( PixelInTile % ResolveTileSize, PixelInTile / ResolveTileSize ) );
+	bool IsInside = all( lessThan( Pixel, ResolveSize ) );
+
+	// Every invocation takes part in the sorting network, even outside of the resolved area.
+	uint Count = 0u;
+	if( IsInside )
+		Count = min( DecodeCount( UseBufferStorage ? LoadBufferCount( Pixel ) : imageLoad( Counts, Pixel ).r ), uint( SORT_SIZE ) );
+
+	for( uint i = Lane; i < SORT_SIZE; i += PAIRS_COUNT )
+		LoadFragment( Pixel, i, Count, PixelInTile );
+
+	barrier();
+
+	// Bitonic sorting network, from the furthest to the nearest : the padding goes at the end.
+	for( uint Size = 2u; Size <= SORT_SIZE; Size <<= 1 )
+	{
+		for( uint Stride = Size >> 1; Stride > 0u; Stride >>= 1 )
+		{
+			uint A = 2u * Stride * ( Lane / Stride ) + Lane % Stride;
+			CompareAndExchange( PixelInTile, A, A + Stride, ( A & Size ) == 0u );
+
+			barrier();
+		}
+	}
+
+	if( Lane != 0u || !IsInside )
+		return;
+
+	vec3 ResolvedColor;
+	float BackDepth;
+	bool IsOverOpaque = GetBackground( Pixel, ResolvedColor, BackDepth );
+
+	// Nothing stored and no opaque object : the target keeps the background.
+	if( Count == 0u && !IsOverOpaque )
+		return;
+
+	for( uint p = 0u; p < Count; p++ )
+	{
+		FragmentData Data;
+		Data.m_Depth = SortedDepths[PixelInTile][p];
+		UnpackMaterialAndFacing( SortedMaterials[PixelInTile][p], Data.m_MaterialIndex, Data.m_IsFacingCamera );
+		Data.m_Position = RebuildPosition( Pixel, Data.m_Depth );
+
+		BlendFragment( Data, IsOverOpaque, ResolvedColor, BackDepth );
+	}
+
+	imageStore( Target, Pixel, FinalizeColor( ResolvedColor ) );
+}
+
+// Copy a fragment of the pixel in shared memory, the slots after the count are nearer than every fragment.
+void LoadFragment( ivec2 _Pixel, uint _Index, uint _Count, uint _PixelInTile )
+{
+	if( _Index >= _Count )
+	{
+		SortedDepths[_PixelInTile][_Index] = -1.0;
+		SortedMaterials[_PixelInTile][_Index] = 0u;
+	}
+
+	else if( UseBufferStorage )
+	{
+		uvec2 Record = LoadBufferRecord( _Pixel, int( _Index ) );
+		SortedDepths[_PixelInTile][_Index] = uintBitsToFloat( Record.x );
+		SortedMaterials[_PixelInTile][_Index] = Record.y;
+	}
+
+	else
+	{
+		ivec3 Pixel3D = ivec3( _Pixel, _Index );
+		SortedDepths[_PixelInTile][_Index] = imageLoad( Depths, Pixel3D ).r;
+		SortedMaterials[_PixelInTile][_Index] = imageLoad( MaterialIndices, Pixel3D ).r;
+	}
+}
+
+// Order a pair of fragments of the pixel.
+void CompareAndExchange( uint _PixelInTile, uint _A, uint _B, bool _IsDescending )
+{
+	float DepthA = SortedDepths[_PixelInTile][_A];
+	float DepthB = SortedDepths[_PixelInTile][_B];
+
+	if( ( DepthA < DepthB ) != _IsDescending )
+		return;
+
+	uint MaterialA = SortedMaterials[_PixelInTile][_A];
+
+	SortedDepths[_PixelInTile][_A] = DepthB;
+	SortedDepths[_PixelInTile][_B] = DepthA;
+
+	SortedMaterials[_PixelInTile][_A] = SortedMaterials[_PixelInTile][_B];
+	SortedMaterials[_PixelInTile][_B] = MaterialA;
+}
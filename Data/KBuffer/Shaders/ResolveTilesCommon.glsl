@@ -0,0 +1,37 @@
+// Tiled resolve : the tiles of the K-Buffer are classified by their maximum count of fragments,
+// then each tile is resolved by the smallest sorting network holding this count.
+
+// Tiles of 8x8 pixels, one work group per tile.
+const uint ResolveTileSize = 8u;
+
+// Sorting networks of 2, 4, 8 and 16 fragments.
+const int SortingNetworksCount = 4;
+
+// Indirect dispatch arguments of each sorting network (groups x, y and z), followed by the lists of tiles of each network.
+layout(std430, binding = 3) coherent buffer ResolveTilesBuffer
+{
+	uvec4 DispatchArguments[SortingNetworksCount];
+	uint Tiles[];
+};
+
+// Size of each list of tiles : the number of tiles of the resolved area.
+uniform int TilesCount;
+
+// Size of the resolved area : the K-Buffer size clamped to the target size.
+uniform ivec2 ResolveSize;
+
+
+int GetSortingNetwork( uint _MaxCount )
+{
+	return _MaxCount <= 2u ? 0 : ( _MaxCount <= 4u ? 1 : ( _MaxCount <= 8u ? 2 : 3 ) );
+}
+
+uint PackTile( uvec2 _Tile )
+{
+	return _Tile.x | ( _Tile.y << 16 );
+}
+
+uvec2 UnpackTile( uint _PackedTile )
+{
+	return uvec2( _PackedTile & 0xFFFFu, _PackedTile >> 16 );
+}
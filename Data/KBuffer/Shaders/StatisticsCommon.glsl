@@ -0,0 +1,40 @@
+// Statistics of the store pass, collected for the profiling and the adaptive K of the K-Buffer, see KBuffer::FrameStatistics.
+// Each statistic is spread over 64 counters chosen by the position of the pixel in a tile of 8x8 pixels : the atomic operations of neighbour pixels do not contend.
+// The K-Buffer sums the counters once they are read back.
+// The dropped fragments and the spin iterations are also counted per pixel when the occupancy is recorded.
+
+#include "OccupancyCommon.glsl"
+
+layout(std430, binding = 6) coherent buffer StatisticsBuffer
+{
+	uint Statistics[];
+};
+
+// Are the statistics collected for this frame ?
+uniform bool CollectStatistics;
+
+const uint StoredFragmentsStatistic = 0u;
+const uint CulledFragmentsStatistic = 1u;
+const uint RejectedFragmentsStatistic = 2u;
+const uint EvictedFragmentsStatistic = 3u;
+const uint SpinIterationsStatistic = 4u;
+
+
+void AddStatistic( uint _Statistic, uint _Value )
+{
+	if( _Value == 0u )
+		return;
+
+	uvec2 Pixel = uvec2( gl_FragCoord.xy );
+
+	// A culled, rejected or evicted fragment is one fragment dropped by the pixel.
+	if( RecordOccupancy && _Statistic == SpinIterationsStatistic )
+		imageAtomicAdd( SpinCounts, ivec2( Pixel ), _Value );
+	else if( RecordOccupancy && _Statistic != StoredFragmentsStatistic )
+		imageAtomicAdd( DroppedCounts, ivec2( Pixel ), _Value );
+
+	if( !CollectStatistics )
+		return;
+
+	atomicAdd( Statistics[_Statistic * 64u + ( ( Pixel.x & 7u ) | ( ( Pixel.y & 7u ) << 3 ) )], _Value );
+}
@@ -0,0 +1,312 @@
+// Common part of the store pass : insertion of the fragment in the K-Buffer images or buffer.
+// The caller must guarantee that it is the only one accessing the pixel (semaphore or interlock).
+
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+layout(binding = 2, r16ui) coherent uniform uimage2DArray MaterialIndices;
+layout(binding = 3, r32f) coherent uniform image2DArray Depths;
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+// K-Buffer max capacity.
+#include "KBufferCapacity.glsl"
+
+// Are the fragments of a pixel organised as a max-heap on depth instead of the furthest at head and the others unsorted ?
+uniform bool UseMaxHeap;
+
+// Are the fragments stored in the pixel-major buffer instead of the layer-major images ?
+uniform bool UseBufferStorage;
+
+#include "FragmentsBufferCommon.glsl"
+
+#include "OverflowTailCommon.glsl"
+
+#include "StatisticsCommon.glsl"
+
+
+struct FragmentData
+{
+	uint m_MaterialIndex;
+	float m_Depth;
+	bool m_IsFacingCamera;
+};
+
+
+void InsertEmpty( uint _Count, ivec2 _Pixel );
+FragmentData InsertFull( uint _Count, ivec2 _Pixel );
+
+bool EarlyCulling( ivec2 _Pixel );
+
+
+uint GetCount( ivec2 _Pixel )
+{
+	if( UseBufferStorage )
+		return DecodeCount( LoadBufferCount( _Pixel ) );
+
+	return DecodeCount( imageLoad( Counts, _Pixel ).r );
+}
+
+void SetCount( ivec2 _Pixel, uint _Count )
+{
+	if( UseBufferStorage )
+		StoreBufferCount( _Pixel, EncodeCount( _Count ) );
+	else
+		imageStore( Counts, _Pixel, uvec4( EncodeCount( _Count ) ) );
+}
+
+float GetDepth( ivec2 _Pixel, int _Index )
+{
+	if( UseBufferStorage )
+		return LoadBufferDepth( _Pixel, _Index );
+
+	return imageLoad( Depths, ivec3( _Pixel, _Index ) ).r;
+}
+
+bool EarlyCulling( ivec2 _Pixel )
+{
+	bool IsFull = GetCount( _Pixel ) >= K;
+	bool IsFurtherThanHead = gl_FragCoord.z > GetDepth( _Pixel, 0 );
+	
+	return IsFull && IsFurtherThanHead;
+}
+
+FragmentData GetFragmentData( ivec2 _Pixel, uint _Depth )
+{
+	FragmentData Data;
+
+	if( UseBufferStorage )
+	{
+		UnpackRecord( LoadBufferRecord( _Pixel, int( _Depth ) ), Data.m_Depth, Data.m_MaterialIndex, Data.m_IsFacingCamera );
+		return Data;
+	}
+
+	ivec3 Pixel3D = ivec3( _Pixel, _Depth );
+	UnpackMaterialAndFacing( imageLoad( MaterialIndices, Pixel3D ).r, Data.m_MaterialIndex, Data.m_IsFacingCamera );
+	Data.m_Depth = imageLoad( Depths, Pixel3D ).r;
+
+	return Data;
+}
+
+FragmentData SetupFragmentData()
+{
+	FragmentData Data;
+
+	Data.m_MaterialIndex = ObjectMaterialIndex;
+	Data.m_Depth = gl_FragCoord.z;
+	Data.m_IsFacingCamera = gl_FrontFacing;
+
+	return Data;
+}
+
+void SetFragmentData( FragmentData _Data, ivec2 _Pixel, uint _Depth )
+{
+	if( UseBufferStorage )
+	{
+		StoreBufferRecord( _Pixel, int( _Depth ), PackRecord( _Data.m_Depth, _Data.m_MaterialIndex, _Data.m_IsFacingCamera ) );
+		return;
+	}
+
+	ivec3 Pixel3D = ivec3( _Pixel, _Depth );
+	imageStore( MaterialIndices, Pixel3D, uvec4( PackMaterialAndFacing( _Data.m_MaterialIndex, _Data.m_IsFacingCamera ) ) );
+	imageStore( Depths, Pixel3D, vec4( _Data.m_Depth ) );
+}
+
+
+void HeapInsertEmpty( uint _Count, ivec2 _Pixel );
+FragmentData HeapInsertFull( uint _Count, ivec2 _Pixel );
+
+void InsertEmpty( uint _Count, ivec2 _Pixel )
+{
+	AddStatistic( StoredFragmentsStatistic, 1u );
+
+	if( UseMaxHeap )
+	{
+		HeapInsertEmpty( _Count, _Pixel );
+		return;
+	}
+
+	FragmentData CurrentData = SetupFragmentData();
+	FragmentData HeadData = GetFragmentData( _Pixel, 0 );
+	
+	// If the new fragment is further than the head, replace the head to keep the furthest fragment into it.
+	if( _Count == 0 || CurrentData.m_Depth > HeadData.m_Depth )
+	{
+		SetFragmentData( CurrentData, _Pixel, 0 );
+
+		// Change current value to place the previous head in the array.		
+		CurrentData = HeadData;
+	}
+
+	// Insert color and depth of the fragment at the end of array.
+	// Skipped for the first insertion since we placed it in the head.
+	if( _Count > 0 )
+		SetFragmentData( CurrentData, _Pixel, _Count );
+
+	// Update fragments count.
+	SetCount( _Pixel, _Count + 1 );
+}
+
+
+
+// Find the furthest fragment index after the head.
+// Only called when the K-Buffer is full : the bound is K, constant in the specialized shaders.
+int NextFurthestFragment( out float _FurthestValue, uint _Count, ivec2 _Pixel )
+{
+	int CurrentMaxID = 0; // If K is 1, the head will be taken.
+	float CurrentMaxDepth = -1.0;
+	for( int p = 1; p < K; p++ )
+	{
+		float CurrentDepth = GetDepth( _Pixel, p );
+
+		if( CurrentDepth > CurrentMaxDepth )
+		{
+			CurrentMaxID = p;
+			CurrentMaxDepth = CurrentDepth;
+		}
+	}
+
+	_FurthestValue = CurrentMaxDepth;
+	return CurrentMaxID;
+}
+
+// Take the second furthest data after the head and place it at head.
+void ReplaceHead( int _FurthestIndex, ivec2 _Pixel )
+{
+	FragmentData FurthestData = GetFragmentData( _Pixel, _FurthestIndex );
+	SetFragmentData( FurthestData, _Pixel, 0 );
+}
+
+
+void ReplaceWithCurrentData( int _Index, ivec2 _Pixel )
+{
+	FragmentData CurrentData = SetupFragmentData();
+	SetFragmentData( CurrentData, _Pixel, _Index);
+}
+
+// Returns the fragment dropped from the pixel : the new fragment or the evicted head.
+FragmentData InsertFull( uint _Count, ivec2 _Pixel )
+{
+	FragmentData HeadData = GetFragmentData( _Pixel, 0 );
+
+	// If the new fragment is further that our furthest stored, skip it.
+	if( gl_FragCoord.z > HeadData.m_Depth )
+	{
+		AddStatistic( RejectedFragmentsStatistic, 1u );
+		return SetupFragmentData();
+	}
+
+	// The new fragment is stored, the furthest one is evicted.
+	AddStatistic( StoredFragmentsStatistic, 1u );
+	AddStatistic( EvictedFragmentsStatistic, 1u );
+
+	if( UseMaxHeap )
+		return HeapInsertFull( _Count, _Pixel );
+
+	// Find the furthest fragment, the head is ignored since we are going to replace it.
+	float FurthestDepth = 0.0;
+	int FurthestIndex = NextFurthestFragment( FurthestDepth, _Count, _Pixel );
+
+	// K == 1 : just put the current data in the head.
+	// If the new fragment is the new furthest of the array, put it in the head.
+	if( FurthestIndex == 0 || gl_FragCoord.z > FurthestDepth )
+		ReplaceWithCurrentData( 0, _Pixel );
+
+	else
+	{
+		// Place the furthest fragment in the head of the array.
+		ReplaceHead( FurthestIndex, _Pixel );
+
+		// Place the current fragment at the place of the previous furthest fragment (that is now at the head of the array).
+		ReplaceWithCurrentData( FurthestIndex, _Pixel );
+	}
+
+	// The previous head was the furthest fragment : it is evicted.
+	return HeadData;
+}
+
+
+
+// Max-heap functions.
+// The furthest fragment is the root (index 0, like the head) and the children of the index i are at 2i + 1 and 2i + 2.
+// Insertion and eviction only read and write the fragments along one branch : O(log K) instead of O(K).
+
+// Move a stored fragment to another index of the pixel array.
+void CopyFragment( ivec2 _Pixel, int _From, int _To )
+{
+	if( UseBufferStorage )
+	{
+		StoreBufferRecord( _Pixel, _To, LoadBufferRecord( _Pixel, _From ) );
+		return;
+	}
+
+	ivec3 From = ivec3( _Pixel, _From );
+	ivec3 To = ivec3( _Pixel, _To );
+
+	imageStore( MaterialIndices, To, imageLoad( MaterialIndices, From ) );
+	imageStore( Depths, To, imageLoad( Depths, From ) );
+}
+
+void HeapInsertEmpty( uint _Count, ivec2 _Pixel )
+{
+	FragmentData CurrentData = SetupFragmentData();
+
+	// Sift up : the parents nearer than the new fragment go down until its place is found.
+	int Index = int( _Count );
+	while( Index > 0 )
+	{
+		int Parent = ( Index - 1 ) / 2;
+		if( GetDepth( _Pixel, Parent ) >= CurrentData.m_Depth )
+			break;
+
+		CopyFragment( _Pixel, Parent, Index );
+		Index = Parent;
+	}
+
+	SetFragmentData( CurrentData, _Pixel, Index );
+
+	// Update fragments count.
+	SetCount( _Pixel, _Count + 1 );
+}
+
+// Returns the fragment dropped from the pixel : the new fragment or the evicted root.
+FragmentData HeapInsertFull( uint _Count, ivec2 _Pixel )
+{
+	FragmentData RootData = GetFragmentData( _Pixel, 0 );
+
+	// If the new fragment is further that our furthest stored, skip it.
+	if( gl_FragCoord.z > RootData.m_Depth )
+		return SetupFragmentData();
+
+	FragmentData CurrentData = SetupFragmentData();
+
+	// Sift down : the root is evicted, its furthest children go up until the place of the new fragment is found.
+	int Index = 0;
+	int Count = int( _Count );
+	while( true )
+	{
+		int Child = 2 * Index + 1;
+		if( Child >= Count )
+			break;
+
+		float ChildDepth = GetDepth( _Pixel, Child );
+		if( Child + 1 < Count )
+		{
+			float RightDepth = GetDepth( _Pixel, Child + 1 );
+			if( RightDepth > ChildDepth )
+			{
+				Child++;
+				ChildDepth = RightDepth;
+			}
+		}
+
+		if( ChildDepth <= CurrentData.m_Depth )
+			break;
+
+		CopyFragment( _Pixel, Child, Index );
+		Index = Child;
+	}
+
+	SetFragmentData( CurrentData, _Pixel, Index );
+
+	return RootData;
+}
@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(early_fragment_tests) in;
+
+// Counts of fragments of each pixel, turned into offsets by the prefix sum.
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+
+// First pass of the counted A-Buffer : only count the fragments of each pixel.
+void main()
+{
+	imageAtomicAdd( Counts, ivec2( gl_FragCoord.xy ), 1u );
+
+	discard;
+}
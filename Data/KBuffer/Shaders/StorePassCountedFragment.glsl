@@ -0,0 +1,35 @@
+#version 450 core
+
+layout(early_fragment_tests) in;
+
+// Counts of fragments of each pixel, from the first pass.
+layout(binding = 1, r32ui) coherent uniform uimage2D Counts;
+
+#include "CountedFragmentsCommon.glsl"
+
+#include "StatisticsCommon.glsl"
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+// Second pass of the counted A-Buffer : the same objects are drawn again and their fragments are written in the range of their pixel.
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+
+	// The count goes down as the fragments are written : the slots of the pixel are given from the last one.
+	// A fragment counted but hidden since by an opaque object leaves a slot unused at the start of the range, and its count in the image.
+	uint Slot = Offsets[GetCountedPixelIndex( Pixel )] + imageAtomicAdd( Counts, Pixel, 0xFFFFFFFFu ) - 1u;
+
+	// Pool too small for this frame : the fragment is dropped.
+	if( Slot < uint( FragmentPoolCapacity ) )
+	{
+		StoreRecord( Slot, gl_FragCoord.z, uint( ObjectMaterialIndex ), gl_FrontFacing );
+		AddStatistic( StoredFragmentsStatistic, 1u );
+	}
+
+	else
+		AddStatistic( RejectedFragmentsStatistic, 1u );
+
+	discard;
+}
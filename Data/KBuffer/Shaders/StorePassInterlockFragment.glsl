@@ -0,0 +1,53 @@
+#version 450 core
+
+#extension GL_ARB_fragment_shader_interlock : require
+
+layout(early_fragment_tests) in;
+
+// The insertion does not depend on the order of the fragments, only their exclusive access to the pixel matters.
+layout(pixel_interlock_unordered) in;
+
+#include "StorePassCommon.glsl"
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );	
+
+	// Culling : Skip when the array is full and the new fragment is further than the head.
+	// With the overflow tail, the fragment is dropped but its contribution is written after the interlock (it cannot follow a return).
+	bool IsCulled = EarlyCulling( Pixel );
+	if( IsCulled )
+		AddStatistic( CulledFragmentsStatistic, 1u );
+
+	if( IsCulled && !UseOverflowTail )
+		discard;
+
+	// A full pixel always drops a fragment : the new one or the furthest stored.
+	bool IsDropped = IsCulled;
+	FragmentData Dropped = SetupFragmentData();
+
+	// Critical section : the hardware guarantees that only this fragment accesses the pixel until the end of the interlock.
+	beginInvocationInterlockARB();
+
+	if( !IsCulled )
+	{
+		// Check if the fragments array is full.
+		uint Count = GetCount( Pixel );
+		bool IsNotFull = Count < K;	
+
+		// If the array is not full, just add the fragment at the end.
+		if( IsNotFull )
+			InsertEmpty( Count, Pixel );
+
+		// Otherwise replace the furthest stored fragments with the new fragment.
+		else
+		{
+			Dropped = InsertFull( Count, Pixel );
+			IsDropped = true;
+		}
+	}
+
+	endInvocationInterlockARB();
+
+	OutputDroppedFragment( IsDropped, Dropped.m_Depth, Dropped.m_MaterialIndex, Dropped.m_IsFacingCamera );
+}
@@ -0,0 +1,33 @@
+#version 450 core
+
+layout(early_fragment_tests) in;
+
+#include "LinkedListCommon.glsl"
+
+#include "StatisticsCommon.glsl"
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+
+	// Allocate a node in the pool, without lock.
+	uint Link = atomicAdd( AllocatedCount, 1u ) + 1u;
+
+	// Pool exhausted : the fragment is dropped, the allocated count tells the K-Buffer how many nodes the frame needed.
+	if( Link > uint( FragmentPoolCapacity ) )
+	{
+		AddStatistic( RejectedFragmentsStatistic, 1u );
+		discard;
+	}
+
+	AddStatistic( StoredFragmentsStatistic, 1u );
+
+	// Push the node at the front of the list of the pixel : the order of the list is the order of arrival.
+	uint Next = atomicExchange( Heads[GetPixelIndex( Pixel )], Link );
+	StoreNode( Link, gl_FragCoord.z, uint( ObjectMaterialIndex ), gl_FrontFacing, Next );
+
+	discard;
+}
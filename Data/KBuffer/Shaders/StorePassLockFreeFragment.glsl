@@ -0,0 +1,90 @@
+#version 450 core
+
+#extension GL_ARB_gpu_shader_int64 : require
+#extension GL_NV_shader_atomic_int64 : require
+
+layout(early_fragment_tests) in;
+
+// K packed fragments per pixel, sorted from the nearest to the furthest.
+layout(std430, binding = 0) coherent buffer PackedFragmentsBuffer
+{
+	uint64_t PackedFragments[];
+};
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+// K-Buffer max capacity.
+#include "KBufferCapacity.glsl"
+
+#include "KBufferAddressing.glsl"
+
+#include "OverflowTailCommon.glsl"
+
+#include "StatisticsCommon.glsl"
+
+// Value of an empty slot (cleared with 0xFFFFFFFF) : always further than any fragment.
+const uint64_t EmptyFragment = 0xFFFFFFFFFFFFFFFFul;
+
+
+uint64_t PackFragment();
+void OutputDroppedPackedFragment( bool _IsDropped, uint64_t _Fragment );
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+	int FirstSlot = GetPixelIndex( Pixel ) * K;
+
+	uint64_t NewFragment = PackFragment();
+	uint64_t Fragment = NewFragment;
+
+	// Culling : Skip when the furthest slot is already nearer than the new fragment.
+	// The fragment is dropped : only its contribution to the overflow tail is written.
+	if( PackedFragments[FirstSlot + K - 1] < Fragment )
+	{
+		AddStatistic( CulledFragmentsStatistic, 1u );
+		OutputDroppedPackedFragment( true, Fragment );
+		return;
+	}
+
+	// Insert the fragment without lock : each slot keeps the minimum and the maximum goes on to the next slot.
+	// The slots stay sorted and the fragment getting out of the last slot is the one dropped.
+	bool IsDropped = true;
+	for( int p = 0; p < K; p++ )
+	{
+		uint64_t Previous = atomicMin( PackedFragments[FirstSlot + p], Fragment );
+
+		// The slot was empty : the fragment (or a pushed one) is stored.
+		if( Previous == EmptyFragment )
+		{
+			IsDropped = false;
+			break;
+		}
+
+		Fragment = Previous > Fragment ? Previous : Fragment;
+	}
+
+	// The fragment getting out of the last slot is the new one (rejected) or a stored one (evicted by the new one).
+	bool IsRejected = IsDropped && Fragment == NewFragment;
+	AddStatistic( IsRejected ? RejectedFragmentsStatistic : StoredFragmentsStatistic, 1u );
+	if( IsDropped && !IsRejected )
+		AddStatistic( EvictedFragmentsStatistic, 1u );
+
+	OutputDroppedPackedFragment( IsDropped, Fragment );
+}
+
+void OutputDroppedPackedFragment( bool _IsDropped, uint64_t _Fragment )
+{
+	uvec2 Unpacked = unpackUint2x32( _Fragment );
+
+	OutputDroppedFragment( _IsDropped, uintBitsToFloat( Unpacked.y ), Unpacked.x & 0xFFu, ( Unpacked.x & 0x100u ) != 0u );
+}
+
+// Depth in the high bits to sort with integer comparisons (positive floats keep their order as uint).
+// Material index and facing flag in the low bits. The position is rebuilt from the depth in the resolve pass.
+uint64_t PackFragment()
+{
+	uint Payload = ( uint( ObjectMaterialIndex ) & 0xFFu ) | ( gl_FrontFacing ? 0x100u : 0u );
+
+	return packUint2x32( uvec2( Payload, floatBitsToUint( gl_FragCoord.z ) ) );
+}
@@ -0,0 +1,37 @@
+#version 450 core
+
+layout(early_fragment_tests) in;
+
+#include "MomentsCommon.glsl"
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+// Total absorbance and power moments of the pixels, accumulated by the first pass.
+uniform sampler2D TotalAbsorbances;
+uniform sampler2D TotalPowerMoments;
+
+// Color weighted by the transmittance in front of the fragment, summed by the hardware blending (one, one).
+layout(location = 1) out vec4 Accumulation;
+
+// Second pass of the moment based OIT : the objects are drawn again and blended with the transmittance reconstructed from the moments.
+void main()
+{
+	vec3 PremultipliedColor;
+	float Alpha;
+	if( !GetBlendedContribution( uint( ObjectMaterialIndex ), gl_FrontFacing, PremultipliedColor, Alpha ) )
+		discard;
+
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+
+	// Nearly transparent pixel : nothing in front of the fragment absorbs.
+	float Transmittance = 1.0;
+	float TotalAbsorbance = texelFetch( TotalAbsorbances, Pixel, 0 ).r;
+	if( TotalAbsorbance > 1e-4 )
+	{
+		vec4 Moments = texelFetch( TotalPowerMoments, Pixel, 0 ) / TotalAbsorbance;
+		Transmittance = GetTransmittance( TotalAbsorbance, Moments, WarpDepth( gl_FragCoord.z ) );
+	}
+
+	Accumulation = vec4( PremultipliedColor, Alpha ) * Transmittance;
+}
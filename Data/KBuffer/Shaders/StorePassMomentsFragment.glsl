@@ -0,0 +1,29 @@
+#version 450 core
+
+layout(early_fragment_tests) in;
+
+#include "MomentsCommon.glsl"
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+// Absorbance and power moments weighted by the absorbance, summed by the hardware blending (one, one).
+// Both are summed in 32 bits floats : the moments normalized by the total absorbance must stay a valid distribution.
+layout(location = 2) out float TotalAbsorbance;
+layout(location = 3) out vec4 PowerMoments;
+
+// First pass of the moment based OIT : only the moments of the pixel are accumulated.
+void main()
+{
+	vec3 PremultipliedColor;
+	float Alpha;
+	if( !GetBlendedContribution( uint( ObjectMaterialIndex ), gl_FrontFacing, PremultipliedColor, Alpha ) )
+		discard;
+
+	float Absorbance = GetAbsorbance( Alpha );
+	float Z = WarpDepth( gl_FragCoord.z );
+	float Z2 = Z * Z;
+
+	TotalAbsorbance = Absorbance;
+	PowerMoments = vec4( Z, Z2, Z2 * Z, Z2 * Z2 ) * Absorbance;
+}
@@ -6,11 +6,41 @@ uniform mat4 Model;
 uniform mat4 View;
 uniform mat4 Projection;
 
-out vec3 VS_Position;
+// Index of the material in the K-Buffer material table, uploaded from the CPU.
+uniform int MaterialIndex;
+
+// Batched draws and instanced drawables : the transform and the material index of each object are per instance attributes.
+// A batch draws each object as an instance, an instanced drawable reads the attributes of an instance once per view.
+uniform bool HasInstanceAttributes;
+layout (location = 4) in mat4 InstanceModel;
+layout (location = 8) in int InstanceMaterialIndex;
+
+// Several views side by side in the K-Buffer : the consecutive instances of the draw are the object seen by each view.
+const int MaxViewsCount = 4;
+uniform int ViewsCount;
+uniform mat4 ViewProjection[MaxViewsCount];
+
+// Material index of the object, read by the store pass fragment shaders.
+flat out int ObjectMaterialIndex;
 
 void main()
 {
-	gl_Position = vec4(Position, 1.0) * (Model * View * Projection);
+	ObjectMaterialIndex = HasInstanceAttributes ? InstanceMaterialIndex : MaterialIndex;
+	mat4 ObjectModel = HasInstanceAttributes ? InstanceModel : Model;
+
+	if( ViewsCount <= 1 )
+	{
+		gl_Position = vec4(Position, 1.0) * (ObjectModel * View * Projection);
+		return;
+	}
+
+	int ViewIndex = gl_InstanceID % ViewsCount;
+	vec4 ClipPosition = vec4( Position, 1.0 ) * ( ObjectModel * ViewProjection[ViewIndex] );
+
+	// The clip distances cut the primitives at the borders of the view, the clip space of the view is squeezed in its column of the K-Buffer.
+	gl_ClipDistance[0] = ClipPosition.w + ClipPosition.x;
+	gl_ClipDistance[1] = ClipPosition.w - ClipPosition.x;
 
-	VS_Position = vec3( vec4( Position.xyz, 1.0 ) * Model );
-}
\ No newline at end of file
+	ClipPosition.x = ( ClipPosition.x + ClipPosition.w * float( 1 - ViewsCount + 2 * ViewIndex ) ) / float( ViewsCount );
+	gl_Position = ClipPosition;
+}
@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(early_fragment_tests) in;
+
+#include "OverflowTailCommon.glsl"
+
+// Index of the material in the K-Buffer material table, from the material of the object or from its instance attributes, see StorePassVertex.glsl.
+flat in int ObjectMaterialIndex;
+
+// Weighted blended OIT : nothing is stored, every fragment is accumulated in the tail targets by the hardware blending.
+void main()
+{
+	OutputDroppedFragment( true, gl_FragCoord.z, uint( ObjectMaterialIndex ), gl_FrontFacing );
+}
@@ -0,0 +1,78 @@
+#version 450 core
+
+// Composition of the K-Buffer resolved at a lower resolution in the target : joint bilateral upsampling.
+// Each pixel of the target blends the 4 nearest low resolution pixels, weighted by their bilinear weight and by the similarity of their depth with its own depth.
+// The depths come from the guide, the nearest depth of the drawn objects at the target resolution : the colors do not leak across the silhouettes.
+
+// Resolved colors of the K-Buffer, alpha is the coverage : 0 where no fragment was resolved.
+uniform sampler2D LowResolutionColors;
+
+// Nearest depth of the drawn objects, the depth of a low resolution pixel is read at its center.
+uniform sampler2D GuideDepths;
+
+// Downscale factor of the K-Buffer, size rendered by the K-Buffer and size of the target.
+uniform int ResolutionDivisor;
+uniform ivec2 LowResolutionSize;
+uniform ivec2 OutputSize;
+
+uniform float CameraNear;
+uniform float CameraFar;
+
+// Relative difference of linear depth dividing the weight of a low resolution pixel by e.
+const float DepthSigma = 0.02;
+
+// Premultiplied color and coverage, blended over the target.
+out vec4 Color;
+
+float LinearizeDepth( float _Depth )
+{
+	float Z = _Depth * 2.0 - 1.0;
+	return ( 2.0 * CameraNear * CameraFar ) / ( CameraFar + CameraNear - Z * ( CameraFar - CameraNear ) );
+}
+
+
+void main()
+{
+	ivec2 Pixel = ivec2( gl_FragCoord.xy );
+	float PixelDepth = LinearizeDepth( texelFetch( GuideDepths, Pixel, 0 ).r );
+
+	// Center of the pixel in the low resolution pixels, the 4 nearest centers surround it.
+	vec2 LowResolutionPosition = ( vec2( Pixel ) + 0.5 ) / float( ResolutionDivisor ) - 0.5;
+	ivec2 FirstPixel = ivec2( floor( LowResolutionPosition ) );
+	vec2 Fraction = LowResolutionPosition - vec2( FirstPixel );
+
+	vec4 WeightedColor = vec4( 0.0 );
+	float TotalWeight = 0.0;
+
+	vec4 NearestColor = vec4( 0.0 );
+	float NearestDifference = 1e30;
+
+	for( int i = 0; i < 4; i++ )
+	{
+		ivec2 Offset = ivec2( i & 1, i >> 1 );
+		ivec2 LowResolutionPixel = clamp( FirstPixel + Offset, ivec2( 0 ), LowResolutionSize - 1 );
+		ivec2 GuidePixel = min( LowResolutionPixel * ResolutionDivisor + ResolutionDivisor / 2, OutputSize - 1 );
+
+		float LowResolutionDepth = LinearizeDepth( texelFetch( GuideDepths, GuidePixel, 0 ).r );
+		float Difference = abs( LowResolutionDepth - PixelDepth ) / max( PixelDepth, 1e-4 );
+
+		vec2 Bilinear = mix( 1.0 - Fraction, Fraction, vec2( Offset ) );
+		float Weight = Bilinear.x * Bilinear.y * exp( -Difference / DepthSigma );
+
+		vec4 Sample = texelFetch( LowResolutionColors, LowResolutionPixel, 0 );
+		WeightedColor += vec4( Sample.rgb * Sample.a, Sample.a ) * Weight;
+		TotalWeight += Weight;
+
+		if( Difference < NearestDifference )
+		{
+			NearestDifference = Difference;
+			NearestColor = Sample;
+		}
+	}
+
+	// No low resolution pixel on the surface of the pixel (thin objects) : the nearest in depth is used alone.
+	Color = TotalWeight > 1e-4 ? WeightedColor / TotalWeight : vec4( NearestColor.rgb * NearestColor.a, NearestColor.a );
+
+	if( Color.a <= 0.0 )
+		discard;
+}
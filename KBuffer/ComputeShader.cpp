@@ -0,0 +1,27 @@
+#include "ComputeShader.h"
+
+#include <API/Code/Graphics/Dependencies/OpenGL.h>
+#include <API/Code/Debugging/Debugging.h>
+
+ComputeShader::ComputeShader( const std::string& _Path, const std::string& _Defines ) :
+	ShaderProgram( _Defines )
+{
+	LinkStages( { CompileStage( _Path, GL_COMPUTE_SHADER ) }, "Compute shader " + _Path );
+}
+
+void ComputeShader::Dispatch( Uint32 _GroupsX, Uint32 _GroupsY, Uint32 _GroupsZ ) const
+{
+	if( _GroupsX == 0 || _GroupsY == 0 || _GroupsZ == 0 )
+		return;
+
+	glDispatchCompute( _GroupsX, _GroupsY, _GroupsZ );
+	AE_ErrorCheckOpenGLError();
+}
+
+void ComputeShader::DispatchIndirect( Uint32 _BufferID, size_t _Offset ) const
+{
+	glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, _BufferID );
+	glDispatchComputeIndirect( Cast( GLintptr, _Offset ) );
+	glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 );
+	AE_ErrorCheckOpenGLError();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+/// <summary>
+/// Simple wrapper around an OpenGL compute shader program.<para/>
+/// The engine shaders only have vertex, geometry and fragment stages : the K-Buffer uses this one for its compute passes.<para/>
+/// The #include directives are processed like the engine shaders, relatively to the including file.
+/// The uniforms are set with the static setters of ae::Shader.
+/// </summary>
+class ComputeShader : public ShaderProgram
+{
+public:
+	/// <summary>Create an OpenGL compute shader program from a shader file.</summary>
+	/// <param name="_Path">The compute shader file path.</param>
+	/// <param name="_Defines">Optional code inserted after the #version directive, to specialize the shader (#define lines).</param>
+	explicit ComputeShader( const std::string& _Path, const std::string& _Defines = "" );
+
+	/// <summary>Launch work groups with the bound program.</summary>
+	/// <param name="_GroupsX">Number of work groups on X.</param>
+	/// <param name="_GroupsY">Number of work groups on Y.</param>
+	/// <param name="_GroupsZ">Number of work groups on Z.</param>
+	void Dispatch( Uint32 _GroupsX, Uint32 _GroupsY = 1, Uint32 _GroupsZ = 1 ) const;
+
+	/// <summary>Launch work groups with the bound program, the number of groups is read from a buffer.</summary>
+	/// <param name="_BufferID">OpenGL ID of the buffer with the 3 numbers of groups.</param>
+	/// <param name="_Offset">Offset in bytes of the numbers of groups in the buffer.</param>
+	void DispatchIndirect( Uint32 _BufferID, size_t _Offset = 0 ) const;
+};
@@ -0,0 +1,115 @@
+#include "GPUBuffer.h"
+
+#include <API/Code/Graphics/Dependencies/OpenGL.h>
+#include <API/Code/Debugging/Debugging.h>
+
+GPUBuffer::GPUBuffer( size_t _Size ) :
+	m_BufferID( 0 ),
+	m_Size( 0 )
+{
+	glCreateBuffers( 1, &m_BufferID );
+	AE_ErrorCheckOpenGLError();
+
+	Resize( _Size );
+}
+
+GPUBuffer::~GPUBuffer()
+{
+	FreeResource();
+}
+
+void GPUBuffer::Resize( size_t _Size )
+{
+	if( m_Size == _Size && m_Size != 0 )
+		return;
+
+	m_Size = _Size;
+
+	glNamedBufferData( m_BufferID, Cast( GLsizeiptr, m_Size ), nullptr, GL_DYNAMIC_COPY );
+	AE_ErrorCheckOpenGLError();
+}
+
+size_t GPUBuffer::GetSize() const
+{
+	return m_Size;
+}
+
+void GPUBuffer::Clear( Uint32 _Value )
+{
+	if( m_Size == 0 )
+		return;
+
+	glClearNamedBufferData( m_BufferID, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &_Value );
+	AE_ErrorCheckOpenGLError();
+}
+
+void GPUBuffer::Clear( Uint32 _Value, size_t _Size, size_t _Offset )
+{
+	if( _Offset >= m_Size )
+		return;
+
+	size_t Size = _Size < m_Size - _Offset ? _Size : m_Size - _Offset;
+	if( Size == 0 )
+		return;
+
+	glClearNamedBufferSubData( m_BufferID, GL_R32UI, Cast( GLintptr, _Offset ), Cast( GLsizeiptr, Size ), GL_RED_INTEGER, GL_UNSIGNED_INT, &_Value );
+	AE_ErrorCheckOpenGLError();
+}
+
+void GPUBuffer::SetData( const void* _Data, size_t _Size, size_t _Offset )
+{
+	if( _Size == 0 || _Offset + _Size > m_Size )
+		return;
+
+	glNamedBufferSubData( m_BufferID, Cast( GLintptr, _Offset ), Cast( GLsizeiptr, _Size ), _Data );
+	AE_ErrorCheckOpenGLError();
+}
+
+void GPUBuffer::GetData( void* _Data, size_t _Size, size_t _Offset ) const
+{
+	if( _Size == 0 || _Offset + _Size > m_Size )
+		return;
+
+	glGetNamedBufferSubData( m_BufferID, Cast( GLintptr, _Offset ), Cast( GLsizeiptr, _Size ), _Data );
+	AE_ErrorCheckOpenGLError();
+}
+
+void GPUBuffer::CopyTo( GPUBuffer& _Destination, size_t _Size, size_t _SourceOffset, size_t _DestinationOffset ) const
+{
+	if( _Size == 0 || _SourceOffset + _Size > m_Size || _DestinationOffset + _Size > _Destination.m_Size )
+		return;
+
+	glCopyNamedBufferSubData( m_BufferID, _Destination.m_BufferID, Cast( GLintptr, _SourceOffset ), Cast( GLintptr, _DestinationOffset ), Cast( GLsizeiptr, _Size ) );
+	AE_ErrorCheckOpenGLError();
+}
+
+void GPUBuffer::BindAsStorage( Uint32 _Binding ) const
+{
+	glBindBufferBase( GL_SHADER_STORAGE_BUFFER, _Binding, m_BufferID );
+	AE_ErrorCheckOpenGLError();
+}
+
+Uint32 GPUBuffer::GetBufferID() const
+{
+	return m_BufferID;
+}
+
+void GPUBuffer::SetName( const std::string& _NewName )
+{
+	ae::Resource::SetName( _NewName );
+
+	glObjectLabel( GL_BUFFER, m_BufferID, Cast( GLsizei, _NewName.size() ), _NewName.c_str() );
+	AE_ErrorCheckOpenGLError();
+}
+
+void GPUBuffer::FreeResource()
+{
+	if( m_BufferID == 0 )
+		return;
+
+	glDeleteBuffers( 1, &m_BufferID );
+	AE_ErrorCheckOpenGLError();
+
+	m_BufferID = 0;
+	m_Size = 0;
+}
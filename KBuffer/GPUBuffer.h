@@ -0,0 +1,78 @@
+#pragma once
+
+#include <API/Code/Toolbox/Toolbox.h>
+#include <API/Code/Resources/Resource/Resource.h>
+
+/// <summary>
+/// Simple wrapper around an OpenGL buffer object.<para/>
+/// Used by the K-Buffer for the data that cannot be stored in textures (shader storage buffers).
+/// </summary>
+class GPUBuffer : public ae::Resource
+{
+public:
+	/// <summary>Create a buffer of <paramref name="_Size"/> bytes. The content is undefined.</summary>
+	/// <param name="_Size">The size in bytes of the buffer.</param>
+	explicit GPUBuffer( size_t _Size = 0 );
+
+	/// <summary>Destroy the OpenGL buffer.</summary>
+	~GPUBuffer();
+
+	/// <summary>Reallocate the buffer with a new size. The content is lost.</summary>
+	/// <param name="_Size">The new size in bytes of the buffer.</param>
+	void Resize( size_t _Size );
+
+	/// <summary>Retrieve the size of the buffer.</summary>
+	/// <returns>The size in bytes of the buffer.</returns>
+	size_t GetSize() const;
+
+	/// <summary>Fill the whole buffer with a 32 bits value.</summary>
+	/// <param name="_Value">The value to repeat in the buffer.</param>
+	void Clear( Uint32 _Value );
+
+	/// <summary>Fill a range of the buffer with a 32 bits value.</summary>
+	/// <param name="_Value">The value to repeat in the buffer.</param>
+	/// <param name="_Size">The size in bytes to fill, a multiple of 4. Clamped to the end of the buffer.</param>
+	/// <param name="_Offset">The offset in bytes of the range, a multiple of 4.</param>
+	void Clear( Uint32 _Value, size_t _Size, size_t _Offset = 0 );
+
+	/// <summary>Copy data from the CPU into the buffer.</summary>
+	/// <param name="_Data">The data to copy.</param>
+	/// <param name="_Size">The size in bytes of the data, must fit in the buffer from the offset.</param>
+	/// <param name="_Offset">Where to copy the data in the buffer, in bytes.</param>
+	void SetData( const void* _Data, size_t _Size, size_t _Offset = 0 );
+
+	/// <summary>Copy data from the buffer to the CPU. Wait until the GPU commands writing the buffer are finished.</summary>
+	/// <param name="_Data">Where to copy the data.</param>
+	/// <param name="_Size">The size in bytes of the data, must fit in the buffer from the offset.</param>
+	/// <param name="_Offset">Where to read the data in the buffer, in bytes.</param>
+	void GetData( AE_Out void* _Data, size_t _Size, size_t _Offset = 0 ) const;
+
+	/// <summary>Copy a part of the buffer in another buffer, on the GPU.</summary>
+	/// <param name="_Destination">The buffer receiving the data.</param>
+	/// <param name="_Size">The size in bytes of the data, must fit in both buffers from the offsets.</param>
+	/// <param name="_SourceOffset">Where to read the data in this buffer, in bytes.</param>
+	/// <param name="_DestinationOffset">Where to copy the data in the destination buffer, in bytes.</param>
+	void CopyTo( GPUBuffer& _Destination, size_t _Size, size_t _SourceOffset = 0, size_t _DestinationOffset = 0 ) const;
+
+	/// <summary>Bind the buffer to a shader storage block binding point.</summary>
+	/// <param name="_Binding">The binding point of the block in the shader.</param>
+	void BindAsStorage( Uint32 _Binding ) const;
+
+	/// <summary>Get the OpenGL ID of the buffer.</summary>
+	/// <returns>OpenGL ID of the buffer.</returns>
+	Uint32 GetBufferID() const;
+
+	/// <summary>Set the name of the buffer.</summary>
+	/// <param name="_NewName">The new name to apply to the buffer.</param>
+	void SetName( const std::string& _NewName ) override;
+
+	/// <summary>Free the OpenGL buffer.</summary>
+	void FreeResource() override;
+
+private:
+	/// <summary>OpenGL buffer ID.</summary>
+	Uint32 m_BufferID;
+
+	/// <summary>Size in bytes of the buffer.</summary>
+	size_t m_Size;
+};
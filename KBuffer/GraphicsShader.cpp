@@ -0,0 +1,9 @@
+#include "GraphicsShader.h"
+
+#include <API/Code/Graphics/Dependencies/OpenGL.h>
+
+GraphicsShader::GraphicsShader( const std::string& _VertexPath, const std::string& _FragmentPath, const std::string& _Defines ) :
+	ShaderProgram( _Defines )
+{
+	LinkStages( { CompileStage( _VertexPath, GL_VERTEX_SHADER ), CompileStage( _FragmentPath, GL_FRAGMENT_SHADER ) }, "Shader " + _VertexPath + " / " + _FragmentPath );
+}
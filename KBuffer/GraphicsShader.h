@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ShaderProgram.h"
+
+/// <summary>
+/// OpenGL program of a vertex and a fragment shader, built in memory from the shader files.<para/>
+/// The engine shaders are compiled from their files as they are : the K-Buffer uses this one for its store and resolve passes, specialized for K with defines
+/// without writing any file.<para/>
+/// The engine does not know this shader : the camera, the transform and the material index of the objects are sent by the K-Buffer.
+/// </summary>
+class GraphicsShader : public ShaderProgram
+{
+public:
+	/// <summary>Create an OpenGL program from a vertex and a fragment shader file.</summary>
+	/// <param name="_VertexPath">The vertex shader file path.</param>
+	/// <param name="_FragmentPath">The fragment shader file path.</param>
+	/// <param name="_Defines">Optional code inserted after the #version directive of both stages, to specialize the shader (#define lines).</param>
+	GraphicsShader( const std::string& _VertexPath, const std::string& _FragmentPath, const std::string& _Defines = "" );
+};
@@ -0,0 +1,208 @@
+#include "InstancedDrawable.h"
+
+#include <API/Code/Graphics/Dependencies/OpenGL.h>
+#include <API/Code/Maths/Functions/MathsFunctions.h>
+#include <API/Code/Debugging/Debugging.h>
+
+#include <algorithm>
+#include <cstddef>
+
+InstancedDrawable::InstancedDrawable( const ae::Vertex3DArray& _Vertices, const IndexArray& _Indices ) :
+	ae::Drawable( _Vertices, _Indices ),
+	m_Instances(),
+	m_InstanceMaterials(),
+	m_MeshMin(),
+	m_MeshMax(),
+	m_HasVertices( !_Vertices.empty() ),
+	m_InstancesVersion( 0 ),
+	m_InstancesMin(),
+	m_InstancesMax(),
+	m_AreBoundsDirty( True ),
+	m_InstancesBuffer( 0 ),
+	m_IsBufferDirty( True )
+{
+	m_InstancesBuffer.SetName( "Instanced Drawable Instances Buffer" );
+
+	if( m_HasVertices )
+	{
+		m_MeshMin = _Vertices[0].Position;
+		m_MeshMax = _Vertices[0].Position;
+		for( const ae::Vertex3D& Vertex : _Vertices )
+		{
+			m_MeshMin = ae::Vector3( ae::Math::Min( m_MeshMin.X, Vertex.Position.X ), ae::Math::Min( m_MeshMin.Y, Vertex.Position.Y ), ae::Math::Min( m_MeshMin.Z, Vertex.Position.Z ) );
+			m_MeshMax = ae::Vector3( ae::Math::Max( m_MeshMax.X, Vertex.Position.X ), ae::Math::Max( m_MeshMax.Y, Vertex.Position.Y ), ae::Math::Max( m_MeshMax.Z, Vertex.Position.Z ) );
+		}
+	}
+
+	// The instance attributes follow the attributes of the 3D vertices, with their own binding.
+	SetupInstanceAttributes( m_VertexArrayObject, 4, m_InstancesBuffer.GetBufferID() );
+}
+
+InstancedDrawable::InstancedDrawable( const ae::Drawable& _Mesh ) :
+	InstancedDrawable( ReadVertices( _Mesh ), ReadIndices( _Mesh ) )
+{
+	SetPrimitiveType( _Mesh.GetPrimitiveType() );
+}
+
+Uint32 InstancedDrawable::AddInstance( const ae::Matrix4x4& _Model, const StorePassMaterial& _Material )
+{
+	m_Instances.push_back( InstanceAttributes() );
+	SetInstance( Cast( Uint32, m_Instances.size() - 1 ), _Model, _Material );
+
+	return Cast( Uint32, m_Instances.size() - 1 );
+}
+
+void InstancedDrawable::SetInstance( Uint32 _Instance, const ae::Matrix4x4& _Model, const StorePassMaterial& _Material )
+{
+	if( _Instance >= m_Instances.size() )
+	{
+		AE_LogWarning( "Instance index out of range. Instance will not be changed." );
+		return;
+	}
+
+	InstanceAttributes& Instance = m_Instances[_Instance];
+	std::copy( _Model.GetData(), _Model.GetData() + 16, Instance.Model );
+	Instance.MaterialIndex = ae::Math::Max( 0, _Material.GetMaterialIndex().GetValue() );
+
+	// A material no longer used by any instance stays in the list until the instances are cleared : it only costs an update of its entry.
+	if( std::find( m_InstanceMaterials.begin(), m_InstanceMaterials.end(), &_Material ) == m_InstanceMaterials.end() )
+		m_InstanceMaterials.push_back( &_Material );
+
+	OnInstancesChanged();
+}
+
+void InstancedDrawable::ClearInstances()
+{
+	m_Instances.clear();
+	m_InstanceMaterials.clear();
+
+	OnInstancesChanged();
+}
+
+Uint32 InstancedDrawable::GetInstancesCount() const
+{
+	return Cast( Uint32, m_Instances.size() );
+}
+
+const std::vector<const StorePassMaterial*>& InstancedDrawable::GetInstanceMaterials() const
+{
+	return m_InstanceMaterials;
+}
+
+Uint64 InstancedDrawable::GetInstancesVersion() const
+{
+	return m_InstancesVersion;
+}
+
+Bool InstancedDrawable::GetInstancesBounds( AE_Out ae::Vector3& _Min, AE_Out ae::Vector3& _Max ) const
+{
+	if( !m_HasVertices || m_Instances.empty() )
+		return False;
+
+	if( m_AreBoundsDirty )
+	{
+		m_InstancesMin = ae::Vector3( 1e30f, 1e30f, 1e30f );
+		m_InstancesMax = ae::Vector3( -1e30f, -1e30f, -1e30f );
+
+		ae::Matrix4x4 Model;
+		for( const InstanceAttributes& Instance : m_Instances )
+		{
+			std::copy( Instance.Model, Instance.Model + 16, Model.GetData() );
+
+			for( Uint32 Corner = 0; Corner < 8; Corner++ )
+			{
+				ae::Vector3 Position( Corner & 1 ? m_MeshMax.X : m_MeshMin.X, Corner & 2 ? m_MeshMax.Y : m_MeshMin.Y, Corner & 4 ? m_MeshMax.Z : m_MeshMin.Z );
+
+				float WorldPosition[3];
+				for( Uint32 Row = 0; Row < 3; Row++ )
+					WorldPosition[Row] = Model( Row, 0 ) * Position.X + Model( Row, 1 ) * Position.Y + Model( Row, 2 ) * Position.Z + Model( Row, 3 );
+
+				m_InstancesMin = ae::Vector3( ae::Math::Min( m_InstancesMin.X, WorldPosition[0] ), ae::Math::Min( m_InstancesMin.Y, WorldPosition[1] ), ae::Math::Min( m_InstancesMin.Z, WorldPosition[2] ) );
+				m_InstancesMax = ae::Vector3( ae::Math::Max( m_InstancesMax.X, WorldPosition[0] ), ae::Math::Max( m_InstancesMax.Y, WorldPosition[1] ), ae::Math::Max( m_InstancesMax.Z, WorldPosition[2] ) );
+			}
+		}
+
+		m_AreBoundsDirty = False;
+	}
+
+	_Min = m_InstancesMin;
+	_Max = m_InstancesMax;
+
+	return True;
+}
+
+void InstancedDrawable::BindInstances( Uint32 _Divisor ) const
+{
+	if( m_IsBufferDirty )
+	{
+		size_t InstancesSize = m_Instances.size() * sizeof( InstanceAttributes );
+
+		// The buffer only grows, with headroom for the instances added later.
+		if( InstancesSize > m_InstancesBuffer.GetSize() )
+			m_InstancesBuffer.Resize( InstancesSize * 2 );
+
+		if( InstancesSize > 0 )
+			m_InstancesBuffer.SetData( m_Instances.data(), InstancesSize );
+
+		m_IsBufferDirty = False;
+	}
+
+	glVertexArrayBindingDivisor( m_VertexArrayObject, 4, ae::Math::Max( 1u, _Divisor ) );
+	AE_ErrorCheckOpenGLError();
+}
+
+void InstancedDrawable::SetupInstanceAttributes( Uint32 _VertexArray, Uint32 _Binding, Uint32 _Buffer )
+{
+	// Locations of StorePassVertex.glsl : the 4 columns of the model matrix, then the material index.
+	glVertexArrayVertexBuffer( _VertexArray, _Binding, _Buffer, 0, sizeof( InstanceAttributes ) );
+	glVertexArrayBindingDivisor( _VertexArray, _Binding, 1 );
+
+	for( GLuint Column = 0; Column < 4; Column++ )
+	{
+		glEnableVertexArrayAttrib( _VertexArray, 4 + Column );
+		glVertexArrayAttribFormat( _VertexArray, 4 + Column, 4, GL_FLOAT, GL_FALSE, Cast( GLuint, offsetof( InstanceAttributes, Model ) + Column * 4 * sizeof( float ) ) );
+		glVertexArrayAttribBinding( _VertexArray, 4 + Column, _Binding );
+	}
+
+	glEnableVertexArrayAttrib( _VertexArray, 8 );
+	glVertexArrayAttribIFormat( _VertexArray, 8, 1, GL_INT, offsetof( InstanceAttributes, MaterialIndex ) );
+	glVertexArrayAttribBinding( _VertexArray, 8, _Binding );
+	AE_ErrorCheckOpenGLError();
+}
+
+ae::Vertex3DArray InstancedDrawable::ReadVertices( const ae::Drawable& _Mesh )
+{
+	// Only the 3D vertices have a known layout.
+	if( _Mesh.GetVertexBufferObject() == 0 || _Mesh.GetAttributePointerTags() != AttributePointer::Default3D )
+		return ae::Vertex3DArray();
+
+	GLint64 BufferSize = 0;
+	glGetNamedBufferParameteri64v( _Mesh.GetVertexBufferObject(), GL_BUFFER_SIZE, &BufferSize );
+
+	ae::Vertex3DArray Vertices( Cast( size_t, BufferSize ) / sizeof( ae::Vertex3D ) );
+	if( !Vertices.empty() )
+		glGetNamedBufferSubData( _Mesh.GetVertexBufferObject(), 0, Cast( GLsizeiptr, Vertices.size() * sizeof( ae::Vertex3D ) ), Vertices.data() );
+
+	AE_ErrorCheckOpenGLError();
+
+	return Vertices;
+}
+
+InstancedDrawable::IndexArray InstancedDrawable::ReadIndices( const ae::Drawable& _Mesh )
+{
+	IndexArray Indices( _Mesh.GetElementsArrayObject() != 0 ? _Mesh.GetIndicesCount() : 0 );
+	if( !Indices.empty() )
+	{
+		glGetNamedBufferSubData( _Mesh.GetElementsArrayObject(), 0, Cast( GLsizeiptr, Indices.size() * sizeof( Uint32 ) ), Indices.data() );
+		AE_ErrorCheckOpenGLError();
+	}
+
+	return Indices;
+}
+
+void InstancedDrawable::OnInstancesChanged()
+{
+	m_InstancesVersion++;
+	m_AreBoundsDirty = True;
+	m_IsBufferDirty = True;
+}
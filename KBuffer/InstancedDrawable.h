@@ -0,0 +1,120 @@
+#pragma once
+
+#include "GPUBuffer.h"
+#include "StorePassMaterial.h"
+
+#include <API/Code/Graphics/Drawable/Drawable.h>
+#include <API/Code/Maths/Matrix/Matrix4x4.h>
+#include <API/Code/Maths/Vector/Vector3.h>
+
+#include <vector>
+
+/// <summary>
+/// Mesh drawn many times by a single draw of the K-Buffer store pass, each instance with its own transform and store pass material.<para/>
+/// The transforms and the material indices are per instance attributes in a GPU buffer, read by StorePassVertex.glsl for each instance of the draw.<para/>
+/// The instances are always stored as translucent fragments : the opaque pre-pass only draws the objects of a single material.
+/// </summary>
+class InstancedDrawable : public ae::Drawable
+{
+public:
+	/// <summary>Per instance attributes as read by the store pass vertex shader, for the instanced drawables and the batches of the K-Buffer.</summary>
+	struct InstanceAttributes
+	{
+		/// <summary>Data of the model matrix, read by the shader like the model uniform.</summary>
+		float Model[16];
+
+		/// <summary>Index of the material in the material table.</summary>
+		Int32 MaterialIndex;
+	};
+
+public:
+	/// <summary>Create an instanced drawable without instance from 3D vertices and triangles.</summary>
+	/// <param name="_Vertices">The vertices of the mesh.</param>
+	/// <param name="_Indices">The indices of the triangles of the mesh.</param>
+	InstancedDrawable( const ae::Vertex3DArray& _Vertices, const IndexArray& _Indices );
+
+	/// <summary>Create an instanced drawable without instance from the 3D vertices and the triangles of another drawable, read from its buffers.</summary>
+	/// <param name="_Mesh">The drawable to copy the mesh from.</param>
+	explicit InstancedDrawable( const ae::Drawable& _Mesh );
+
+	/// <summary>Add an instance of the mesh.</summary>
+	/// <param name="_Model">The transform of the instance.</param>
+	/// <param name="_Material">The material of the instance, it must stay alive while the instance uses it.</param>
+	/// <returns>The index of the new instance.</returns>
+	Uint32 AddInstance( const ae::Matrix4x4& _Model, const StorePassMaterial& _Material );
+
+	/// <summary>Change the transform and the material of an instance.</summary>
+	/// <param name="_Instance">The index of the instance.</param>
+	/// <param name="_Model">The new transform of the instance.</param>
+	/// <param name="_Material">The new material of the instance, it must stay alive while the instance uses it.</param>
+	void SetInstance( Uint32 _Instance, const ae::Matrix4x4& _Model, const StorePassMaterial& _Material );
+
+	/// <summary>Remove all the instances.</summary>
+	void ClearInstances();
+
+	/// <summary>Retrieve the number of instances.</summary>
+	/// <returns>The number of instances drawn by each draw.</returns>
+	Uint32 GetInstancesCount() const;
+
+	/// <summary>Retrieve the materials used by the instances, each material once.</summary>
+	/// <returns>The materials to put in the material table before the draw.</returns>
+	const std::vector<const StorePassMaterial*>& GetInstanceMaterials() const;
+
+	/// <summary>Retrieve the version of the instances, incremented by every change : the incremental frames compare it with the last frame.</summary>
+	/// <returns>The version of the instances.</returns>
+	Uint64 GetInstancesVersion() const;
+
+	/// <summary>Compute the bounds of all the instances in world space, from the bounds of the mesh transformed by each instance.</summary>
+	/// <param name="_Min">The minimum of the bounds.</param>
+	/// <param name="_Max">The maximum of the bounds.</param>
+	/// <returns>True if the bounds are known, False without instance or without vertex.</returns>
+	Bool GetInstancesBounds( AE_Out ae::Vector3& _Min, AE_Out ae::Vector3& _Max ) const;
+
+	/// <summary>Upload the changed instances and set how many instances of the draw use the attributes of each instance.</summary>
+	/// <param name="_Divisor">The number of consecutive instances of the draw reading the same instance, the number of views.</param>
+	void BindInstances( Uint32 _Divisor ) const;
+
+	/// <summary>Read the per instance attributes of a buffer in a vertex array, in the locations of StorePassVertex.glsl.</summary>
+	/// <param name="_VertexArray">The vertex array to setup.</param>
+	/// <param name="_Binding">The binding index of the buffer in the vertex array, not used by the other attributes.</param>
+	/// <param name="_Buffer">The buffer of the instance attributes.</param>
+	static void SetupInstanceAttributes( Uint32 _VertexArray, Uint32 _Binding, Uint32 _Buffer );
+
+private:
+	/// <summary>Read the vertices of a drawable of 3D vertices from its vertex buffer.</summary>
+	/// <param name="_Mesh">The drawable to read.</param>
+	/// <returns>The vertices of the drawable, empty if it has no 3D vertices.</returns>
+	static ae::Vertex3DArray ReadVertices( const ae::Drawable& _Mesh );
+
+	/// <summary>Read the indices of a drawable from its elements buffer.</summary>
+	/// <param name="_Mesh">The drawable to read.</param>
+	/// <returns>The indices of the drawable.</returns>
+	static IndexArray ReadIndices( const ae::Drawable& _Mesh );
+
+	/// <summary>Mark the instances as changed.</summary>
+	void OnInstancesChanged();
+
+private:
+	/// <summary>Attributes of each instance, copied in the GPU buffer by the next bind when they change.</summary>
+	std::vector<InstanceAttributes> m_Instances;
+
+	/// <summary>Materials used by the instances, each material once.</summary>
+	std::vector<const StorePassMaterial*> m_InstanceMaterials;
+
+	/// <summary>Bounds of the vertices of the mesh in its local space.</summary>
+	ae::Vector3 m_MeshMin;
+	ae::Vector3 m_MeshMax;
+	Bool m_HasVertices;
+
+	/// <summary>Version of the instances, incremented by every change.</summary>
+	Uint64 m_InstancesVersion;
+
+	/// <summary>Bounds of all the instances in world space, computed on demand when the instances change.</summary>
+	mutable ae::Vector3 m_InstancesMin;
+	mutable ae::Vector3 m_InstancesMax;
+	mutable Bool m_AreBoundsDirty;
+
+	/// <summary>GPU copy of the instance attributes, uploaded on demand by the bind when the instances change.</summary>
+	mutable GPUBuffer m_InstancesBuffer;
+	mutable Bool m_IsBufferDirty;
+};
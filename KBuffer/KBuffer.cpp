@@ -1,24 +1,130 @@
 #include "KBuffer.h"
 
 #include "KBufferToEditor.h"
+#include "StorePassMaterial.h"
+#include "InstancedDrawable.h"
 
 #include <API/Code/Graphics/Drawable/Drawable.h>
+#include <API/Code/Graphics/Drawable/TransformableDrawable3D.h>
 #include <API/Code/Graphics/Camera/Camera.h>
 #include <API/Code/Aero/Aero.h>
 #include <API/Code/Debugging/Debugging.h>
 
+#include <algorithm>
+#include <cmath>
+
+// Directory of the K-Buffer shaders, relatively to the working directory.
+static const std::string KBufferShadersDirectory = "../../../Data/KBuffer/Shaders/";
+
+// Counters of the store pass statistics, see StatisticsCommon.glsl : each statistic is spread over the 64 pixels of a 8x8 block.
+static const size_t StatisticsCount = 5;
+static const size_t StatisticCountersCount = 64;
+static const size_t StatisticsSize = StatisticsCount * StatisticCountersCount * sizeof( Uint32 );
+
+// Bins of the depth complexity histogram, see DepthComplexityCompute.glsl.
+static const size_t DepthComplexityBinsCount = 64;
+
+// Tiles of 8x8 pixels of the tiled addressing and pages of the tile-sparse storage, see KBufferAddressing.glsl and FragmentsBufferCommon.glsl.
+static const Uint32 TileSize = 8;
+static const size_t TilePixelsCount = TileSize * TileSize;
+static const Uint32 NoTilePage = 0xFFFFFFFF;
+static const Uint32 PagesShrinkFramesCount = 120;
+
+// Views side by side in the K-Buffer, see StorePassVertex.glsl and ResolvePassCommon.glsl.
+static const size_t MaxViewsCount = 4;
+
+// The fragment records keep 8 bits of the material index, see PackMaterialAndFacing in FragmentsBufferCommon.glsl.
+static const size_t MaxStorePassMaterialsCount = 256;
+
 
 KBuffer::KBuffer( Uint32 _Width, Uint32 _Height, Uint32 _K ) :
-	ae::Framebuffer( _Width, _Height, AttachementPreset::Depth_Float ),
+	ae::Framebuffer( _Width, _Height, { ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Color_0, ae::TexturePixelFormat::RGBA_F16, ae::TextureFilterMode::Nearest ),
+										ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Depth, ae::TexturePixelFormat::Depth_F32, ae::TextureFilterMode::Nearest ) } ),
+	m_OutputWidth( _Width ),
+	m_OutputHeight( _Height ),
+	m_ResolutionDivisor( 1 ),
+	m_Views(),
+	m_RenderWidth( _Width ),
+	m_RenderHeight( _Height ),
 	m_K( ae::Math::Clamp( 1u, 16u, _K ) ),
-	m_StorePassShader( "../../../Data/KBuffer/Shaders/StorePassVertex.glsl", "../../../Data/KBuffer/Shaders/StorePassFragment.glsl" ),
-	m_ResolvePassShader( "../../../Data/KBuffer/Shaders/ResolvePassVertex.glsl", "../../../Data/KBuffer/Shaders/ResolvePassFragment.glsl" ),
-	m_Semaphores( _Width, _Height, ae::TexturePixelFormat::Red_U32_NOTNORM ),
-	m_Counts( _Width, _Height, ae::TexturePixelFormat::Red_U8 ),
-	m_MaterialIndices( _Width, _Height, m_K, ae::TexturePixelFormat::Red_U8 ),
+	m_KCapacity( m_K ),
+	m_InsertionMode( InsertionMode::Locked ),
+	m_TransparencyTechnique( TransparencyTechnique::KBuffer ),
+	m_UseInterlock( IsInterlockSupported() ),
+	m_UseMaxHeap( False ),
+	m_StorageLayout( StorageLayout::LayerMajorImages ),
+	m_UseTiledAddressing( False ),
+	m_IsTileSparse( False ),
+	m_PagesCapacity( 0 ),
+	m_UsedPagesCount( 0 ),
+	m_UnderusedPagesFramesCount( 0 ),
+	m_UnderusedPagesPeak( 0 ),
+	m_LastUsedPagesCount( 0 ),
+	m_IsGenerationTagged( True ),
+	m_Generation( 0 ),
+	m_LastClearSize( 0 ),
+	m_UseOpaquePrePass( True ),
+	m_UseScissor( True ),
+	m_DirtyRect( { 0, 0, _Width, _Height } ),
+	m_IsIncremental( False ),
+	m_IsFrameRecorded( False ),
+	m_RecordedBatchesCount( 0 ),
+	m_LastIncrementalSettings(),
+	m_IsResolvedImageValid( False ),
+	m_LastUpdatedPixelsCount( 0 ),
+	m_UseOverflowTail( False ),
+	m_ResolveMode( ResolveMode::FragmentShader ),
+	m_IsShaderSpecialized( True ),
+	m_FragmentPoolCapacity( _Width * _Height * 4 ),
+	m_PoolOverflowPolicy( PoolOverflowPolicy::Grow ),
+	m_LastAllocatedFragmentsCount( 0 ),
+	m_IsKAdaptive( False ),
+	m_FrameTimeBudget( 2.0f ),
+	m_IsProfiled( False ),
+	m_LastFrameStatistics(),
+	m_IsFrameProfiled( False ),
+	m_DebugView( DebugView::None ),
+	m_IsOccupancyRecorded( False ),
+	m_HeatmapMaxValue( 16.0f ),
+	m_DepthComplexityHistogram( DepthComplexityBinsCount, 0 ),
+	m_OpaquePassShader( KBufferShadersDirectory + "StorePassVertex.glsl", KBufferShadersDirectory + "OpaquePassFragment.glsl" ),
+	m_Semaphores( m_UseInterlock ? 1 : _Width, m_UseInterlock ? 1 : _Height, ae::TexturePixelFormat::Red_U32_NOTNORM ),
+	m_Counts( _Width, _Height, ae::TexturePixelFormat::Red_U32_NOTNORM ),
+	m_DroppedCounts( 1, 1, ae::TexturePixelFormat::Red_U32_NOTNORM ),
+	m_SpinCounts( 1, 1, ae::TexturePixelFormat::Red_U32_NOTNORM ),
+	m_MaterialIndices( _Width, _Height, m_K, ae::TexturePixelFormat::Red_U16_NOTNORM ),
 	m_Depths( _Width, _Height, m_K, ae::TexturePixelFormat::Red_F32 ),
-	m_Positions( _Width, _Height, m_K, ae::TexturePixelFormat::RGBA_F16 ),
-	m_Materials( 1, 3, ae::TexturePixelFormat::RGBA_F16 ),
+	m_BlendedAccumulations( 1, 1, ae::TexturePixelFormat::RGBA_F16 ),
+	m_BlendedRevealages( 1, 1, ae::TexturePixelFormat::Red_F32 ),
+	m_PowerMoments( 1, 1, ae::TexturePixelFormat::RGBA_F32 ),
+	m_MaterialTable( 1 ),
+	m_Materials( sizeof( MaterialTableEntry ) ),
+	m_AreMaterialsDirty( True ),
+	m_IsMaterialsLimitWarned( False ),
+	m_PackedFragments( 0 ),
+	m_Fragments( 0 ),
+	m_TilePages( 0 ),
+	m_TilePagesTable(),
+	m_ListHeads( 0 ),
+	m_FragmentPool( 0 ),
+	m_CountedOffsets( 0 ),
+	m_BlockSums( 0 ),
+	m_BatchVertices( 0 ),
+	m_BatchIndices( 0 ),
+	m_BatchVerticesCount( 0 ),
+	m_BatchIndicesCount( 0 ),
+	m_BatchInstances( 0 ),
+	m_BatchCommands( 0 ),
+	m_BatchVertexArray( 0 ),
+	m_DifferenceSums( 0 ),
+	m_AllocatedCountReadback( sizeof( Uint32 ) ),
+	m_AllocatedCountFence( nullptr ),
+	m_Statistics( StatisticsSize ),
+	m_NextProfiledFrame( 0 ),
+	m_DepthComplexityBins( DepthComplexityBinsCount * sizeof( Uint32 ) ),
+	m_DepthComplexityReadback( DepthComplexityBinsCount * sizeof( Uint32 ) ),
+	m_DepthComplexityFence( nullptr ),
+	m_ResolveTiles( 0 ),
 	m_FullscreenSprite( *this ),
 
 	m_IsToneMapped( False ),
@@ -34,6 +140,14 @@ KBuffer::KBuffer( Uint32 _Width, Uint32 _Height, Uint32 _K ) :
 	m_Counts.SetFilterMode( ae::TextureFilterMode::Nearest );
 	m_Counts.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
 
+	m_DroppedCounts.SetName( "K-Buffer Dropped Counts Image" );
+	m_DroppedCounts.SetFilterMode( ae::TextureFilterMode::Nearest );
+	m_DroppedCounts.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
+
+	m_SpinCounts.SetName( "K-Buffer Spin Counts Image" );
+	m_SpinCounts.SetFilterMode( ae::TextureFilterMode::Nearest );
+	m_SpinCounts.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
+
 	m_MaterialIndices.SetName( "K-Buffer Material Indices Image" );
 	m_MaterialIndices.SetFilterMode( ae::TextureFilterMode::Nearest );
 	m_MaterialIndices.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
@@ -42,22 +156,97 @@ KBuffer::KBuffer( Uint32 _Width, Uint32 _Height, Uint32 _K ) :
 	m_Depths.SetFilterMode( ae::TextureFilterMode::Nearest );
 	m_Depths.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
 
-	m_Positions.SetName( "K-Buffer Positions Image" );
-	m_Positions.SetFilterMode( ae::TextureFilterMode::Nearest );
-	m_Positions.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
-
-	m_Materials.SetName( "K-Buffer Materials Image" );
-	m_Materials.SetFilterMode( ae::TextureFilterMode::Nearest );
-	m_Materials.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
+	m_Materials.SetName( "K-Buffer Materials Buffer" );
+
+	m_PackedFragments.SetName( "K-Buffer Packed Fragments Buffer" );
+	m_Fragments.SetName( "K-Buffer Fragments Buffer" );
+	m_TilePages.SetName( "K-Buffer Tile Pages Buffer" );
+	m_ListHeads.SetName( "K-Buffer List Heads Buffer" );
+	m_FragmentPool.SetName( "K-Buffer Fragment Pool Buffer" );
+	m_CountedOffsets.SetName( "K-Buffer Counted Offsets Buffer" );
+	m_BlockSums.SetName( "K-Buffer Block Sums Buffer" );
+	m_BatchVertices.SetName( "K-Buffer Batch Vertices Buffer" );
+	m_BatchIndices.SetName( "K-Buffer Batch Indices Buffer" );
+	m_BatchInstances.SetName( "K-Buffer Batch Instances Buffer" );
+	m_BatchCommands.SetName( "K-Buffer Batch Commands Buffer" );
+	m_DifferenceSums.SetName( "K-Buffer Difference Sums Buffer" );
+	m_AllocatedCountReadback.SetName( "K-Buffer Allocated Count Readback Buffer" );
+	m_Statistics.SetName( "K-Buffer Statistics Buffer" );
+	m_DepthComplexityBins.SetName( "K-Buffer Depth Complexity Bins Buffer" );
+	m_DepthComplexityReadback.SetName( "K-Buffer Depth Complexity Readback Buffer" );
+	m_ResolveTiles.SetName( "K-Buffer Resolve Tiles Buffer" );
 
 	m_FullscreenSprite.SetName( "K-Buffer Fullscreen Quad" );
 
+	ae::Texture* ColorTexture = GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 );
+	if( ColorTexture != nullptr )
+		ColorTexture->SetName( "K-Buffer Opaque Color Attachement" );
+
+	m_BlendedAccumulations.SetName( "K-Buffer Blended Accumulations Attachement" );
+	m_BlendedAccumulations.SetFilterMode( ae::TextureFilterMode::Nearest );
+	m_BlendedAccumulations.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
+
+	m_BlendedRevealages.SetName( "K-Buffer Blended Revealages Attachement" );
+	m_BlendedRevealages.SetFilterMode( ae::TextureFilterMode::Nearest );
+	m_BlendedRevealages.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
+
+	m_PowerMoments.SetName( "K-Buffer Power Moments Attachement" );
+	m_PowerMoments.SetFilterMode( ae::TextureFilterMode::Nearest );
+	m_PowerMoments.SetWrapMode( ae::TextureWrapMode::ClampToEdge );
+
 	ae::Texture* DepthTexture = GetAttachementTexture( ae::FramebufferAttachement::Type::Depth );
 	if( DepthTexture != nullptr )
 		DepthTexture->SetName( "K-Buffer Depth Attachement" );
 
-	m_StorePassShader.SetName( "K-Buffer Store Pass Shader" );
-	m_ResolvePassShader.SetName( "K-Buffer Resolve Pass Shader" );
+	m_OpaquePassShader.SetName( "K-Buffer Opaque Pass Shader" );
+
+	// Batches : the positions come from the arena, the transform and the material index from the instance of the draw command (its base instance).
+	// The buffers keep their ID when they are reallocated, the vertex array is set once.
+	glCreateVertexArrays( 1, &m_BatchVertexArray );
+	glObjectLabel( GL_VERTEX_ARRAY, m_BatchVertexArray, -1, "K-Buffer Batch Vertex Array" );
+
+	glVertexArrayVertexBuffer( m_BatchVertexArray, 0, m_BatchVertices.GetBufferID(), 0, sizeof( ae::Vertex3D ) );
+	glEnableVertexArrayAttrib( m_BatchVertexArray, 0 );
+	glVertexArrayAttribFormat( m_BatchVertexArray, 0, 3, GL_FLOAT, GL_FALSE, offsetof( ae::Vertex3D, Position ) );
+	glVertexArrayAttribBinding( m_BatchVertexArray, 0, 0 );
+
+	InstancedDrawable::SetupInstanceAttributes( m_BatchVertexArray, 1, m_BatchInstances.GetBufferID() );
+
+	glVertexArrayElementBuffer( m_BatchVertexArray, m_BatchIndices.GetBufferID() );
+	AE_ErrorCheckOpenGLError();
+
+	for( ProfiledFrame& Frame : m_ProfiledFrames )
+	{
+		Frame.TimeStampsCount = 0;
+		Frame.StatisticsReadback.Resize( StatisticsSize );
+		Frame.StatisticsReadback.SetName( "K-Buffer Statistics Readback Buffer" );
+		Frame.Fence = nullptr;
+		Frame.K = 0;
+	}
+}
+
+KBuffer::~KBuffer()
+{
+	if( m_AllocatedCountFence != nullptr )
+		glDeleteSync( m_AllocatedCountFence );
+
+	if( m_DepthComplexityFence != nullptr )
+		glDeleteSync( m_DepthComplexityFence );
+
+	if( m_BatchVertexArray != 0 )
+		glDeleteVertexArrays( 1, &m_BatchVertexArray );
+
+	for( auto& Bounds : m_LocalBounds )
+		ReleaseBoundsReadback( Bounds.second );
+
+	for( ProfiledFrame& Frame : m_ProfiledFrames )
+	{
+		if( Frame.Fence != nullptr )
+			glDeleteSync( Frame.Fence );
+
+		if( !Frame.Queries.empty() )
+			glDeleteQueries( Cast( GLsizei, Frame.Queries.size() ), Frame.Queries.data() );
+	}
 }
 
 Uint32 KBuffer::GetK() const
@@ -73,230 +262,3152 @@ void KBuffer::SetK( Uint32 _K )
 
 	m_K = NewK;
 
-	m_MaterialIndices.Resize( GetWidth(), GetHeight(), m_K );
-	m_Depths.Resize( GetWidth(), GetHeight(), m_K );
-	m_Positions.Resize( GetWidth(), GetHeight(), m_K );
+	if( m_K > m_KCapacity )
+	{
+		m_KCapacity = m_K;
+		UpdateStorage();
+	}
+
+	// The fragments of the pixel-major buffer and of the lock free slots are addressed with K : the storage must be fully cleared before the next frame.
+	m_Generation = 0;
 }
 
-Bool KBuffer::IsToneMapped() const
+Uint32 KBuffer::GetKCapacity() const
 {
-	return m_IsToneMapped;
+	return m_KCapacity;
 }
 
-void KBuffer::SetIsToneMapped( Bool _IsToneMapped )
+void KBuffer::SetKCapacity( Uint32 _Capacity )
 {
-	m_IsToneMapped = _IsToneMapped;
+	Uint32 NewCapacity = ae::Math::Clamp( 1u, 16u, _Capacity );
+	if( m_KCapacity == NewCapacity )
+		return;
+
+	m_KCapacity = NewCapacity;
+	m_K = ae::Math::Min( m_K, m_KCapacity );
+
+	UpdateStorage();
 }
 
-float KBuffer::GetExposure() const
+Bool KBuffer::IsKAdaptive() const
 {
-	return m_Exposure;
+	return m_IsKAdaptive;
 }
 
-void KBuffer::SetExposure( float _Exposure )
+void KBuffer::SetIsKAdaptive( Bool _IsKAdaptive )
 {
-	m_Exposure = ae::Math::Max( _Exposure, 0.0f );
+	m_IsKAdaptive = _IsKAdaptive;
 }
 
-Bool KBuffer::IsGammaCorrected() const
+float KBuffer::GetFrameTimeBudget() const
 {
-	return m_IsGammaCorrected;
+	return m_FrameTimeBudget;
 }
 
-void KBuffer::SetIsGammaCorrected( Bool _IsGammaCorrected )
+void KBuffer::SetFrameTimeBudget( float _Budget )
 {
-	m_IsGammaCorrected = _IsGammaCorrected;
+	m_FrameTimeBudget = ae::Math::Max( _Budget, 0.0f );
 }
 
-float KBuffer::GetGamma() const
+KBuffer::InsertionMode KBuffer::GetInsertionMode() const
 {
-	return m_Gamma;
+	return m_InsertionMode;
 }
 
-void KBuffer::SetGamma( float _Gamma )
+void KBuffer::SetInsertionMode( InsertionMode _Mode )
 {
-	m_Gamma = ae::Math::Max( _Gamma, ae::Math::Epsilon() );
+	if( m_InsertionMode == _Mode )
+		return;
+
+	if( _Mode == InsertionMode::LockFree && !IsLockFreeSupported() )
+	{
+		AE_LogWarning( "64 bits atomic operations are not supported, the K-Buffer keeps the locked insertion." );
+		return;
+	}
+
+	m_InsertionMode = _Mode;
+
+	UpdateStorage();
 }
 
-void KBuffer::SetStorePassMaterialCount( Int32 _Count )
+Bool KBuffer::IsLockFreeSupported()
 {
-	Uint32 NewMaterialCount = Cast( Uint32, ae::Math::Max( 1, _Count ) );
+	return GLEW_ARB_gpu_shader_int64 && GLEW_NV_shader_atomic_int64;
+}
 
-	if( m_Materials.GetWidth() == NewMaterialCount )
-		return;
+KBuffer::TransparencyTechnique KBuffer::GetTransparencyTechnique() const
+{
+	return m_TransparencyTechnique;
+}
+
+void KBuffer::SetTransparencyTechnique( TransparencyTechnique _Technique )
+{
+	m_TransparencyTechnique = _Technique;
 
-	m_Materials.Resize( NewMaterialCount, 3 );
+	UpdateBlendedTargets();
+
+	// The targets of the new technique may have been written out of the dirty rectangle while they were not cleared.
+	m_DirtyRect = GetFullRect();
 }
 
-void KBuffer::Resize( Uint32 _Width, Uint32 _Height )
+Uint32 KBuffer::GetFragmentPoolCapacity() const
+{
+	return m_FragmentPoolCapacity;
+}
+
+void KBuffer::SetFragmentPoolCapacity( Uint32 _Capacity )
 {
-	if( GetWidth() == _Width && GetHeight() == _Height )
+	Uint32 NewCapacity = ae::Math::Max( 1u, _Capacity );
+	if( m_FragmentPoolCapacity == NewCapacity )
 		return;
 
-	ae::Framebuffer::Resize( _Width, _Height );
+	m_FragmentPoolCapacity = NewCapacity;
 
-	m_Semaphores.Resize( _Width, _Height );
-	m_Counts.Resize( _Width, _Height );
-	m_MaterialIndices.Resize( _Width, _Height, m_K );
-	m_Depths.Resize( _Width, _Height, m_K );
-	m_Positions.Resize( _Width, _Height, m_K );
+	UpdateStorage();
 }
 
+KBuffer::PoolOverflowPolicy KBuffer::GetPoolOverflowPolicy() const
+{
+	return m_PoolOverflowPolicy;
+}
 
-void KBuffer::ClearPass()
+void KBuffer::SetPoolOverflowPolicy( PoolOverflowPolicy _Policy )
 {
-	glClearTexSubImage( m_Semaphores.GetTextureID(), 0, 0, 0, 0, m_Semaphores.GetWidth(), m_Semaphores.GetHeight(), 1, 
-						ae::ToGLFormat( m_Semaphores.GetFormat() ), ae::ToGLType( m_Semaphores.GetFormat() ), nullptr );
-	AE_ErrorCheckOpenGLError();
+	m_PoolOverflowPolicy = _Policy;
+}
 
+Uint32 KBuffer::GetLastAllocatedFragmentsCount() const
+{
+	return m_LastAllocatedFragmentsCount;
+}
 
-	glClearTexSubImage( m_Counts.GetTextureID(), 0, 0, 0, 0, m_Counts.GetWidth(), m_Counts.GetHeight(), 1,
-						ae::ToGLFormat( m_Counts.GetFormat() ), ae::ToGLType( m_Counts.GetFormat() ), nullptr );
-	AE_ErrorCheckOpenGLError();
+KBuffer::StorageLayout KBuffer::GetStorageLayout() const
+{
+	return m_StorageLayout;
+}
 
+void KBuffer::SetStorageLayout( StorageLayout _Layout )
+{
+	if( m_StorageLayout == _Layout )
+		return;
 
-	glClearTexSubImage( m_MaterialIndices.GetTextureID(), 0, 0, 0, 0, m_MaterialIndices.GetWidth(), m_MaterialIndices.GetHeight(), m_MaterialIndices.GetDepth(),
-						ae::ToGLFormat( m_MaterialIndices.GetFormat() ), ae::ToGLType( m_MaterialIndices.GetFormat() ), nullptr );
-	AE_ErrorCheckOpenGLError();
+	m_StorageLayout = _Layout;
 
+	UpdateStorage();
+}
 
-	float DepthClear = 1.0f;
-	glClearTexSubImage( m_Depths.GetTextureID(), 0, 0, 0, 0, m_Depths.GetWidth(), m_Depths.GetHeight(), m_Depths.GetDepth(),
-						ae::ToGLFormat( m_Depths.GetFormat() ), ae::ToGLType( m_Depths.GetFormat() ),  &DepthClear );
-	AE_ErrorCheckOpenGLError();
+Bool KBuffer::IsTiledAddressingUsed() const
+{
+	return m_UseTiledAddressing;
+}
 
+void KBuffer::SetUseTiledAddressing( Bool _UseTiledAddressing )
+{
+	if( m_UseTiledAddressing == _UseTiledAddressing )
+		return;
 
-	glClearTexSubImage( m_Positions.GetTextureID(), 0, 0, 0, 0, m_Positions.GetWidth(), m_Positions.GetHeight(), m_Positions.GetDepth(),
-						ae::ToGLFormat( m_Positions.GetFormat() ), ae::ToGLType( m_Positions.GetFormat() ), nullptr );
-	AE_ErrorCheckOpenGLError();
+	m_UseTiledAddressing = _UseTiledAddressing;
 
+	UpdateStorage();
+}
 
-	glClearTexSubImage( m_Materials.GetTextureID(), 0, 0, 0, 0, m_Materials.GetWidth(), m_Materials.GetDepth(), 1,
-						ae::ToGLFormat( m_Materials.GetFormat() ), ae::ToGLType( m_Materials.GetFormat() ), nullptr );
-	AE_ErrorCheckOpenGLError();
+Bool KBuffer::IsTileSparse() const
+{
+	return m_IsTileSparse;
+}
 
+void KBuffer::SetIsTileSparse( Bool _IsTileSparse )
+{
+	if( m_IsTileSparse == _IsTileSparse )
+		return;
 
-	glClear( GL_DEPTH_BUFFER_BIT );
-	AE_ErrorCheckOpenGLError();
+	m_IsTileSparse = _IsTileSparse;
 
-	// Be sure the textures are ready before starting store pass.
-	glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT );
-	AE_ErrorCheckOpenGLError();
+	UpdateStorage();
 }
 
-void KBuffer::Draw( const ae::Drawable& _Object, ae::Camera* _Camera )
+Uint32 KBuffer::GetLastUsedPagesCount() const
 {
-	if( !_Object.IsEnabled() )
+	return m_LastUsedPagesCount;
+}
+
+Uint32 KBuffer::GetPagesCapacity() const
+{
+	return IsTileSparseActive() ? m_PagesCapacity : 0;
+}
+
+Bool KBuffer::IsGenerationTagged() const
+{
+	return m_IsGenerationTagged;
+}
+
+void KBuffer::SetIsGenerationTagged( Bool _IsGenerationTagged )
+{
+	if( m_IsGenerationTagged == _IsGenerationTagged )
 		return;
 
-	if( !CheckCountPrimitive( _Object.GetIndicesCount(), _Object.GetPrimitiveType() ) )
+	m_IsGenerationTagged = _IsGenerationTagged;
+
+	// The counts are read differently : every pixel must be cleared and resolved again.
+	// The clears of the untagged frames are scissored to the dirty rectangle : the counts tagged by older frames out of it would read as valid again,
+	// the whole storage is cleared before the next frame like when K changes.
+	m_Generation = 0;
+	m_DirtyRect = GetFullRect();
+}
+
+Bool KBuffer::IsOverflowTailUsed() const
+{
+	return m_UseOverflowTail;
+}
+
+void KBuffer::SetUseOverflowTail( Bool _UseOverflowTail )
+{
+	m_UseOverflowTail = _UseOverflowTail;
+
+	UpdateBlendedTargets();
+
+	// The blended targets may have been written out of the dirty rectangle while they were not cleared.
+	m_DirtyRect = GetFullRect();
+}
+
+size_t KBuffer::GetStorageSize() const
+{
+	// Everything allocated, used or not by the current technique : the storage of the K-Buffer is kept while a cheaper technique is used.
+	// Bytes per texel of the opaque color (rgba16f) and of the depth (r32f) of the K-Buffer.
+	size_t TargetsSize = Cast( size_t, GetWidth() ) * GetHeight() * ( 8 + 4 );
+
+	// Accumulations (rgba16f), revealages (r32f) and power moments (rgba32f) of the blended targets, only allocated for the techniques blending them.
+	TargetsSize += Cast( size_t, m_BlendedAccumulations.GetWidth() ) * m_BlendedAccumulations.GetHeight() * 8;
+	TargetsSize += Cast( size_t, m_BlendedRevealages.GetWidth() ) * m_BlendedRevealages.GetHeight() * 4;
+	TargetsSize += Cast( size_t, m_PowerMoments.GetWidth() ) * m_PowerMoments.GetHeight() * 16;
+
+	// Bytes per texel of the semaphores (r32ui), counts with generation (r32ui), material indices with facing flag (r16ui) and depths (r32f).
+	size_t ImagesSize = Cast( size_t, m_Semaphores.GetWidth() ) * m_Semaphores.GetHeight() * 4;
+	ImagesSize += Cast( size_t, m_Counts.GetWidth() ) * m_Counts.GetHeight() * 4;
+	ImagesSize += Cast( size_t, m_Depths.GetWidth() ) * m_Depths.GetHeight() * m_Depths.GetDepth() * ( 2 + 4 );
+
+	size_t BuffersSize = m_PackedFragments.GetSize() + m_Fragments.GetSize() + m_TilePages.GetSize() + m_ListHeads.GetSize() + m_FragmentPool.GetSize() + m_CountedOffsets.GetSize() + m_BlockSums.GetSize();
+
+	return TargetsSize + ImagesSize + BuffersSize;
+}
+
+size_t KBuffer::GetLastClearSize() const
+{
+	return m_LastClearSize;
+}
+
+KBuffer::PassesTraffic KBuffer::EstimatePassesTraffic( const FrameStatistics& _Statistics ) const
+{
+	PassesTraffic Traffic = { 0, 0, 0, 0 };
+	if( m_TransparencyTechnique != TransparencyTechnique::KBuffer )
+		return Traffic;
+
+	// Bytes of the header of a pixel and of a fragment record, see GetStorageSize.
+	size_t HeaderSize = 4;
+	size_t RecordSize = 8;
+	if( m_InsertionMode == InsertionMode::Locked )
 	{
-		AE_LogWarning( "Count of indices do not fit with the primitive. Object will not be drawn." );
-		return;
+		// The count, and the semaphore without the interlock. A record of the images is a depth (r32f) and a material index (r16ui).
+		HeaderSize = m_UseInterlock ? 4 : 8;
+		RecordSize = m_StorageLayout == StorageLayout::LayerMajorImages ? 2 + 4 : 8;
 	}
+	else if( m_InsertionMode == InsertionMode::LockFree )
+		HeaderSize = 0;
+	else if( m_InsertionMode == InsertionMode::LinkedList )
+		RecordSize = 12;
 
+	size_t PixelsCount = Cast( size_t, m_RenderWidth ) * m_RenderHeight;
+	size_t DroppedFragments = Cast( size_t, _Statistics.CulledFragments ) + _Statistics.RejectedFragments;
+	size_t ResidentFragments = _Statistics.StoredFragments - ae::Math::Min( _Statistics.EvictedFragments, _Statistics.StoredFragments );
 
-	if( _Camera == nullptr && !Aero.HasCamera() )
-	{
-		AE_LogWarning( "No valid camera to use for rendering. Object will not be drawn." );
+	Traffic.StoreReadSize = ( _Statistics.StoredFragments + DroppedFragments ) * HeaderSize + ( DroppedFragments + _Statistics.EvictedFragments ) * RecordSize + Cast( size_t, _Statistics.SpinIterations ) * 4;
+	Traffic.StoreWrittenSize = Cast( size_t, _Statistics.StoredFragments ) * ( HeaderSize + RecordSize );
+
+	// The lock free slots have no count : the resolve reads the K slots of every pixel.
+	Traffic.ResolveReadSize = m_InsertionMode == InsertionMode::LockFree ? PixelsCount * m_K * RecordSize : PixelsCount * HeaderSize + ResidentFragments * RecordSize;
+	Traffic.ResolveWrittenSize = PixelsCount * 4;
+
+	return Traffic;
+}
+
+Bool KBuffer::IsInterlockUsed() const
+{
+	return m_UseInterlock;
+}
+
+void KBuffer::SetUseInterlock( Bool _UseInterlock )
+{
+	Bool UseInterlock = _UseInterlock && IsInterlockSupported();
+	if( m_UseInterlock == UseInterlock )
 		return;
-	}
 
-	ae::Camera& CurrentCamera = _Camera != nullptr ? *_Camera : Aero.GetCamera();
+	m_UseInterlock = UseInterlock;
 
-	const ae::Material& ObjectMaterial = _Object.GetMaterial();
+	UpdateStorage();
+}
 
-	// Call user event.
-	_Object.OnDrawBegin( *this );
+Bool KBuffer::IsInterlockSupported()
+{
+	return GLEW_ARB_fragment_shader_interlock;
+}
 
-	// Use the store pass shader to store the K nearest fragment into the 3D textures..
-	m_StorePassShader.Bind();
+Bool KBuffer::IsMaxHeapUsed() const
+{
+	return m_UseMaxHeap;
+}
 
-	// Apply the camera settings.
-	CurrentCamera.SendToShader( m_StorePassShader );
+void KBuffer::SetUseMaxHeap( Bool _UseMaxHeap )
+{
+	m_UseMaxHeap = _UseMaxHeap;
+}
 
-	// Attach the K-Buffer textures.
-	m_Semaphores.BindAsImage( 0 );
-	m_Counts.BindAsImage( 1 );
-	m_MaterialIndices.BindAsImage( 2 );
-	m_Depths.BindAsImage( 3 );
-	m_Materials.BindAsImage( 4 );
-	m_Positions.BindAsImage( 5 );
+Bool KBuffer::IsOpaquePrePassUsed() const
+{
+	return m_UseOpaquePrePass;
+}
 
-	// Send K value to the shader.
-	m_StorePassShader.SetInt( m_StorePassShader.GetUniformLocation( "K" ), Cast( Int32, m_K ) );
+void KBuffer::SetUseOpaquePrePass( Bool _UseOpaquePrePass )
+{
+	m_UseOpaquePrePass = _UseOpaquePrePass;
 
-	// Attach the material shader to OpenGL and send its parameters.
-	Uint32 TextureUnit = 0;
-	Uint32 ImageUnit = 7;
-	ObjectMaterial.SendParametersToShader( m_StorePassShader, TextureUnit, ImageUnit );
+	// The opaque color may have been written out of the dirty rectangle while it was not cleared.
+	m_DirtyRect = GetFullRect();
+}
 
-	// Send object transform if there is.
-	_Object.SendTransformToShader( m_StorePassShader );
+Bool KBuffer::IsScissorUsed() const
+{
+	return m_UseScissor;
+}
 
-	
-	// Draw the object with the bound shader.
-	DrawVertexArray( _Object, _Object.GetPrimitiveType() );
+void KBuffer::SetUseScissor( Bool _UseScissor )
+{
+	m_UseScissor = _UseScissor;
+}
 
+Bool KBuffer::IsIncremental() const
+{
+	return m_IsIncremental;
+}
 
-	// Clear the shader from OpenGL.
-	m_StorePassShader.Unbind();
+void KBuffer::SetIsIncremental( Bool _IsIncremental )
+{
+	m_IsIncremental = _IsIncremental;
 
+	// The storage out of the updated rectangles still holds the fragments of the previous frames.
+	m_DirtyRect = GetFullRect();
+	m_IsResolvedImageValid = False;
+}
 
-	// Call user event.
-	_Object.OnDrawEnd( *this );
+Uint32 KBuffer::GetLastUpdatedPixelsCount() const
+{
+	return m_LastUpdatedPixelsCount;
 }
 
-void KBuffer::Resolve( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera* _Camera )
+KBuffer::ResolveMode KBuffer::GetResolveMode() const
 {
-	if( _Camera == nullptr && !Aero.HasCamera() )
-	{
-		AE_LogWarning( "No valid camera to use for clear pass." );
-		return;
-	}
+	return m_ResolveMode;
+}
 
-	// Be sure the store pass is finished before start the resolve pass.
-	glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT );
-	AE_ErrorCheckOpenGLError();
+void KBuffer::SetResolveMode( ResolveMode _Mode )
+{
+	m_ResolveMode = _Mode;
+}
 
-	_Target.Bind();
+Bool KBuffer::IsShaderSpecialized() const
+{
+	return m_IsShaderSpecialized;
+}
 
-	if( _ClearTarget )
-		_Target.Clear( _BackgroundColor );
+void KBuffer::SetIsShaderSpecialized( Bool _IsShaderSpecialized )
+{
+	m_IsShaderSpecialized = _IsShaderSpecialized;
+}
 
-	// Sort the fragment and process the final color the pixel.
-	m_ResolvePassShader.Bind();
+Bool KBuffer::IsProfiled() const
+{
+	return m_IsProfiled;
+}
 
-	// Apply the camera settings.
-	ae::Camera& CurrentCamera = _Camera != nullptr ? *_Camera : Aero.GetCamera();
-	CurrentCamera.SendToShader( m_ResolvePassShader );
+void KBuffer::SetIsProfiled( Bool _IsProfiled )
+{
+	m_IsProfiled = _IsProfiled;
+}
 
-	// Attach the K-Buffer textures.
-	m_Semaphores.BindAsImage( 0, ae::TextureImageBindMode::ReadOnly );
-	m_Counts.BindAsImage( 1, ae::TextureImageBindMode::ReadOnly );
-	m_MaterialIndices.BindAsImage( 2, ae::TextureImageBindMode::ReadOnly );
-	m_Depths.BindAsImage( 3, ae::TextureImageBindMode::ReadOnly );
-	m_Materials.BindAsImage( 4, ae::TextureImageBindMode::ReadOnly );
-	m_Positions.BindAsImage( 5, ae::TextureImageBindMode::ReadOnly );
+const KBuffer::FrameStatistics& KBuffer::GetLastFrameStatistics() const
+{
+	return m_LastFrameStatistics;
+}
 
+KBuffer::DebugView KBuffer::GetDebugView() const
+{
+	return m_DebugView;
+}
 
-	// Other needed data for the final color processing.
+void KBuffer::SetDebugView( DebugView _DebugView )
+{
+	m_DebugView = _DebugView;
+}
 
-	m_ResolvePassShader.SetColor( m_ResolvePassShader.GetUniformLocation( "BackgroundColor" ), _BackgroundColor );
+Bool KBuffer::IsOccupancyRecorded() const
+{
+	return m_IsOccupancyRecorded;
+}
 
-	m_ResolvePassShader.SetBool( m_ResolvePassShader.GetUniformLocation( "ToneMap" ), m_IsToneMapped );
-	m_ResolvePassShader.SetFloat( m_ResolvePassShader.GetUniformLocation( "Exposure" ), m_Exposure );
+void KBuffer::SetIsOccupancyRecorded( Bool _IsOccupancyRecorded )
+{
+	m_IsOccupancyRecorded = _IsOccupancyRecorded;
+}
 
-	m_ResolvePassShader.SetBool( m_ResolvePassShader.GetUniformLocation( "GammaCorrection" ), m_IsGammaCorrected );
-	m_ResolvePassShader.SetFloat( m_ResolvePassShader.GetUniformLocation( "Gamma" ), m_Gamma );
-	
+float KBuffer::GetHeatmapMaxValue() const
+{
+	return m_HeatmapMaxValue;
+}
 
-	// Draw a fullscreen quad to process stored fragments.
-	DrawVertexArray( m_FullscreenSprite, m_FullscreenSprite.GetPrimitiveType() );
+void KBuffer::SetHeatmapMaxValue( float _MaxValue )
+{
+	m_HeatmapMaxValue = ae::Math::Max( _MaxValue, 1.0f );
+}
 
-	m_ResolvePassShader.Unbind();
+const std::vector<Uint32>& KBuffer::GetDepthComplexityHistogram() const
+{
+	return m_DepthComplexityHistogram;
+}
 
-	_Target.Unbind();
+Bool KBuffer::IsToneMapped() const
+{
+	return m_IsToneMapped;
+}
+
+void KBuffer::SetIsToneMapped( Bool _IsToneMapped )
+{
+	m_IsToneMapped = _IsToneMapped;
+}
+
+float KBuffer::GetExposure() const
+{
+	return m_Exposure;
+}
+
+void KBuffer::SetExposure( float _Exposure )
+{
+	m_Exposure = ae::Math::Max( _Exposure, 0.0f );
+}
+
+Bool KBuffer::IsGammaCorrected() const
+{
+	return m_IsGammaCorrected;
+}
+
+void KBuffer::SetIsGammaCorrected( Bool _IsGammaCorrected )
+{
+	m_IsGammaCorrected = _IsGammaCorrected;
+}
+
+float KBuffer::GetGamma() const
+{
+	return m_Gamma;
+}
+
+void KBuffer::SetGamma( float _Gamma )
+{
+	m_Gamma = ae::Math::Max( _Gamma, ae::Math::Epsilon() );
+}
+
+void KBuffer::SetStorePassMaterialCount( Int32 _Count )
+{
+	size_t NewMaterialCount = Cast( size_t, ae::Math::Max( 1, _Count ) );
+	if( NewMaterialCount > MaxStorePassMaterialsCount )
+	{
+		AE_LogWarning( "The K-Buffer stores at most " + std::to_string( MaxStorePassMaterialsCount ) + " materials, the material count is clamped." );
+		NewMaterialCount = MaxStorePassMaterialsCount;
+	}
+
+	if( m_MaterialTable.size() >= NewMaterialCount )
+		return;
+
+	m_MaterialTable.resize( NewMaterialCount );
+	m_AreMaterialsDirty = True;
+}
+
+void KBuffer::Resize( Uint32 _Width, Uint32 _Height )
+{
+	m_OutputWidth = _Width;
+	m_OutputHeight = _Height;
+
+	// Below the target resolution, the rounded up fraction of the size is rendered. Several views are side by side.
+	Uint32 Divisor = IsUpsampled() ? m_ResolutionDivisor : 1;
+	ResizeRenderedArea( ( _Width + Divisor - 1 ) / Divisor * GetViewsCount(), ( _Height + Divisor - 1 ) / Divisor );
+}
+
+void KBuffer::ResizeRenderedArea( Uint32 _Width, Uint32 _Height )
+{
+	if( m_RenderWidth == _Width && m_RenderHeight == _Height )
+		return;
+
+	m_RenderWidth = _Width;
+	m_RenderHeight = _Height;
+
+	// Reallocation only when the new size does not fit, or when most of the memory would be unused.
+	if( IsReallocationNeeded( _Width, _Height, GetWidth(), GetHeight() ) )
+	{
+		ae::Framebuffer::Resize( GetAllocatedSize( _Width ), GetAllocatedSize( _Height ) );
+		UpdateStorage();
+		return;
+	}
+
+	// The pixels written out of the new size are still cleared by the next clear pass, the pixels uncovered by a larger size are cleared too.
+	m_DirtyRect = UniteRects( m_DirtyRect, GetFullRect() );
+	m_IsResolvedImageValid = False;
+}
+
+Uint32 KBuffer::GetRenderWidth() const
+{
+	return m_RenderWidth;
+}
+
+Uint32 KBuffer::GetRenderHeight() const
+{
+	return m_RenderHeight;
+}
+
+Uint32 KBuffer::GetResolutionDivisor() const
+{
+	return m_ResolutionDivisor;
+}
+
+void KBuffer::SetResolutionDivisor( Uint32 _Divisor )
+{
+	Uint32 NewDivisor = ae::Math::Clamp( 1u, 4u, _Divisor );
+	if( NewDivisor == m_ResolutionDivisor )
+		return;
+
+	m_ResolutionDivisor = NewDivisor;
+	Resize( m_OutputWidth, m_OutputHeight );
+
+	// The guide and the low resolution image are only used below the target resolution.
+	if( m_ResolutionDivisor == 1 )
+	{
+		m_GuideDepths.reset();
+		m_LowResolutionImage.reset();
+	}
+}
+
+Bool KBuffer::IsReallocationNeeded( Uint32 _Width, Uint32 _Height, Uint32 _AllocatedWidth, Uint32 _AllocatedHeight )
+{
+	Bool IsAboveAllocation = _Width > _AllocatedWidth || _Height > _AllocatedHeight;
+	Bool IsFarBelowAllocation = Cast( Uint64, _Width ) * _Height * 4 < Cast( Uint64, _AllocatedWidth ) * _AllocatedHeight;
+
+	return IsAboveAllocation || IsFarBelowAllocation;
+}
+
+void KBuffer::TrimMemory()
+{
+	if( GetWidth() == m_RenderWidth && GetHeight() == m_RenderHeight )
+		return;
+
+	ae::Framebuffer::Resize( m_RenderWidth, m_RenderHeight );
+	UpdateStorage();
+
+	// Created again by the next frames, without headroom.
+	m_ResolvedImage.reset();
+	m_IsResolvedImageValid = False;
+	m_GuideDepths.reset();
+	m_LowResolutionImage.reset();
+}
+
+Uint32 KBuffer::GetViewsCount() const
+{
+	return IsMultiView() ? Cast( Uint32, m_Views.size() ) : 1;
+}
+
+void KBuffer::SetViews( const std::vector<ae::Camera*>& _Cameras )
+{
+	Uint32 LastViewsCount = GetViewsCount();
+
+	m_Views.clear();
+	for( ae::Camera* Camera : _Cameras )
+	{
+		if( Camera != nullptr && m_Views.size() < MaxViewsCount )
+			m_Views.push_back( Camera );
+	}
+
+	if( m_Views.size() < _Cameras.size() )
+		AE_LogWarning( "Only " + std::to_string( MaxViewsCount ) + " valid cameras are used as views." );
+
+	if( GetViewsCount() == LastViewsCount )
+		return;
+
+	// The views share the rendered area : its width follows the number of views.
+	Resize( m_OutputWidth, m_OutputHeight );
+	m_DirtyRect = UniteRects( m_DirtyRect, GetFullRect() );
+	m_IsResolvedImageValid = False;
+}
+
+void KBuffer::Bind()
+{
+	ae::Framebuffer::Bind();
+
+	// The passes render in the bottom left corner of the allocation.
+	glViewport( 0, 0, Cast( GLsizei, m_RenderWidth ), Cast( GLsizei, m_RenderHeight ) );
+	AE_ErrorCheckOpenGLError();
+}
+
+
+void KBuffer::ClearPass()
+{
+	// Incremental frame : the draws are only recorded, the resolve pass clears what changed.
+	m_IsFrameRecorded = IsIncrementalActive();
+	if( m_IsFrameRecorded )
+	{
+		m_RecordedDraws.clear();
+		m_RecordedBatchesCount = 0;
+		return;
+	}
+
+	ClearStoredFragments( False );
+}
+
+void KBuffer::ClearStoredFragments( Bool _IsPartialUpdate )
+{
+	// Counts tagged with the generation : the next generation invalidates the fragments of the previous frames, nothing is cleared.
+	// The semaphores are always released after an insertion, they stay cleared.
+	// The storage is fully cleared when it has just been allocated or when the generations (24 bits) loop.
+	const Uint32 MaxGeneration = 0xFFFFFF;
+
+	m_LastClearSize = 0;
+
+	// Adaptive K : the K chosen from the statistics of a previous frame is used from this frame.
+	ReadProfiledFrames();
+	BeginProfiledFrame();
+
+	ReadDepthComplexityHistogram();
+
+	// Only the pixels written by the last frame are cleared, the other ones are still clear.
+	PixelRect ClearRect = m_DirtyRect;
+	Uint32 ClearWidth = ClearRect.MaxX > ClearRect.MinX ? ClearRect.MaxX - ClearRect.MinX : 0;
+	Uint32 ClearHeight = ClearRect.MaxY > ClearRect.MinY ? ClearRect.MaxY - ClearRect.MinY : 0;
+	size_t ClearPixelsCount = Cast( size_t, ClearWidth ) * ClearHeight;
+
+	m_DirtyRect = { 0, 0, 0, 0 };
+
+	// Cheaper techniques : no storage, only the blended targets are cleared. The storage of the K-Buffer is kept as it is for the next frames.
+	if( m_TransparencyTechnique != TransparencyTechnique::KBuffer )
+		m_ReplayedDraws.clear();
+
+	// Lock free mode : every slot to 0xFFFFFFFFFFFFFFFF, empty slots are further than any fragment.
+	// The slots of the current K are at the beginning of the buffer.
+	else if( m_InsertionMode == InsertionMode::LockFree )
+	{
+		size_t PackedFragmentsSize = GetStoragePixelsCount() * m_K * sizeof( Uint64 );
+		m_PackedFragments.Clear( 0xFFFFFFFF, PackedFragmentsSize );
+		m_LastClearSize = ae::Math::Min( PackedFragmentsSize, m_PackedFragments.GetSize() );
+	}
+
+	// Linked lists : every head to the end of list and no fragment allocated, the fragments are never read before being linked.
+	else if( m_InsertionMode == InsertionMode::LinkedList )
+	{
+		ReadAllocatedFragmentsCount();
+
+		const Uint32 NoAllocatedFragment = 0;
+		m_ListHeads.Clear( 0 );
+		m_FragmentPool.SetData( &NoAllocatedFragment, sizeof( Uint32 ) );
+		m_LastClearSize = m_ListHeads.GetSize() + sizeof( Uint32 );
+	}
+
+	// Counted mode : the counts go back to 0 during the second pass and the resolve pass, the prefix sum overwrites the offsets and the allocated count.
+	// The counts are only cleared when just allocated, or when the objects of the last frame have not been resolved.
+	else if( m_InsertionMode == InsertionMode::Counted )
+	{
+		ReadAllocatedFragmentsCount();
+
+		if( m_Generation == 0 || !m_ReplayedDraws.empty() )
+		{
+			glClearTexSubImage( m_Counts.GetTextureID(), 0, 0, 0, 0, m_Counts.GetWidth(), m_Counts.GetHeight(), 1,
+								ae::ToGLFormat( m_Counts.GetFormat() ), ae::ToGLType( m_Counts.GetFormat() ), nullptr );
+			AE_ErrorCheckOpenGLError();
+
+			m_LastClearSize = Cast( size_t, m_Counts.GetWidth() ) * m_Counts.GetHeight() * sizeof( Uint32 );
+			m_Generation = 1;
+		}
+
+		m_ReplayedDraws.clear();
+	}
+
+	// Tile-sparse storage : the pages are cleared when they are given to the tiles, only the page table is reset. The generation never changes.
+	else if( IsTileSparseActive() )
+	{
+		m_LastClearSize = ( m_Generation == 0 ? ClearLockedStorage( GetAllocatedRect() ) : 0 ) + ResetTilePages();
+		m_Generation = 1;
+	}
+
+	// Partial update of an incremental frame : the other pixels keep their fragments with the current generation, only the counts of the updated pixels are cleared.
+	// A cleared count reads as 0 with any generation.
+	else if( _IsPartialUpdate && m_IsGenerationTagged && m_Generation != 0 && m_StorageLayout == StorageLayout::LayerMajorImages )
+	{
+		glClearTexSubImage( m_Counts.GetTextureID(), 0, ClearRect.MinX, ClearRect.MinY, 0, ClearWidth, ClearHeight, 1,
+							ae::ToGLFormat( m_Counts.GetFormat() ), ae::ToGLType( m_Counts.GetFormat() ), nullptr );
+		AE_ErrorCheckOpenGLError();
+
+		m_LastClearSize = ClearPixelsCount * sizeof( Uint32 );
+	}
+
+	else if( m_IsGenerationTagged && m_Generation != 0 && m_Generation < MaxGeneration )
+		m_Generation++;
+
+	// The whole storage is cleared when it has just been allocated or when the generations loop, the tags of the previous frames are everywhere.
+	else
+	{
+		m_LastClearSize = ClearLockedStorage( m_IsGenerationTagged || m_Generation == 0 ? GetAllocatedRect() : ClearRect );
+		m_Generation = 1;
+	}
+
+	// The depth and the opaque color are cleared with the scissor test.
+	EnableScissor( ClearRect );
+
+	glClear( GL_DEPTH_BUFFER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	// Overflow tail and cheaper techniques : nothing accumulated and everything behind revealed.
+	if( AreBlendedTargetsUsed() )
+	{
+		const float NoAccumulation[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		// The moment based technique adds absorbances instead of multiplying revealages.
+		const float FullRevealage = m_TransparencyTechnique == TransparencyTechnique::MomentBased ? 0.0f : 1.0f;
+		glClearTexSubImage( m_BlendedAccumulations.GetTextureID(), 0, ClearRect.MinX, ClearRect.MinY, 0, ClearWidth, ClearHeight, 1, GL_RGBA, GL_FLOAT, NoAccumulation );
+		glClearTexSubImage( m_BlendedRevealages.GetTextureID(), 0, ClearRect.MinX, ClearRect.MinY, 0, ClearWidth, ClearHeight, 1, GL_RED, GL_FLOAT, &FullRevealage );
+		AE_ErrorCheckOpenGLError();
+
+		m_LastClearSize += ClearPixelsCount * ( 8 + 4 );
+	}
+
+	// Occupancy : nothing dropped and no spin iteration.
+	m_LastClearSize += ClearOccupancy();
+
+	// Moment based OIT : no moment accumulated.
+	if( m_TransparencyTechnique == TransparencyTechnique::MomentBased )
+	{
+		const float NoMoments[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearTexSubImage( m_PowerMoments.GetTextureID(), 0, ClearRect.MinX, ClearRect.MinY, 0, ClearWidth, ClearHeight, 1, GL_RGBA, GL_FLOAT, NoMoments );
+		AE_ErrorCheckOpenGLError();
+
+		m_LastClearSize += ClearPixelsCount * 16;
+	}
+
+	// Transparent opaque color : the resolve pass uses the background color where no opaque object is drawn.
+	if( m_UseOpaquePrePass )
+	{
+		const float NoOpaqueColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv( GL_COLOR, 0, NoOpaqueColor );
+		AE_ErrorCheckOpenGLError();
+	}
+
+	glDisable( GL_SCISSOR_TEST );
+	AE_ErrorCheckOpenGLError();
+
+	if( IsUpsampled() )
+		ClearGuideDepths();
+
+	// Be sure the textures are ready before starting store pass.
+	glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	// End of the clear pass.
+	if( m_IsFrameProfiled )
+		WriteTimeStamp();
+}
+
+void KBuffer::Draw( const ae::Drawable& _Object, ae::Camera* _Camera )
+{
+	if( !_Object.IsEnabled() )
+		return;
+
+	if( !CheckCountPrimitive( _Object.GetIndicesCount(), _Object.GetPrimitiveType() ) )
+	{
+		AE_LogWarning( "Count of indices do not fit with the primitive. Object will not be drawn." );
+		return;
+	}
+
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	if( Instanced != nullptr && Instanced->GetInstancesCount() == 0 )
+		return;
+
+
+	// Several views : the object is stored in every view with their cameras.
+	if( IsMultiView() )
+	{
+		PixelRect Rect = { 0, 0, 0, 0 };
+		for( Uint32 v = 0; v < GetViewsCount(); v++ )
+			Rect = UniteRects( Rect, GetScreenRect( _Object, *m_Views[v], GetViewRect( v ) ) );
+
+		if( !IsRectEmpty( Rect ) )
+			StoreObject( _Object, *m_Views[0], Rect );
+
+		return;
+	}
+
+	if( _Camera == nullptr && !Aero.HasCamera() )
+	{
+		AE_LogWarning( "No valid camera to use for rendering. Object will not be drawn." );
+		return;
+	}
+
+	ae::Camera& CurrentCamera = _Camera != nullptr ? *_Camera : Aero.GetCamera();
+
+	// Objects out of the screen are skipped, the other ones only write the pixels of their rectangle.
+	PixelRect Rect = GetScreenRect( _Object, CurrentCamera, GetFullRect() );
+
+	// Incremental frame : the object is compared to the last frame and stored by the resolve pass if its pixels changed.
+	if( m_IsFrameRecorded )
+	{
+		RecordDraw( _Object, CurrentCamera, Rect, 0 );
+		return;
+	}
+
+	if( IsRectEmpty( Rect ) )
+		return;
+
+	StoreObject( _Object, CurrentCamera, Rect );
+}
+
+void KBuffer::DrawBatch( const std::vector<const ae::Drawable*>& _Objects, ae::Camera* _Camera )
+{
+	if( !IsBatchSupported() )
+	{
+		for( const ae::Drawable* Object : _Objects )
+		{
+			if( Object != nullptr )
+				Draw( *Object, _Camera );
+		}
+
+		return;
+	}
+
+	if( _Camera == nullptr && !Aero.HasCamera() )
+	{
+		AE_LogWarning( "No valid camera to use for rendering. Objects will not be drawn." );
+		return;
+	}
+
+	ae::Camera& CurrentCamera = _Camera != nullptr ? *_Camera : Aero.GetCamera();
+
+	// The objects that cannot be batched are drawn first : the opaque ones write the depth tested by the translucent ones.
+	m_BatchedDraws.clear();
+	for( const ae::Drawable* Object : _Objects )
+	{
+		if( Object == nullptr || !Object->IsEnabled() )
+			continue;
+
+		if( !IsBatchable( *Object ) )
+		{
+			Draw( *Object, &CurrentCamera );
+			continue;
+		}
+
+		// The objects out of the screen are recorded too : the pixels they left must be updated.
+		PixelRect Rect = GetScreenRect( *Object, CurrentCamera, GetFullRect() );
+		if( m_IsFrameRecorded || !IsRectEmpty( Rect ) )
+			m_BatchedDraws.push_back( { Object, &CurrentCamera, Rect } );
+	}
+
+	if( m_BatchedDraws.empty() )
+		return;
+
+	// Incremental frame : the objects are compared to the last frame and stored again with one batch by the resolve pass if their pixels changed.
+	if( m_IsFrameRecorded )
+	{
+		m_RecordedBatchesCount++;
+		for( const ReplayedDraw& BatchedDraw : m_BatchedDraws )
+			RecordDraw( *BatchedDraw.Object, CurrentCamera, BatchedDraw.Rect, m_RecordedBatchesCount );
+
+		return;
+	}
+
+	StoreBatch( CurrentCamera );
+}
+
+void KBuffer::StoreBatch( ae::Camera& _Camera )
+{
+	UpdateBatchMeshes();
+
+	// One command per object, its base instance selects its transform and its material index.
+	m_BatchInstancesData.clear();
+	m_BatchCommandsData.clear();
+
+	PixelRect BatchRect = { 0, 0, 0, 0 };
+	for( const ReplayedDraw& BatchedDraw : m_BatchedDraws )
+	{
+		const ae::Drawable& Object = *BatchedDraw.Object;
+		const StorePassMaterial& ObjectMaterial = static_cast<const StorePassMaterial&>( Object.GetMaterial() );
+
+		PrepareStoredObject( Object, BatchedDraw.Rect );
+
+		BatchRect = UniteRects( BatchRect, BatchedDraw.Rect );
+
+		InstancedDrawable::InstanceAttributes Instance;
+		ae::Matrix4x4 Model = GetModelMatrix( Object );
+		std::copy( Model.GetData(), Model.GetData() + 16, Instance.Model );
+		Instance.MaterialIndex = ae::Math::Max( 0, ObjectMaterial.GetMaterialIndex().GetValue() );
+
+		const BatchMesh& Mesh = m_BatchMeshes[&Object];
+		m_BatchCommandsData.push_back( { Mesh.IndicesCount, 1, Mesh.FirstIndex, Cast( Int32, Mesh.FirstVertex ), Cast( Uint32, m_BatchInstancesData.size() ) } );
+		m_BatchInstancesData.push_back( Instance );
+	}
+
+	// The buffers grow with headroom and are uploaded entirely : the batches of a frame are usually the same.
+	size_t InstancesSize = m_BatchInstancesData.size() * sizeof( InstancedDrawable::InstanceAttributes );
+	if( InstancesSize > m_BatchInstances.GetSize() )
+		m_BatchInstances.Resize( InstancesSize * 2 );
+	m_BatchInstances.SetData( m_BatchInstancesData.data(), InstancesSize );
+
+	size_t CommandsSize = m_BatchCommandsData.size() * sizeof( DrawElementsCommand );
+	if( CommandsSize > m_BatchCommands.GetSize() )
+		m_BatchCommands.Resize( CommandsSize * 2 );
+	m_BatchCommands.SetData( m_BatchCommandsData.data(), CommandsSize );
+
+	// The overflow tail and the cheaper techniques read the material of the blended fragments in the material table.
+	if( AreBlendedTargetsUsed() )
+		UploadMaterials();
+
+	m_DirtyRect = UniteRects( m_DirtyRect, BatchRect );
+
+	// The batch is measured like a single draw of a profiled frame.
+	if( m_IsFrameProfiled )
+		WriteTimeStamp();
+
+	DrawStorePassBatch( _Camera, AreBlendedTargetsUsed() ? StorePassTargets::WeightedBlended : StorePassTargets::Storage, BatchRect );
+
+	if( m_IsFrameProfiled )
+		WriteTimeStamp();
+}
+
+void KBuffer::StoreObject( const ae::Drawable& _Object, ae::Camera& _Camera, const PixelRect& _Rect )
+{
+	m_DirtyRect = UniteRects( m_DirtyRect, _Rect );
+
+	const ae::Material& ObjectMaterial = _Object.GetMaterial();
+
+	// The instances of an instanced drawable have their own materials : they are never drawn by the opaque pre-pass.
+	Bool IsOpaque = dynamic_cast<const InstancedDrawable*>( &_Object ) == nullptr && IsRenderedInOpaquePrePass( ObjectMaterial );
+
+	if( !IsOpaque )
+		PrepareStoredObject( _Object, _Rect );
+
+	// The overflow tail and the cheaper techniques read the material of the blended fragments in the material table.
+	if( !IsOpaque && AreBlendedTargetsUsed() )
+		UploadMaterials();
+
+	// Counted mode : the fragments are only counted now, the object is drawn again once the offsets are known.
+	// Moment based OIT : only the moments are accumulated now, the object is drawn again once the moments are known.
+	Bool IsCounted = m_TransparencyTechnique == TransparencyTechnique::KBuffer && m_InsertionMode == InsertionMode::Counted;
+	if( !IsOpaque && ( IsCounted || m_TransparencyTechnique == TransparencyTechnique::MomentBased ) )
+		m_ReplayedDraws.push_back( { &_Object, &_Camera, _Rect } );
+
+	StorePassTargets Targets = StorePassTargets::Storage;
+	if( IsOpaque )
+		Targets = StorePassTargets::OpaqueColor;
+	else if( m_TransparencyTechnique == TransparencyTechnique::MomentBased )
+		Targets = StorePassTargets::Moments;
+	else if( AreBlendedTargetsUsed() )
+		Targets = StorePassTargets::WeightedBlended;
+
+	// Each draw of a profiled frame is measured between two time stamps.
+	if( m_IsFrameProfiled )
+		WriteTimeStamp();
+
+	// Use the store pass shader to store the K nearest fragment into the 3D textures, or the opaque pass shader to write the opaque color.
+	if( IsOpaque )
+		DrawStorePass( _Object, _Camera, Targets, m_OpaquePassShader, _Rect );
+	else
+		DrawStorePass( _Object, _Camera, Targets, GetStorePassShader(), _Rect );
+
+	// Below the target resolution, the depth of every object guides the upsampling.
+	if( IsUpsampled() )
+		DrawGuideDepth( _Object, _Camera );
+
+	if( m_IsFrameProfiled )
+		WriteTimeStamp();
+}
+
+void KBuffer::PrepareStoredObject( const ae::Drawable& _Object, const PixelRect& _Rect )
+{
+	// The store pass only writes the material index, the parameters go in the material table.
+	UpdateMaterial( _Object.GetMaterial() );
+
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	if( Instanced != nullptr )
+	{
+		for( const StorePassMaterial* InstanceMaterial : Instanced->GetInstanceMaterials() )
+			UpdateMaterial( *InstanceMaterial );
+	}
+
+	// The tiles covered by the object must have their page before it stores its fragments.
+	if( IsTileSparseActive() )
+		AllocateTilePages( _Rect );
+}
+
+void KBuffer::RecordDraw( const ae::Drawable& _Object, ae::Camera& _Camera, const PixelRect& _Rect, Uint32 _Batch )
+{
+	const ae::Material& ObjectMaterial = _Object.GetMaterial();
+
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	Uint64 InstancesVersion = Instanced != nullptr ? Instanced->GetInstancesVersion() : 0;
+
+	m_RecordedDraws.push_back( { &_Object, &_Camera, GetModelViewProjection( _Object, _Camera ), &ObjectMaterial, GetMaterialEntry( ObjectMaterial ), InstancesVersion, _Rect, _Batch } );
+}
+
+template<typename ShaderType>
+void KBuffer::DrawStorePass( const ae::Drawable& _Object, ae::Camera& _Camera, StorePassTargets _Targets, ShaderType& _Shader, const PixelRect& _Rect )
+{
+	BeginStorePass( _Targets );
+
+	// Call user event.
+	_Object.OnDrawBegin( *this );
+
+	// Instanced drawable : the transforms and the material indices are per instance attributes.
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	BindStorePassShader( _Camera, _Targets, _Shader, Instanced != nullptr );
+
+	// Send the material parameters and the object transform if there is.
+	SendObject( _Shader, _Object );
+
+	// Several views : one instance per view.
+	SendViews( _Shader );
+
+	
+	// Draw the object with the bound shader, only in its screen rectangle.
+	EnableScissor( _Rect );
+
+	if( IsMultiView() || Instanced != nullptr )
+		DrawInstances( _Object );
+	else
+		DrawVertexArray( _Object, _Object.GetPrimitiveType() );
+
+	glDisable( GL_SCISSOR_TEST );
+	AE_ErrorCheckOpenGLError();
+
+
+	// Clear the shader from OpenGL.
+	_Shader.Unbind();
+
+	EndStorePass( _Targets );
+
+
+	// Call user event.
+	_Object.OnDrawEnd( *this );
+}
+
+void KBuffer::DrawStorePassBatch( ae::Camera& _Camera, StorePassTargets _Targets, const PixelRect& _Rect )
+{
+	BeginStorePass( _Targets );
+
+	// Call user events.
+	for( const ReplayedDraw& BatchedDraw : m_BatchedDraws )
+		BatchedDraw.Object->OnDrawBegin( *this );
+
+	// The transforms and the material indices are per instance attributes, the material parameters are in the material table.
+	GraphicsShader& Shader = GetStorePassShader();
+	BindStorePassShader( _Camera, _Targets, Shader, True );
+	SendViews( Shader );
+
+
+	// Draw all the objects with the bound shader, only in the union of their screen rectangles.
+	EnableScissor( _Rect );
+
+	glBindVertexArray( m_BatchVertexArray );
+	glBindBuffer( GL_DRAW_INDIRECT_BUFFER, m_BatchCommands.GetBufferID() );
+	glMultiDrawElementsIndirect( GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, Cast( GLsizei, m_BatchCommandsData.size() ), 0 );
+	glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+	glBindVertexArray( 0 );
+
+	glDisable( GL_SCISSOR_TEST );
+	AE_ErrorCheckOpenGLError();
+
+
+	// Clear the shader from OpenGL.
+	Shader.Unbind();
+
+	EndStorePass( _Targets );
+
+
+	// Call user events.
+	for( const ReplayedDraw& BatchedDraw : m_BatchedDraws )
+		BatchedDraw.Object->OnDrawEnd( *this );
+}
+
+Bool KBuffer::IsBatchSupported() const
+{
+	// The counted mode and the moment based OIT draw the objects again one by one.
+	// Several views and the upsampling guide need per object draws too.
+	Bool IsCounted = m_TransparencyTechnique == TransparencyTechnique::KBuffer && m_InsertionMode == InsertionMode::Counted;
+
+	return !IsCounted && m_TransparencyTechnique != TransparencyTechnique::MomentBased && !IsMultiView() && !IsUpsampled();
+}
+
+Bool KBuffer::IsBatchable( const ae::Drawable& _Object )
+{
+	// The instanced drawables already store all their instances with one draw.
+	if( dynamic_cast<const InstancedDrawable*>( &_Object ) != nullptr )
+		return False;
+
+	const ae::Material& ObjectMaterial = _Object.GetMaterial();
+	if( dynamic_cast<const StorePassMaterial*>( &ObjectMaterial ) == nullptr || IsRenderedInOpaquePrePass( ObjectMaterial ) )
+		return False;
+
+	if( _Object.GetPrimitiveType() != ae::PrimitiveType::Triangles || _Object.GetElementsArrayObject() == 0 || _Object.GetIndicesCount() == 0 || _Object.GetIndicesCount() % 3 != 0 )
+		return False;
+
+	// Only the 3D vertices have a known layout.
+	return _Object.GetVertexBufferObject() != 0 && _Object.GetAttributePointerTags() == ae::Drawable::AttributePointer::Default3D;
+}
+
+void KBuffer::UpdateBatchMeshes()
+{
+	// The meshes missing from the arena, or whose buffers changed since they were copied, are appended after the copied ones.
+	std::vector<const ae::Drawable*> MissingObjects;
+	Uint32 VerticesCount = m_BatchVerticesCount;
+	Uint32 IndicesCount = m_BatchIndicesCount;
+
+	// Size of the meshes of this batch alone, the size used by the arena once compacted.
+	Uint32 BatchVerticesCount = 0;
+	Uint32 BatchIndicesCount = 0;
+
+	for( const ReplayedDraw& BatchedDraw : m_BatchedDraws )
+	{
+		const ae::Drawable& Object = *BatchedDraw.Object;
+
+		GLint64 VertexBufferSize = 0;
+		glGetNamedBufferParameteri64v( Object.GetVertexBufferObject(), GL_BUFFER_SIZE, &VertexBufferSize );
+		Uint32 ObjectVerticesCount = Cast( Uint32, Cast( size_t, VertexBufferSize ) / sizeof( ae::Vertex3D ) );
+
+		BatchVerticesCount += ObjectVerticesCount;
+		BatchIndicesCount += Object.GetIndicesCount();
+
+		BatchMesh& Mesh = m_BatchMeshes[&Object];
+		if( Mesh.VertexBuffer == Object.GetVertexBufferObject() && Mesh.ElementsBuffer == Object.GetElementsArrayObject() &&
+			Mesh.VerticesCount == ObjectVerticesCount && Mesh.IndicesCount == Object.GetIndicesCount() )
+			continue;
+
+		Mesh = { Object.GetVertexBufferObject(), Object.GetElementsArrayObject(), ObjectVerticesCount, Object.GetIndicesCount(), VerticesCount, IndicesCount };
+		VerticesCount += ObjectVerticesCount;
+		IndicesCount += Object.GetIndicesCount();
+
+		MissingObjects.push_back( &Object );
+	}
+
+	// The arena is full : it is compacted by copying the meshes of this batch alone from its start, and only grows when they do not fit.
+	if( VerticesCount * sizeof( ae::Vertex3D ) > m_BatchVertices.GetSize() || IndicesCount * sizeof( Uint32 ) > m_BatchIndices.GetSize() )
+	{
+		if( BatchVerticesCount * sizeof( ae::Vertex3D ) > m_BatchVertices.GetSize() )
+			m_BatchVertices.Resize( BatchVerticesCount * sizeof( ae::Vertex3D ) * 2 );
+
+		if( BatchIndicesCount * sizeof( Uint32 ) > m_BatchIndices.GetSize() )
+			m_BatchIndices.Resize( BatchIndicesCount * sizeof( Uint32 ) * 2 );
+
+		m_BatchMeshes.clear();
+		m_BatchVerticesCount = 0;
+		m_BatchIndicesCount = 0;
+
+		UpdateBatchMeshes();
+		return;
+	}
+
+	for( const ae::Drawable* Object : MissingObjects )
+	{
+		const BatchMesh& Mesh = m_BatchMeshes[Object];
+
+		glCopyNamedBufferSubData( Mesh.VertexBuffer, m_BatchVertices.GetBufferID(), 0, Cast( GLintptr, Mesh.FirstVertex * sizeof( ae::Vertex3D ) ), Cast( GLsizeiptr, Mesh.VerticesCount * sizeof( ae::Vertex3D ) ) );
+		glCopyNamedBufferSubData( Mesh.ElementsBuffer, m_BatchIndices.GetBufferID(), 0, Cast( GLintptr, Mesh.FirstIndex * sizeof( Uint32 ) ), Cast( GLsizeiptr, Mesh.IndicesCount * sizeof( Uint32 ) ) );
+	}
+	AE_ErrorCheckOpenGLError();
+
+	m_BatchVerticesCount = VerticesCount;
+	m_BatchIndicesCount = IndicesCount;
+}
+
+void KBuffer::BeginStorePass( StorePassTargets _Targets )
+{
+	Bool IsOpaque = _Targets == StorePassTargets::OpaqueColor;
+
+	// Opaque pre-pass : the opaque objects write their depth with a regular depth test,
+	// the other ones are tested against it without writing it (the early depth test writes the depth even for discarded fragments).
+	if( m_UseOpaquePrePass )
+	{
+		glEnable( GL_DEPTH_TEST );
+		glDepthFunc( GL_LESS );
+		glDepthMask( IsOpaque ? GL_TRUE : GL_FALSE );
+		AE_ErrorCheckOpenGLError();
+	}
+
+	// The opaque pre-pass only writes the opaque color, the store pass only writes the overflow tail, the cheaper techniques their accumulations.
+	// The accumulations and the moments are added by the hardware blending, the revealage is multiplied, except the absorbance of the moment based OIT which is added.
+	GLenum DrawBuffers[4] = { GL_NONE, GL_NONE, GL_NONE, GL_NONE };
+
+	if( IsOpaque )
+		DrawBuffers[0] = GL_COLOR_ATTACHMENT0;
+
+	if( _Targets == StorePassTargets::WeightedBlended || _Targets == StorePassTargets::MomentsAccumulation )
+		DrawBuffers[1] = GL_COLOR_ATTACHMENT1;
+
+	if( _Targets == StorePassTargets::WeightedBlended || _Targets == StorePassTargets::Moments )
+		DrawBuffers[2] = GL_COLOR_ATTACHMENT2;
+
+	if( _Targets == StorePassTargets::Moments )
+		DrawBuffers[3] = GL_COLOR_ATTACHMENT3;
+
+	// The blended targets are only allocated for the techniques blending them : they are attached when they are written.
+	if( DrawBuffers[1] != GL_NONE || DrawBuffers[2] != GL_NONE )
+	{
+		m_BlendedAccumulations.AttachToFramebuffer( ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Color_1, ae::TexturePixelFormat::RGBA_F16, ae::TextureFilterMode::Nearest ) );
+		m_BlendedRevealages.AttachToFramebuffer( ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Color_2, ae::TexturePixelFormat::Red_F32, ae::TextureFilterMode::Nearest ) );
+	}
+
+	if( DrawBuffers[3] != GL_NONE )
+		m_PowerMoments.AttachToFramebuffer( ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Color_3, ae::TexturePixelFormat::RGBA_F32, ae::TextureFilterMode::Nearest ) );
+
+	glDrawBuffers( 4, DrawBuffers );
+
+	for( GLuint b = 1; b < 4; b++ )
+	{
+		if( DrawBuffers[b] == GL_NONE )
+			continue;
+
+		glEnablei( GL_BLEND, b );
+		if( b == 2 && _Targets != StorePassTargets::Moments )
+			glBlendFunci( b, GL_ZERO, GL_ONE_MINUS_SRC_COLOR );
+		else
+			glBlendFunci( b, GL_ONE, GL_ONE );
+	}
+
+	AE_ErrorCheckOpenGLError();
+}
+
+template<typename ShaderType>
+void KBuffer::BindStorePassShader( ae::Camera& _Camera, StorePassTargets _Targets, ShaderType& _Shader, Bool _HasInstanceAttributes )
+{
+	_Shader.Bind();
+
+	// Apply the camera settings.
+	SendCamera( _Shader, _Camera );
+
+	// Attach the K-Buffer textures and send K value to the shader.
+	if( _Targets != StorePassTargets::OpaqueColor )
+		BindStorage( _Shader, ae::TextureImageBindMode::ReadWrite );
+
+	// The second pass of the moment based OIT reads the moments of the first one.
+	if( _Targets == StorePassTargets::MomentsAccumulation )
+		BindMomentTextures( _Shader );
+
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "HasInstanceAttributes" ), _HasInstanceAttributes );
+}
+
+void KBuffer::EndStorePass( StorePassTargets _Targets )
+{
+	if( _Targets != StorePassTargets::OpaqueColor )
+	{
+		const GLenum OpaqueDrawBuffers[4] = { GL_COLOR_ATTACHMENT0, GL_NONE, GL_NONE, GL_NONE };
+
+		for( GLuint b = 1; b < 4; b++ )
+			glDisablei( GL_BLEND, b );
+
+		glDrawBuffers( 4, OpaqueDrawBuffers );
+		AE_ErrorCheckOpenGLError();
+	}
+
+	// Back to the depth mode of the K-Buffer.
+	if( m_UseOpaquePrePass )
+	{
+		glDepthMask( GL_TRUE );
+		AE_ErrorCheckOpenGLError();
+
+		ApplyDepthMode();
+	}
+}
+
+void KBuffer::Resolve( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera* _Camera )
+{
+	// Several views : the views are resolved together with their cameras, the first one is copied to the target.
+	if( IsMultiView() )
+	{
+		ResolveViews( { &_Target }, _BackgroundColor );
+		return;
+	}
+
+	if( _Camera == nullptr && !Aero.HasCamera() )
+	{
+		AE_LogWarning( "No valid camera to use for clear pass." );
+		return;
+	}
+
+	ae::Camera& CurrentCamera = _Camera != nullptr ? *_Camera : Aero.GetCamera();
+
+	if( m_IsFrameRecorded )
+		ResolveIncremental( _Target, _ClearTarget, _BackgroundColor, CurrentCamera );
+	else if( IsUpsampled() )
+		ResolveUpsampled( _Target, _ClearTarget, _BackgroundColor, CurrentCamera );
+	else
+		ResolveStoredFragments( _Target, _ClearTarget, _BackgroundColor, CurrentCamera );
+}
+
+void KBuffer::ResolveViews( const std::vector<ae::Framebuffer*>& _Targets, const ae::Color& _BackgroundColor )
+{
+	if( !IsMultiView() )
+	{
+		if( !_Targets.empty() && _Targets[0] != nullptr )
+			Resolve( *_Targets[0], True, _BackgroundColor );
+
+		return;
+	}
+
+	// Every view is resolved by the same pass in the resolved image, the resolved image of the incremental frames is lost.
+	ae::Framebuffer& ResolvedImage = GetResolvedImage();
+	m_IsResolvedImageValid = False;
+
+	ResolveStoredFragments( ResolvedImage, True, _BackgroundColor, *m_Views[0] );
+
+	for( Uint32 v = 0; v < GetViewsCount() && v < _Targets.size(); v++ )
+	{
+		if( _Targets[v] != nullptr )
+			BlitResolvedImage( *_Targets[v], GetViewRect( v ), _BackgroundColor );
+	}
+}
+
+void KBuffer::ResolveStoredFragments( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera& _Camera )
+{
+	// Start of the resolve pass, with the second geometry pass of the counted mode and of the moment based OIT.
+	if( m_IsFrameProfiled )
+		WriteTimeStamp();
+
+	// Only the materials changed since the last frame are sent.
+	UploadMaterials();
+
+	if( m_TransparencyTechnique == TransparencyTechnique::KBuffer && m_InsertionMode == InsertionMode::Counted )
+		StoreCountedFragments();
+
+	if( m_TransparencyTechnique == TransparencyTechnique::MomentBased )
+		AccumulateMomentFragments();
+
+	// Be sure the store pass is finished before start the resolve pass.
+	// The allocated count of the fragment pool is copied and reset by buffer commands.
+	glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	// Copy the allocated count to read it once the GPU is done, the frames with a pending copy are not read.
+	if( m_TransparencyTechnique == TransparencyTechnique::KBuffer && IsFragmentPoolUsed() && m_AllocatedCountFence == nullptr )
+	{
+		m_FragmentPool.CopyTo( m_AllocatedCountReadback, sizeof( Uint32 ) );
+
+		m_AllocatedCountFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		AE_ErrorCheckOpenGLError();
+	}
+
+	// The frames with a pending histogram are not read either.
+	if( IsOccupancyRecordActive() && m_DepthComplexityFence == nullptr )
+		RecordDepthComplexityHistogram();
+
+	_Target.Bind();
+
+	if( _ClearTarget )
+		_Target.Clear( _BackgroundColor );
+
+	// The tiled resolve reads the storage of the locked insertion and writes in a 2D color texture, the other cases use the fullscreen resolve.
+	const ae::Texture* TargetTexture = _Target.GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 );
+	Bool CanResolveTiles = m_TransparencyTechnique == TransparencyTechnique::KBuffer && m_InsertionMode == InsertionMode::Locked && TargetTexture != nullptr && TargetTexture->GetDimension() == ae::TextureDimension::Texture2D;
+
+	if( m_DebugView != DebugView::None && IsOccupancyRecordActive() )
+		ResolveDebugView();
+	else if( m_ResolveMode == ResolveMode::TiledCompute && CanResolveTiles )
+		ResolveTiles( _Target, _BackgroundColor, _Camera );
+	else
+		ResolveFullscreen( _BackgroundColor, _Camera );
+
+	// End of the profiled frame : its statistics are read by a next clear pass once the GPU is done.
+	if( m_IsFrameProfiled )
+		EndProfiledFrame();
+
+	_Target.Unbind();
+}
+
+Bool KBuffer::IsIncrementalActive() const
+{
+	return m_IsIncremental && !IsUpsampled() && !IsMultiView() && !m_IsProfiled && !IsAdaptiveKActive() && !IsOccupancyRecordActive();
+}
+
+Bool KBuffer::IsPartialUpdateSupported() const
+{
+	if( m_TransparencyTechnique != TransparencyTechnique::KBuffer )
+		return True;
+
+	return m_InsertionMode == InsertionMode::Locked && m_StorageLayout == StorageLayout::LayerMajorImages;
+}
+
+KBuffer::IncrementalSettings KBuffer::GetIncrementalSettings( const ae::Color& _BackgroundColor, ae::Camera& _Camera ) const
+{
+	IncrementalSettings Settings;
+	Settings.Width = m_RenderWidth;
+	Settings.Height = m_RenderHeight;
+	Settings.K = m_K;
+	Settings.FragmentPoolCapacity = m_FragmentPoolCapacity;
+	Settings.Technique = m_TransparencyTechnique;
+	Settings.Insertion = m_InsertionMode;
+	Settings.Layout = m_StorageLayout;
+	Settings.Resolve = m_ResolveMode;
+	Settings.View = m_DebugView;
+	Settings.UseInterlock = m_UseInterlock;
+	Settings.UseMaxHeap = m_UseMaxHeap;
+	Settings.UseTiledAddressing = m_UseTiledAddressing;
+	Settings.IsGenerationTagged = m_IsGenerationTagged;
+	Settings.UseOverflowTail = m_UseOverflowTail;
+	Settings.UseOpaquePrePass = m_UseOpaquePrePass;
+	Settings.IsShaderSpecialized = m_IsShaderSpecialized;
+	Settings.IsToneMapped = m_IsToneMapped;
+	Settings.IsGammaCorrected = m_IsGammaCorrected;
+	Settings.Exposure = m_Exposure;
+	Settings.Gamma = m_Gamma;
+	Settings.BackgroundColor = _BackgroundColor;
+	Settings.ViewProjection = _Camera.GetProjectionMatrix() * _Camera.GetLookAtMatrix();
+
+	return Settings;
+}
+
+KBuffer::PixelRect KBuffer::GetIncrementalUpdateRect( const IncrementalSettings& _Settings ) const
+{
+	const IncrementalSettings& Last = m_LastIncrementalSettings;
+	Bool AreSettingsEqual = _Settings.Width == Last.Width && _Settings.Height == Last.Height && _Settings.K == Last.K && _Settings.FragmentPoolCapacity == Last.FragmentPoolCapacity &&
+							_Settings.Technique == Last.Technique && _Settings.Insertion == Last.Insertion && _Settings.Layout == Last.Layout && _Settings.Resolve == Last.Resolve && _Settings.View == Last.View &&
+							_Settings.UseInterlock == Last.UseInterlock && _Settings.UseMaxHeap == Last.UseMaxHeap && _Settings.UseTiledAddressing == Last.UseTiledAddressing &&
+							_Settings.IsGenerationTagged == Last.IsGenerationTagged && _Settings.UseOverflowTail == Last.UseOverflowTail && _Settings.UseOpaquePrePass == Last.UseOpaquePrePass &&
+							_Settings.IsShaderSpecialized == Last.IsShaderSpecialized && _Settings.IsToneMapped == Last.IsToneMapped && _Settings.IsGammaCorrected == Last.IsGammaCorrected &&
+							_Settings.Exposure == Last.Exposure && _Settings.Gamma == Last.Gamma && _Settings.BackgroundColor == Last.BackgroundColor && _Settings.ViewProjection == Last.ViewProjection;
+
+	// The objects are matched by their order of drawing : an object added, removed or reordered updates the whole frame.
+	if( !m_IsResolvedImageValid || !AreSettingsEqual || m_RecordedDraws.size() != m_LastRecordedDraws.size() )
+		return GetFullRect();
+
+	PixelRect UpdateRect = { 0, 0, 0, 0 };
+	for( size_t i = 0; i < m_RecordedDraws.size(); i++ )
+	{
+		const RecordedDraw& Current = m_RecordedDraws[i];
+		const RecordedDraw& Previous = m_LastRecordedDraws[i];
+		if( Current.Object != Previous.Object || Current.Camera != Previous.Camera )
+			return GetFullRect();
+
+		// The pixels left by a moved object must be resolved again too.
+		if( Current.ModelViewProjection != Previous.ModelViewProjection || Current.Material != Previous.Material || !AreMaterialEntriesEqual( Current.MaterialEntry, Previous.MaterialEntry ) ||
+			Current.InstancesVersion != Previous.InstancesVersion )
+			UpdateRect = UniteRects( UpdateRect, UniteRects( Previous.Rect, Current.Rect ) );
+	}
+
+	// The buffers of the storage are fully cleared : every object is stored again.
+	if( !IsRectEmpty( UpdateRect ) && !IsPartialUpdateSupported() )
+		return GetFullRect();
+
+	return UpdateRect;
+}
+
+void KBuffer::ResolveIncremental( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera& _Camera )
+{
+	m_IsFrameRecorded = False;
+
+	// The growth of the fragment pool is read by the clear pass : the frames missing fragments are updated again once the pool has grown.
+	if( IsFragmentPoolUsed() )
+		ReadAllocatedFragmentsCount();
+
+	GetResolvedImage();
+
+	IncrementalSettings Settings = GetIncrementalSettings( _BackgroundColor, _Camera );
+
+	// Without clear, the resolved image is blended over the content of the target : the frame can only be fully resolved in the target.
+	PixelRect UpdateRect = _ClearTarget ? GetIncrementalUpdateRect( Settings ) : GetFullRect();
+	m_LastUpdatedPixelsCount = IsRectEmpty( UpdateRect ) ? 0 : ( UpdateRect.MaxX - UpdateRect.MinX ) * ( UpdateRect.MaxY - UpdateRect.MinY );
+
+	m_LastIncrementalSettings = Settings;
+	m_LastRecordedDraws.swap( m_RecordedDraws );
+	m_RecordedDraws.clear();
+
+	if( !IsRectEmpty( UpdateRect ) )
+	{
+		// Clear and store again the changed pixels only, the storage keeps the fragments of the other pixels.
+		m_DirtyRect = UpdateRect;
+
+		Bind();
+
+		ClearStoredFragments( True );
+
+		m_BatchedDraws.clear();
+		for( size_t i = 0; i < m_LastRecordedDraws.size(); i++ )
+		{
+			const RecordedDraw& Recorded = m_LastRecordedDraws[i];
+			PixelRect Rect = IntersectRects( Recorded.Rect, UpdateRect );
+
+			if( Recorded.Batch == 0 )
+			{
+				if( !IsRectEmpty( Rect ) )
+					StoreObject( *Recorded.Object, *Recorded.Camera, Rect );
+
+				continue;
+			}
+
+			// The objects of a batch are stored again with one batch, once its last object is reached.
+			if( !IsRectEmpty( Rect ) )
+				m_BatchedDraws.push_back( { Recorded.Object, Recorded.Camera, Rect } );
+
+			Bool IsBatchEnd = i + 1 == m_LastRecordedDraws.size() || m_LastRecordedDraws[i + 1].Batch != Recorded.Batch;
+			if( IsBatchEnd && !m_BatchedDraws.empty() )
+			{
+				StoreBatch( *Recorded.Camera );
+				m_BatchedDraws.clear();
+			}
+		}
+
+		Unbind();
+
+		if( !_ClearTarget )
+		{
+			m_IsResolvedImageValid = False;
+			ResolveStoredFragments( _Target, False, _BackgroundColor, _Camera );
+			return;
+		}
+
+		// The changed pixels of the resolved image are cleared to the background, the resolve pass only writes the pixels with fragments.
+		m_ResolvedImage->Bind();
+		EnableScissor( UpdateRect );
+		m_ResolvedImage->Clear( _BackgroundColor );
+		glDisable( GL_SCISSOR_TEST );
+		AE_ErrorCheckOpenGLError();
+		m_ResolvedImage->Unbind();
+
+		ResolveStoredFragments( *m_ResolvedImage, False, _BackgroundColor, _Camera );
+		m_IsResolvedImageValid = True;
+	}
+
+	BlitResolvedImage( _Target, GetFullRect(), m_LastIncrementalSettings.BackgroundColor );
+}
+
+ae::Framebuffer& KBuffer::GetGuideDepths()
+{
+	// Same headroom as the K-Buffer, at the size given to the resize.
+	// A new guide is cleared : the divisor can change between the clear pass and the draws or the resolve.
+	if( m_GuideDepths == nullptr || IsReallocationNeeded( m_OutputWidth, m_OutputHeight, m_GuideDepths->GetWidth(), m_GuideDepths->GetHeight() ) )
+	{
+		m_GuideDepths = std::make_unique<ae::Framebuffer>( GetAllocatedSize( m_OutputWidth ), GetAllocatedSize( m_OutputHeight ), 
+														   ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Depth, ae::TexturePixelFormat::Depth_F32, ae::TextureFilterMode::Nearest ) );
+
+		m_GuideDepths->Bind();
+		m_GuideDepths->Clear();
+		m_GuideDepths->Unbind();
+	}
+
+	return *m_GuideDepths;
+}
+
+void KBuffer::ClearGuideDepths()
+{
+	ae::Framebuffer& GuideDepths = GetGuideDepths();
+
+	// The clear pass is done with the K-Buffer bound.
+	GuideDepths.Bind();
+	GuideDepths.Clear();
+	GuideDepths.Unbind();
+
+	Bind();
+}
+
+void KBuffer::DrawGuideDepth( const ae::Drawable& _Object, ae::Camera& _Camera )
+{
+	// The guide replaces the K-Buffer for this draw only, with a viewport on the size given to the resize.
+	ae::Framebuffer& GuideDepths = GetGuideDepths();
+	GuideDepths.Bind();
+	glViewport( 0, 0, Cast( GLsizei, m_OutputWidth ), Cast( GLsizei, m_OutputHeight ) );
+
+	// Nearest depth of all the objects, opaque or not.
+	glEnable( GL_DEPTH_TEST );
+	glDepthFunc( GL_LESS );
+	glDepthMask( GL_TRUE );
+	AE_ErrorCheckOpenGLError();
+
+	// The opaque pass shader is used for its vertex stage : the guide has no color attachement.
+	m_OpaquePassShader.Bind();
+	_Camera.SendToShader( m_OpaquePassShader );
+
+	Uint32 TextureUnit = 0;
+	Uint32 ImageUnit = 7;
+	_Object.GetMaterial().SendParametersToShader( m_OpaquePassShader, TextureUnit, ImageUnit );
+	_Object.SendTransformToShader( m_OpaquePassShader );
+	SendViews( m_OpaquePassShader );
+
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	ae::Shader::SetBool( m_OpaquePassShader.GetUniformLocation( "HasInstanceAttributes" ), Instanced != nullptr );
+
+	if( Instanced != nullptr )
+		DrawInstances( _Object );
+	else
+		DrawVertexArray( _Object, _Object.GetPrimitiveType() );
+
+	m_OpaquePassShader.Unbind();
+	GuideDepths.Unbind();
+
+	// Back to the K-Buffer and its depth mode.
+	Bind();
+	ApplyDepthMode();
+}
+
+void KBuffer::ResolveUpsampled( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera& _Camera )
+{
+	// Without draw since the divisor changed, the guide is created empty : the upsampling is bilinear.
+	ae::Framebuffer& GuideDepths = GetGuideDepths();
+
+	// The low resolution image has the allocated size of the K-Buffer, its alpha is the coverage : 0 where no fragment is resolved.
+	if( m_LowResolutionImage == nullptr || m_LowResolutionImage->GetWidth() != GetWidth() || m_LowResolutionImage->GetHeight() != GetHeight() )
+		m_LowResolutionImage = std::make_unique<ae::Framebuffer>( GetWidth(), GetHeight(), 
+																  ae::FramebufferAttachement( ae::FramebufferAttachement::Type::Color_0, ae::TexturePixelFormat::RGBA_F16, ae::TextureFilterMode::Nearest ) );
+
+	m_LowResolutionImage->Bind();
+	m_LowResolutionImage->Clear( ae::Color( 0.0f, 0.0f, 0.0f, 0.0f ) );
+	m_LowResolutionImage->Unbind();
+
+	ResolveStoredFragments( *m_LowResolutionImage, False, _BackgroundColor, _Camera );
+
+	// The fragments written by the resolve pass are read by the upsampling.
+	glMemoryBarrier( GL_TEXTURE_FETCH_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	GraphicsShader& UpsampleShader = GetSharedShader( m_UpsampleShader, "ResolvePassVertex.glsl", "UpsampleCompositeFragment.glsl", "K-Buffer Upsample Shader" );
+
+	_Target.Bind();
+
+	if( _ClearTarget )
+		_Target.Clear( _BackgroundColor );
+
+	UpsampleShader.Bind();
+
+	// The camera near and far linearize the guide depths.
+	SendCamera( UpsampleShader, _Camera );
+
+	glActiveTexture( GL_TEXTURE0 );
+	m_LowResolutionImage->GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 )->Bind();
+	ae::Shader::SetInt( UpsampleShader.GetUniformLocation( "LowResolutionColors" ), 0 );
+
+	glActiveTexture( GL_TEXTURE1 );
+	GuideDepths.GetAttachementTexture( ae::FramebufferAttachement::Type::Depth )->Bind();
+	ae::Shader::SetInt( UpsampleShader.GetUniformLocation( "GuideDepths" ), 1 );
+
+	glActiveTexture( GL_TEXTURE0 );
+
+	ae::Shader::SetInt( UpsampleShader.GetUniformLocation( "ResolutionDivisor" ), Cast( Int32, m_ResolutionDivisor ) );
+	glUniform2i( UpsampleShader.GetUniformLocation( "LowResolutionSize" ), Cast( GLint, m_RenderWidth ), Cast( GLint, m_RenderHeight ) );
+	glUniform2i( UpsampleShader.GetUniformLocation( "OutputSize" ), Cast( GLint, m_OutputWidth ), Cast( GLint, m_OutputHeight ) );
+	AE_ErrorCheckOpenGLError();
+
+	// Premultiplied colors over the target, according to their coverage.
+	glEnable( GL_BLEND );
+	glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+
+	DrawVertexArray( m_FullscreenSprite, m_FullscreenSprite.GetPrimitiveType() );
+
+	glDisable( GL_BLEND );
+	AE_ErrorCheckOpenGLError();
+
+	UpsampleShader.Unbind();
+	_Target.Unbind();
+}
+
+ae::Framebuffer& KBuffer::GetResolvedImage()
+{
+	if( m_ResolvedImage == nullptr || m_ResolvedImage->GetWidth() != GetWidth() || m_ResolvedImage->GetHeight() != GetHeight() )
+	{
+		m_ResolvedImage = std::make_unique<ae::Framebuffer>( GetWidth(), GetHeight() );
+		m_IsResolvedImageValid = False;
+	}
+
+	return *m_ResolvedImage;
+}
+
+void KBuffer::BlitResolvedImage( ae::Framebuffer& _Target, const PixelRect& _SourceRect, const ae::Color& _BackgroundColor )
+{
+	// The framebuffers are only known once bound.
+	GLint ResolvedImageFramebuffer = 0;
+	m_ResolvedImage->Bind();
+	glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &ResolvedImageFramebuffer );
+	m_ResolvedImage->Unbind();
+
+	GLint TargetFramebuffer = 0;
+	_Target.Bind();
+	glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &TargetFramebuffer );
+
+	// The target is fully cleared like a resolve pass with clear, its depth included, before receiving the rendered pixels of the resolved image.
+	_Target.Clear( _BackgroundColor );
+	_Target.Unbind();
+
+	glBlitNamedFramebuffer( ResolvedImageFramebuffer, TargetFramebuffer, Cast( GLint, _SourceRect.MinX ), Cast( GLint, _SourceRect.MinY ), Cast( GLint, _SourceRect.MaxX ), Cast( GLint, _SourceRect.MaxY ),
+							0, 0, Cast( GLint, _Target.GetWidth() ), Cast( GLint, _Target.GetHeight() ), GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	AE_ErrorCheckOpenGLError();
+}
+
+void KBuffer::StoreCountedFragments()
+{
+	// Blocks of 1024 pixels, see PrefixSumCompute.glsl.
+	const Uint32 BlockSize = 1024;
+	Uint32 PixelsCount = GetWidth() * GetHeight();
+	Uint32 BlocksCount = ( PixelsCount + BlockSize - 1 ) / BlockSize;
+
+	// The counts of the first pass are read by the prefix sum.
+	glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	m_BlockSums.BindAsStorage( 5 );
+
+	for( size_t p = 0; p < m_PrefixSumShaders.size(); p++ )
+	{
+		ComputeShader& PrefixSumShader = GetPrefixSumShader( p );
+		PrefixSumShader.Bind();
+
+		BindStorage( PrefixSumShader, ae::TextureImageBindMode::ReadOnly );
+		ae::Shader::SetInt( PrefixSumShader.GetUniformLocation( "PixelsCount" ), Cast( Int32, PixelsCount ) );
+		ae::Shader::SetInt( PrefixSumShader.GetUniformLocation( "BlocksCount" ), Cast( Int32, BlocksCount ) );
+
+		// The block sums are scanned by one work group.
+		PrefixSumShader.Dispatch( p == 1 ? 1 : BlocksCount );
+
+		// Each pass reads the sums and offsets of the previous one.
+		glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+		AE_ErrorCheckOpenGLError();
+
+		PrefixSumShader.Unbind();
+	}
+
+
+	// Second pass : the counted objects are drawn again, each fragment takes a slot in the range of its pixel.
+	GraphicsShader& CountedShader = GetSharedShader( m_StorePassCountedShader, "StorePassVertex.glsl", "StorePassCountedFragment.glsl", "K-Buffer Store Pass Counted Shader" );
+
+	Bind();
+
+	for( const ReplayedDraw& Counted : m_ReplayedDraws )
+		DrawStorePass( *Counted.Object, *Counted.Camera, StorePassTargets::Storage, CountedShader, Counted.Rect );
+
+	Unbind();
+
+	m_ReplayedDraws.clear();
+}
+
+void KBuffer::AccumulateMomentFragments()
+{
+	// Second pass : the objects are drawn again, each fragment is weighted by the transmittance in front of it.
+	GraphicsShader& BlendShader = GetSharedShader( m_StorePassMomentsBlendShader, "StorePassVertex.glsl", "StorePassMomentsBlendFragment.glsl", "K-Buffer Store Pass Moments Blend Shader" );
+
+	Bind();
+
+	for( const ReplayedDraw& Replayed : m_ReplayedDraws )
+		DrawStorePass( *Replayed.Object, *Replayed.Camera, StorePassTargets::MomentsAccumulation, BlendShader, Replayed.Rect );
+
+	Unbind();
+
+	m_ReplayedDraws.clear();
+}
+
+KBuffer::ImageDifference KBuffer::MeasureDifference( const ae::Framebuffer& _Reference, const ae::Framebuffer& _Compared )
+{
+	ImageDifference Difference = { 0.0f, 0.0f, 0.0f };
+
+	const ae::Texture* ReferenceTexture = _Reference.GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 );
+	const ae::Texture* ComparedTexture = _Compared.GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 );
+	if( ReferenceTexture == nullptr || ComparedTexture == nullptr ||
+		ReferenceTexture->GetDimension() != ae::TextureDimension::Texture2D || ComparedTexture->GetDimension() != ae::TextureDimension::Texture2D )
+	{
+		AE_LogWarning( "The compared framebuffers must have a 2D color texture, no difference measured." );
+		return Difference;
+	}
+
+	// Work groups of 16x16 pixels, see ImageDifferenceCompute.glsl.
+	const Uint32 GroupSize = 16;
+	Uint32 Width = ae::Math::Min( _Reference.GetWidth(), _Compared.GetWidth() );
+	Uint32 Height = ae::Math::Min( _Reference.GetHeight(), _Compared.GetHeight() );
+	Uint32 GroupsX = ( Width + GroupSize - 1 ) / GroupSize;
+	Uint32 GroupsY = ( Height + GroupSize - 1 ) / GroupSize;
+	size_t GroupsCount = Cast( size_t, GroupsX ) * GroupsY;
+	if( GroupsCount == 0 )
+		return Difference;
+
+	if( m_ImageDifferenceShader == nullptr )
+	{
+		m_ImageDifferenceShader = std::make_unique<ComputeShader>( KBufferShadersDirectory + "ImageDifferenceCompute.glsl" );
+		m_ImageDifferenceShader->SetName( "K-Buffer Image Difference Shader" );
+	}
+
+	// Sum, squared sum and max of each work group.
+	m_DifferenceSums.Resize( GroupsCount * 4 * sizeof( float ) );
+	m_DifferenceSums.BindAsStorage( 0 );
+
+	m_ImageDifferenceShader->Bind();
+
+	glActiveTexture( GL_TEXTURE0 );
+	ReferenceTexture->Bind();
+	ae::Shader::SetInt( m_ImageDifferenceShader->GetUniformLocation( "ReferenceColors" ), 0 );
+
+	glActiveTexture( GL_TEXTURE1 );
+	ComparedTexture->Bind();
+	ae::Shader::SetInt( m_ImageDifferenceShader->GetUniformLocation( "ComparedColors" ), 1 );
+
+	glActiveTexture( GL_TEXTURE0 );
+	glUniform2i( m_ImageDifferenceShader->GetUniformLocation( "ImageSize" ), Cast( GLint, Width ), Cast( GLint, Height ) );
+	AE_ErrorCheckOpenGLError();
+
+	m_ImageDifferenceShader->Dispatch( GroupsX, GroupsY );
+	m_ImageDifferenceShader->Unbind();
+
+	// The sums are read back by a buffer command.
+	glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	std::vector<float> GroupSums( GroupsCount * 4 );
+	m_DifferenceSums.GetData( GroupSums.data(), GroupSums.size() * sizeof( float ) );
+
+	// The groups are summed in double : the sums of the large images lose precision in float.
+	double Sum = 0.0;
+	double SquaredSum = 0.0;
+	for( size_t g = 0; g < GroupsCount; g++ )
+	{
+		Sum += GroupSums[g * 4];
+		SquaredSum += GroupSums[g * 4 + 1];
+		Difference.MaxError = ae::Math::Max( Difference.MaxError, GroupSums[g * 4 + 2] );
+	}
+
+	double PixelsCount = Cast( double, Width ) * Height;
+	Difference.MeanError = Cast( float, Sum / PixelsCount );
+	Difference.RootMeanSquareError = Cast( float, std::sqrt( SquaredSum / PixelsCount ) );
+
+	return Difference;
+}
+
+void KBuffer::ResolveFullscreen( const ae::Color& _BackgroundColor, ae::Camera& _Camera )
+{
+	// Sort the fragment and process the final color the pixel.
+	GraphicsShader& ResolvePassShader = GetResolvePassShader();
+	ResolvePassShader.Bind();
+
+	// Apply the camera settings.
+	SendCamera( ResolvePassShader, _Camera );
+
+	SendResolveParameters( ResolvePassShader, _BackgroundColor, _Camera );
+
+
+	// Draw a fullscreen quad to process stored fragments, only in the pixels written by the frame : the other ones have nothing to resolve.
+	EnableScissor( m_DirtyRect );
+
+	DrawVertexArray( m_FullscreenSprite, m_FullscreenSprite.GetPrimitiveType() );
+
+	glDisable( GL_SCISSOR_TEST );
+	AE_ErrorCheckOpenGLError();
+
+	ResolvePassShader.Unbind();
+}
+
+void KBuffer::ResolveDebugView()
+{
+	GraphicsShader& DebugShader = GetSharedShader( m_ResolvePassDebugShader, "ResolvePassVertex.glsl", "ResolvePassDebugFragment.glsl", "K-Buffer Resolve Pass Debug Shader" );
+	DebugShader.Bind();
+
+	BindStorage( DebugShader, ae::TextureImageBindMode::ReadOnly );
+
+	// The debug shader is not specialized : K is always a uniform.
+	ae::Shader::SetInt( DebugShader.GetUniformLocation( "K" ), Cast( Int32, m_K ) );
+	ae::Shader::SetInt( DebugShader.GetUniformLocation( "DebugView" ), Cast( Int32, m_DebugView ) );
+	ae::Shader::SetFloat( DebugShader.GetUniformLocation( "HeatmapMaxValue" ), m_HeatmapMaxValue );
+
+	DrawVertexArray( m_FullscreenSprite, m_FullscreenSprite.GetPrimitiveType() );
+
+	DebugShader.Unbind();
+}
+
+void KBuffer::ResolveTiles( ae::Framebuffer& _Target, const ae::Color& _BackgroundColor, ae::Camera& _Camera )
+{
+	// Tiles of 8x8 pixels and 4 sorting networks, see ResolveTilesCommon.glsl.
+	const Uint32 TileSize = 8;
+	const size_t NetworksCount = 4;
+
+	// No tile has more than K fragments : the networks larger than K are not dispatched.
+	size_t UsedNetworksCount = 1;
+	while( ( 2u << ( UsedNetworksCount - 1 ) ) < m_K )
+		UsedNetworksCount++;
+
+	Uint32 ResolveWidth = ae::Math::Min( m_RenderWidth, _Target.GetWidth() );
+	Uint32 ResolveHeight = ae::Math::Min( m_RenderHeight, _Target.GetHeight() );
+	Uint32 TilesX = ( ResolveWidth + TileSize - 1 ) / TileSize;
+	Uint32 TilesY = ( ResolveHeight + TileSize - 1 ) / TileSize;
+	Int32 TilesCount = Cast( Int32, TilesX * TilesY );
+
+	// Indirect dispatch arguments (groups x, y, z and padding) of each network, followed by one list of tiles per network.
+	// The classification counts the tiles of each network in the groups x.
+	const Uint32 EmptyDispatch[4] = { 0, 1, 1, 0 };
+	size_t ArgumentsSize = NetworksCount * sizeof( EmptyDispatch );
+	m_ResolveTiles.Resize( ArgumentsSize + NetworksCount * TilesCount * sizeof( Uint32 ) );
+	for( size_t n = 0; n < NetworksCount; n++ )
+		m_ResolveTiles.SetData( EmptyDispatch, sizeof( EmptyDispatch ), n * sizeof( EmptyDispatch ) );
+
+	m_ResolveTiles.BindAsStorage( 3 );
+	_Target.GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 )->BindAsImage( 4, ae::TextureImageBindMode::WriteOnly );
+
+
+	// Classify the tiles by their maximum count.
+	ComputeShader& ClassifyShader = GetResolveClassifyShader();
+	ClassifyShader.Bind();
+
+	BindStorage( ClassifyShader, ae::TextureImageBindMode::ReadOnly );
+	BindOpaqueTextures( ClassifyShader );
+	ae::Shader::SetInt( ClassifyShader.GetUniformLocation( "TilesCount" ), TilesCount );
+	glUniform2i( ClassifyShader.GetUniformLocation( "ResolveSize" ), Cast( GLint, ResolveWidth ), Cast( GLint, ResolveHeight ) );
+
+	ClassifyShader.Dispatch( TilesX, TilesY );
+
+	// The lists and the dispatch arguments are written before being read.
+	glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+
+	// Sort and blend each list of tiles with its sorting network.
+	for( size_t n = 0; n < UsedNetworksCount; n++ )
+	{
+		ComputeShader& TileShader = GetResolveTileShader( n );
+		TileShader.Bind();
+
+		SendResolveParameters( TileShader, _BackgroundColor, _Camera );
+
+		ae::Shader::SetVector3( TileShader.GetUniformLocation( "CameraPosition" ), _Camera.GetPosition() );
+		ae::Shader::SetFloat( TileShader.GetUniformLocation( "CameraNear" ), _Camera.GetNear() );
+		ae::Shader::SetFloat( TileShader.GetUniformLocation( "CameraFar" ), _Camera.GetFar() );
+
+		ae::Shader::SetInt( TileShader.GetUniformLocation( "TilesCount" ), TilesCount );
+		ae::Shader::SetInt( TileShader.GetUniformLocation( "Network" ), Cast( Int32, n ) );
+		glUniform2i( TileShader.GetUniformLocation( "ResolveSize" ), Cast( GLint, ResolveWidth ), Cast( GLint, ResolveHeight ) );
+
+		TileShader.DispatchIndirect( m_ResolveTiles.GetBufferID(), n * sizeof( EmptyDispatch ) );
+	}
+
+	ClassifyShader.Unbind();
+
+	// The target is written with image stores : be sure they are visible to the next draws.
+	glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+}
+
+template<typename ShaderType>
+void KBuffer::SendResolveParameters( const ShaderType& _Shader, const ae::Color& _BackgroundColor, ae::Camera& _Camera )
+{
+	// Attach the K-Buffer textures and the material table.
+	BindStorage( _Shader, ae::TextureImageBindMode::ReadOnly );
+	m_Materials.BindAsStorage( 1 );
+
+	// The stored fragments are blended over the opaque color and the overflow tail.
+	BindOpaqueTextures( _Shader );
+	BindTailTextures( _Shader );
+
+
+	// Other needed data for the final color processing.
+
+	ae::Shader::SetColor( _Shader.GetUniformLocation( "BackgroundColor" ), _BackgroundColor );
+
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "ToneMap" ), m_IsToneMapped );
+	ae::Shader::SetFloat( _Shader.GetUniformLocation( "Exposure" ), m_Exposure );
+
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "GammaCorrection" ), m_IsGammaCorrected );
+	ae::Shader::SetFloat( _Shader.GetUniformLocation( "Gamma" ), m_Gamma );
+
+	// The positions are not stored, they are rebuilt from the depths with the camera of the view of the pixel.
+	// Shaders multiply the vectors on the left : the inverse of the shader view projection is the inverse of Projection * View.
+	for( Uint32 v = 0; v < GetViewsCount(); v++ )
+	{
+		ae::Camera& ViewCamera = IsMultiView() ? *m_Views[v] : _Camera;
+		ae::Matrix4x4 InverseViewProjection = ( ViewCamera.GetProjectionMatrix() * ViewCamera.GetLookAtMatrix() ).GetInverse();
+		ae::Shader::SetMatrix4x4( _Shader.GetUniformLocation( "InverseViewProjection[" + std::to_string( v ) + "]" ), InverseViewProjection );
+	}
+
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "ViewsCount" ), Cast( Int32, GetViewsCount() ) );
+	ae::Shader::SetVector2( _Shader.GetUniformLocation( "ViewSize" ), ae::Vector2( Cast( float, m_RenderWidth / GetViewsCount() ), Cast( float, m_RenderHeight ) ) );
+}
+
+void KBuffer::UpdateStorage()
+{
+	// Only the storage of the current insertion mode and layout is allocated at full size, the other ones are reduced to the minimum.
+	Bool IsLocked = m_InsertionMode == InsertionMode::Locked;
+	Bool IsLockFree = m_InsertionMode == InsertionMode::LockFree;
+	Bool IsLinkedList = m_InsertionMode == InsertionMode::LinkedList;
+	Bool IsCounted = m_InsertionMode == InsertionMode::Counted;
+	Bool UseImages = IsLocked && m_StorageLayout == StorageLayout::LayerMajorImages;
+	Bool UseBuffer = IsLocked && m_StorageLayout == StorageLayout::PixelMajorBuffer;
+
+	Uint32 ImagesWidth = UseImages ? GetWidth() : 1;
+	Uint32 ImagesHeight = UseImages ? GetHeight() : 1;
+	Uint32 ImagesDepth = UseImages ? m_KCapacity : 1;
+
+	// The semaphores are only needed when the critical section is not done with the interlock.
+	Bool UseSemaphores = IsLocked && !m_UseInterlock;
+	m_Semaphores.Resize( UseSemaphores ? GetWidth() : 1, UseSemaphores ? GetHeight() : 1 );
+
+	// The counted mode counts the fragments in the counts image.
+	m_Counts.Resize( IsCounted ? GetWidth() : ImagesWidth, IsCounted ? GetHeight() : ImagesHeight );
+	m_MaterialIndices.Resize( ImagesWidth, ImagesHeight, ImagesDepth );
+	m_Depths.Resize( ImagesWidth, ImagesHeight, ImagesDepth );
+
+	size_t PackedFragmentsSize = IsLockFree ? GetStoragePixelsCount() * m_KCapacity * sizeof( Uint64 ) : 0;
+	m_PackedFragments.Resize( PackedFragmentsSize );
+
+	// A count and K records of 2 words per pixel, see FragmentsBufferCommon.glsl. The storage is allocated for the K capacity, the current K uses its beginning.
+	// The tile-sparse pool starts with pages for a quarter of the tiles, it grows with the draws and is shrunk by the clear pass.
+	Bool IsTileSparse = UseBuffer && m_IsTileSparse;
+	m_PagesCapacity = IsTileSparse ? ae::Math::Max( 1u, GetTilesCount() / 4 ) : 0;
+	m_UsedPagesCount = 0;
+	m_UnderusedPagesFramesCount = 0;
+	m_UnderusedPagesPeak = 0;
+
+	size_t FragmentsPixelsCount = IsTileSparse ? Cast( size_t, m_PagesCapacity ) * TilePixelsCount : GetStoragePixelsCount();
+	size_t FragmentsSize = UseBuffer ? FragmentsPixelsCount * ( 1 + 2 * m_KCapacity ) * sizeof( Uint32 ) : 0;
+	m_Fragments.Resize( FragmentsSize );
+
+	// A page per tile, no page until the clear pass.
+	m_TilePages.Resize( IsTileSparse ? GetTilesCount() * sizeof( Uint32 ) : 0 );
+	m_TilePagesTable.assign( IsTileSparse ? GetTilesCount() : 0, NoTilePage );
+
+	// A head per pixel for the linked lists, see LinkedListCommon.glsl.
+	m_ListHeads.Resize( IsLinkedList ? GetStoragePixelsCount() * sizeof( Uint32 ) : 0 );
+	m_FragmentPool.Resize( GetFragmentPoolSize() );
+
+	// An offset per pixel in rows and the total count, and a sum per block of 1024 pixels, see PrefixSumCompute.glsl.
+	size_t PixelsCount = Cast( size_t, GetWidth() ) * GetHeight();
+	m_CountedOffsets.Resize( IsCounted ? ( PixelsCount + 1 ) * sizeof( Uint32 ) : 0 );
+	m_BlockSums.Resize( IsCounted ? ( PixelsCount + 1023 ) / 1024 * sizeof( Uint32 ) : 0 );
+
+	UpdateBlendedTargets();
+
+	// The content of the storage and of the targets is undefined : they must be fully cleared before the next frame.
+	m_Generation = 0;
+	m_DirtyRect = GetFullRect();
+}
+
+void KBuffer::UpdateBlendedTargets()
+{
+	// The accumulations and the revealages are blended by the overflow tail and the cheaper techniques, the power moments by the moment based OIT only.
+	Bool UseBlendedTargets = AreBlendedTargetsUsed();
+	Bool UseMoments = m_TransparencyTechnique == TransparencyTechnique::MomentBased;
+
+	m_BlendedAccumulations.Resize( UseBlendedTargets ? GetWidth() : 1, UseBlendedTargets ? GetHeight() : 1 );
+	m_BlendedRevealages.Resize( UseBlendedTargets ? GetWidth() : 1, UseBlendedTargets ? GetHeight() : 1 );
+	m_PowerMoments.Resize( UseMoments ? GetWidth() : 1, UseMoments ? GetHeight() : 1 );
+}
+
+KBuffer::PixelRect KBuffer::GetFullRect() const
+{
+	return { 0, 0, m_RenderWidth, m_RenderHeight };
+}
+
+KBuffer::PixelRect KBuffer::GetAllocatedRect() const
+{
+	return { 0, 0, GetWidth(), GetHeight() };
+}
+
+Uint32 KBuffer::GetAllocatedSize( Uint32 _Size )
+{
+	const Uint32 Step = 64;
+	Uint32 Size = _Size + _Size / 8;
+
+	return ae::Math::Max( Step, ( Size + Step - 1 ) / Step * Step );
+}
+
+KBuffer::PixelRect KBuffer::GetScreenRect( const ae::Drawable& _Object, ae::Camera& _Camera, const PixelRect& _ViewRect )
+{
+	if( !m_UseScissor )
+		return _ViewRect;
+
+	// The instances of an instanced drawable are bounded together in world space.
+	ae::Vector3 BoundsMin;
+	ae::Vector3 BoundsMax;
+	Bool AreBoundsValid = False;
+
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	if( Instanced != nullptr )
+	{
+		AreBoundsValid = Instanced->GetInstancesBounds( BoundsMin, BoundsMax );
+	}
+	else
+	{
+		const LocalBounds& Bounds = GetLocalBounds( _Object );
+		AreBoundsValid = Bounds.IsValid;
+		BoundsMin = Bounds.Min;
+		BoundsMax = Bounds.Max;
+	}
+
+	// Unknown bounds, or not read back yet : the whole view is written.
+	if( !AreBoundsValid )
+		return _ViewRect;
+
+	ae::Matrix4x4 ModelViewProjection = GetModelViewProjection( _Object, _Camera );
+
+	float MinX = 1.0f;
+	float MinY = 1.0f;
+	float MaxX = -1.0f;
+	float MaxY = -1.0f;
+	for( Uint32 Corner = 0; Corner < 8; Corner++ )
+	{
+		ae::Vector3 Position( Corner & 1 ? BoundsMax.X : BoundsMin.X, Corner & 2 ? BoundsMax.Y : BoundsMin.Y, Corner & 4 ? BoundsMax.Z : BoundsMin.Z );
+
+		float ClipPosition[4];
+		for( Uint32 Row = 0; Row < 4; Row++ )
+			ClipPosition[Row] = ModelViewProjection( Row, 0 ) * Position.X + ModelViewProjection( Row, 1 ) * Position.Y + ModelViewProjection( Row, 2 ) * Position.Z + ModelViewProjection( Row, 3 );
+
+		// A corner behind the camera does not project : the object may cover the whole view.
+		if( ClipPosition[3] <= 1e-6f )
+			return _ViewRect;
+
+		MinX = ae::Math::Min( MinX, ClipPosition[0] / ClipPosition[3] );
+		MinY = ae::Math::Min( MinY, ClipPosition[1] / ClipPosition[3] );
+		MaxX = ae::Math::Max( MaxX, ClipPosition[0] / ClipPosition[3] );
+		MaxY = ae::Math::Max( MaxY, ClipPosition[1] / ClipPosition[3] );
+	}
+
+	// From the normalized device coordinates to the pixels, one more pixel on each side for the rasterization rules.
+	float Width = Cast( float, _ViewRect.MaxX - _ViewRect.MinX );
+	float Height = Cast( float, _ViewRect.MaxY - _ViewRect.MinY );
+	float PixelMinX = ae::Math::Clamp( 0.0f, Width, std::floor( ( MinX * 0.5f + 0.5f ) * Width ) - 1.0f );
+	float PixelMinY = ae::Math::Clamp( 0.0f, Height, std::floor( ( MinY * 0.5f + 0.5f ) * Height ) - 1.0f );
+	float PixelMaxX = ae::Math::Clamp( 0.0f, Width, std::ceil( ( MaxX * 0.5f + 0.5f ) * Width ) + 1.0f );
+	float PixelMaxY = ae::Math::Clamp( 0.0f, Height, std::ceil( ( MaxY * 0.5f + 0.5f ) * Height ) + 1.0f );
+
+	return { _ViewRect.MinX + Cast( Uint32, PixelMinX ), _ViewRect.MinY + Cast( Uint32, PixelMinY ), _ViewRect.MinX + Cast( Uint32, PixelMaxX ), _ViewRect.MinY + Cast( Uint32, PixelMaxY ) };
+}
+
+Bool KBuffer::IsMultiView() const
+{
+	return m_Views.size() > 1;
+}
+
+Bool KBuffer::IsUpsampled() const
+{
+	return m_ResolutionDivisor > 1 && !IsMultiView();
+}
+
+KBuffer::PixelRect KBuffer::GetViewRect( Uint32 _View ) const
+{
+	Uint32 ViewWidth = m_RenderWidth / GetViewsCount();
+
+	return { _View * ViewWidth, 0, ( _View + 1 ) * ViewWidth, m_RenderHeight };
+}
+
+template<typename ShaderType>
+void KBuffer::SendViews( const ShaderType& _Shader )
+{
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "ViewsCount" ), Cast( Int32, GetViewsCount() ) );
+	if( !IsMultiView() )
+		return;
+
+	// Shaders multiply the vectors on the left : the shader view projection is Projection * View.
+	for( Uint32 v = 0; v < GetViewsCount(); v++ )
+		ae::Shader::SetMatrix4x4( _Shader.GetUniformLocation( "ViewProjection[" + std::to_string( v ) + "]" ), m_Views[v]->GetProjectionMatrix() * m_Views[v]->GetLookAtMatrix() );
+}
+
+void KBuffer::SendCamera( const ae::Shader& _Shader, ae::Camera& _Camera )
+{
+	_Camera.SendToShader( _Shader );
+}
+
+void KBuffer::SendCamera( const GraphicsShader& _Shader, ae::Camera& _Camera )
+{
+	// The viewport is the one of the K-Buffer passes, set when their target is bound.
+	ae::Shader::SetMatrix4x4( _Shader.GetUniformLocation( "View" ), _Camera.GetLookAtMatrix() );
+	ae::Shader::SetMatrix4x4( _Shader.GetUniformLocation( "Projection" ), _Camera.GetProjectionMatrix() );
+	ae::Shader::SetVector3( _Shader.GetUniformLocation( "CameraPosition" ), _Camera.GetPosition() );
+	ae::Shader::SetFloat( _Shader.GetUniformLocation( "CameraNear" ), _Camera.GetNear() );
+	ae::Shader::SetFloat( _Shader.GetUniformLocation( "CameraFar" ), _Camera.GetFar() );
+}
+
+void KBuffer::SendObject( const ae::Shader& _Shader, const ae::Drawable& _Object )
+{
+	// Attach the material shader to OpenGL and send its parameters.
+	Uint32 TextureUnit = 0;
+	Uint32 ImageUnit = 7;
+	_Object.GetMaterial().SendParametersToShader( _Shader, TextureUnit, ImageUnit );
+
+	// Send object transform if there is.
+	_Object.SendTransformToShader( _Shader );
+}
+
+void KBuffer::SendObject( const GraphicsShader& _Shader, const ae::Drawable& _Object )
+{
+	// Same transform and material index as the per instance attributes of the batches.
+	const StorePassMaterial* ObjectMaterial = dynamic_cast<const StorePassMaterial*>( &_Object.GetMaterial() );
+	Int32 MaterialIndex = ObjectMaterial != nullptr ? ae::Math::Max( 0, ObjectMaterial->GetMaterialIndex().GetValue() ) : 0;
+
+	ae::Shader::SetMatrix4x4( _Shader.GetUniformLocation( "Model" ), GetModelMatrix( _Object ) );
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "MaterialIndex" ), MaterialIndex );
+}
+
+void KBuffer::DrawInstances( const ae::Drawable& _Object )
+{
+	// The instances of an instanced drawable are repeated for every view : the attributes of an instance are read by as many instances of the draw as there are views.
+	Uint32 InstancesCount = GetViewsCount();
+
+	const InstancedDrawable* Instanced = dynamic_cast<const InstancedDrawable*>( &_Object );
+	if( Instanced != nullptr )
+	{
+		Instanced->BindInstances( GetViewsCount() );
+		InstancesCount *= Instanced->GetInstancesCount();
+	}
+
+	// The clip distances of the vertex shader cut the primitives at the borders of their view.
+	if( IsMultiView() )
+	{
+		glEnable( GL_CLIP_DISTANCE0 );
+		glEnable( GL_CLIP_DISTANCE1 );
+	}
+
+	glBindVertexArray( _Object.GetVertexArrayObject() );
+	glDrawElementsInstanced( Cast( GLenum, _Object.GetPrimitiveType() ), Cast( GLsizei, _Object.GetIndicesCount() ), GL_UNSIGNED_INT, nullptr, Cast( GLsizei, InstancesCount ) );
+	glBindVertexArray( 0 );
+
+	if( IsMultiView() )
+	{
+		glDisable( GL_CLIP_DISTANCE0 );
+		glDisable( GL_CLIP_DISTANCE1 );
+	}
+
+	AE_ErrorCheckOpenGLError();
+}
+
+const KBuffer::LocalBounds& KBuffer::GetLocalBounds( const ae::Drawable& _Object )
+{
+	Uint32 VertexBuffer = _Object.GetVertexBufferObject();
+	LocalBounds& Bounds = m_LocalBounds[&_Object];
+
+	// Only the 3D vertices have a known layout.
+	if( VertexBuffer == 0 || _Object.GetAttributePointerTags() != ae::Drawable::AttributePointer::Default3D )
+	{
+		ReleaseBoundsReadback( Bounds );
+		Bounds.VertexBuffer = 0;
+		Bounds.IsValid = False;
+		return Bounds;
+	}
+
+	GLint64 BufferSize = 0;
+	glGetNamedBufferParameteri64v( VertexBuffer, GL_BUFFER_SIZE, &BufferSize );
+	AE_ErrorCheckOpenGLError();
+
+	// New or reallocated buffer : the vertices are copied on the GPU and read once the copy is done, the updates in place are signaled by InvalidateMesh.
+	if( Bounds.VertexBuffer != VertexBuffer || Bounds.BufferSize != BufferSize )
+	{
+		ReleaseBoundsReadback( Bounds );
+		Bounds.VertexBuffer = VertexBuffer;
+		Bounds.BufferSize = BufferSize;
+		Bounds.IsValid = False;
+
+		size_t VerticesSize = Cast( size_t, BufferSize ) / sizeof( ae::Vertex3D ) * sizeof( ae::Vertex3D );
+		if( VerticesSize == 0 )
+			return Bounds;
+
+		Bounds.Readback = std::make_unique<GPUBuffer>( VerticesSize );
+		glCopyNamedBufferSubData( VertexBuffer, Bounds.Readback->GetBufferID(), 0, 0, Cast( GLsizeiptr, VerticesSize ) );
+		Bounds.Fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		AE_ErrorCheckOpenGLError();
+	}
+
+	if( Bounds.Fence == nullptr )
+		return Bounds;
+
+	// Never wait for the GPU : until the copy is done, the bounds are unknown and the object is not scissored.
+	GLint SyncStatus = GL_UNSIGNALED;
+	glGetSynciv( Bounds.Fence, GL_SYNC_STATUS, 1, nullptr, &SyncStatus );
+	AE_ErrorCheckOpenGLError();
+
+	if( SyncStatus != GL_SIGNALED )
+		return Bounds;
+
+	std::vector<ae::Vertex3D> Vertices( Bounds.Readback->GetSize() / sizeof( ae::Vertex3D ) );
+	Bounds.Readback->GetData( Vertices.data(), Vertices.size() * sizeof( ae::Vertex3D ) );
+	ReleaseBoundsReadback( Bounds );
+
+	Bounds.IsValid = True;
+
+	Bounds.Min = Vertices[0].Position;
+	Bounds.Max = Vertices[0].Position;
+	for( const ae::Vertex3D& Vertex : Vertices )
+	{
+		Bounds.Min = ae::Vector3( ae::Math::Min( Bounds.Min.X, Vertex.Position.X ), ae::Math::Min( Bounds.Min.Y, Vertex.Position.Y ), ae::Math::Min( Bounds.Min.Z, Vertex.Position.Z ) );
+		Bounds.Max = ae::Vector3( ae::Math::Max( Bounds.Max.X, Vertex.Position.X ), ae::Math::Max( Bounds.Max.Y, Vertex.Position.Y ), ae::Math::Max( Bounds.Max.Z, Vertex.Position.Z ) );
+	}
+
+	return Bounds;
+}
+
+void KBuffer::ReleaseBoundsReadback( LocalBounds& _Bounds )
+{
+	if( _Bounds.Fence != nullptr )
+		glDeleteSync( _Bounds.Fence );
+
+	_Bounds.Fence = nullptr;
+	_Bounds.Readback.reset();
+}
+
+void KBuffer::InvalidateMesh( const ae::Drawable& _Object )
+{
+	// The mesh is copied again in the batch arena by the next batch drawing it.
+	m_BatchMeshes.erase( &_Object );
+
+	auto Bounds = m_LocalBounds.find( &_Object );
+	if( Bounds == m_LocalBounds.end() )
+		return;
+
+	ReleaseBoundsReadback( Bounds->second );
+	m_LocalBounds.erase( Bounds );
+}
+
+ae::Matrix4x4 KBuffer::GetModelViewProjection( const ae::Drawable& _Object, ae::Camera& _Camera )
+{
+	// Same transform as the store pass vertex shader.
+	return _Camera.GetProjectionMatrix() * _Camera.GetLookAtMatrix() * GetModelMatrix( _Object );
+}
+
+ae::Matrix4x4 KBuffer::GetModelMatrix( const ae::Drawable& _Object )
+{
+	// The objects without transform are in world space.
+	// The matrix of a transform is only updated on demand : it is not const.
+	const ae::TransformableDrawable3D* Transformable = dynamic_cast<const ae::TransformableDrawable3D*>( &_Object );
+	return Transformable != nullptr ? const_cast<ae::TransformableDrawable3D*>( Transformable )->GetMatrix() : ae::Matrix4x4::Identity;
+}
+
+KBuffer::PixelRect KBuffer::UniteRects( const PixelRect& _RectA, const PixelRect& _RectB )
+{
+	if( IsRectEmpty( _RectA ) )
+		return _RectB;
+
+	if( IsRectEmpty( _RectB ) )
+		return _RectA;
+
+	return { ae::Math::Min( _RectA.MinX, _RectB.MinX ), ae::Math::Min( _RectA.MinY, _RectB.MinY ), ae::Math::Max( _RectA.MaxX, _RectB.MaxX ), ae::Math::Max( _RectA.MaxY, _RectB.MaxY ) };
+}
+
+KBuffer::PixelRect KBuffer::IntersectRects( const PixelRect& _RectA, const PixelRect& _RectB )
+{
+	return { ae::Math::Max( _RectA.MinX, _RectB.MinX ), ae::Math::Max( _RectA.MinY, _RectB.MinY ), ae::Math::Min( _RectA.MaxX, _RectB.MaxX ), ae::Math::Min( _RectA.MaxY, _RectB.MaxY ) };
+}
+
+Bool KBuffer::IsRectEmpty( const PixelRect& _Rect )
+{
+	return _Rect.MinX >= _Rect.MaxX || _Rect.MinY >= _Rect.MaxY;
+}
+
+void KBuffer::EnableScissor( const PixelRect& _Rect )
+{
+	glEnable( GL_SCISSOR_TEST );
+	glScissor( Cast( GLint, _Rect.MinX ), Cast( GLint, _Rect.MinY ), Cast( GLsizei, _Rect.MaxX > _Rect.MinX ? _Rect.MaxX - _Rect.MinX : 0 ), Cast( GLsizei, _Rect.MaxY > _Rect.MinY ? _Rect.MaxY - _Rect.MinY : 0 ) );
+	AE_ErrorCheckOpenGLError();
+}
+
+size_t KBuffer::ClearLockedStorage( const PixelRect& _Rect )
+{
+	size_t ClearedSize = 0;
+
+	Uint32 Width = _Rect.MaxX > _Rect.MinX ? _Rect.MaxX - _Rect.MinX : 0;
+	Uint32 Height = _Rect.MaxY > _Rect.MinY ? _Rect.MaxY - _Rect.MinY : 0;
+	if( Width == 0 || Height == 0 )
+		return 0;
+
+	// The interlock does not need the semaphores.
+	if( !m_UseInterlock )
+	{
+		glClearTexSubImage( m_Semaphores.GetTextureID(), 0, _Rect.MinX, _Rect.MinY, 0, Width, Height, 1, 
+							ae::ToGLFormat( m_Semaphores.GetFormat() ), ae::ToGLType( m_Semaphores.GetFormat() ), nullptr );
+		AE_ErrorCheckOpenGLError();
+
+		ClearedSize += Cast( size_t, Width ) * Height * sizeof( Uint32 );
+	}
+
+	// Pixel-major layout : the counts and the fragments are in the same buffer, the pixels of the current K are at its beginning.
+	if( m_StorageLayout == StorageLayout::PixelMajorBuffer )
+	{
+		size_t FragmentsSize = GetStoragePixelsCount() * ( 1 + 2 * m_K ) * sizeof( Uint32 );
+		m_Fragments.Clear( 0, FragmentsSize );
+
+		ClearedSize += ae::Math::Min( FragmentsSize, m_Fragments.GetSize() );
+	}
+
+	else
+	{
+		glClearTexSubImage( m_Counts.GetTextureID(), 0, _Rect.MinX, _Rect.MinY, 0, Width, Height, 1,
+							ae::ToGLFormat( m_Counts.GetFormat() ), ae::ToGLType( m_Counts.GetFormat() ), nullptr );
+		AE_ErrorCheckOpenGLError();
+
+		// Only the K first layers are used, the other ones are allocated for a larger K.
+		Uint32 LayersCount = ae::Math::Min( m_K, m_Depths.GetDepth() );
+
+		glClearTexSubImage( m_MaterialIndices.GetTextureID(), 0, _Rect.MinX, _Rect.MinY, 0, Width, Height, LayersCount,
+							ae::ToGLFormat( m_MaterialIndices.GetFormat() ), ae::ToGLType( m_MaterialIndices.GetFormat() ), nullptr );
+		AE_ErrorCheckOpenGLError();
+
+
+		float DepthClear = 1.0f;
+		glClearTexSubImage( m_Depths.GetTextureID(), 0, _Rect.MinX, _Rect.MinY, 0, Width, Height, LayersCount,
+							ae::ToGLFormat( m_Depths.GetFormat() ), ae::ToGLType( m_Depths.GetFormat() ),  &DepthClear );
+		AE_ErrorCheckOpenGLError();
+
+		// Counts (r32ui), material indices (r16ui) and depths (r32f).
+		ClearedSize += Cast( size_t, Width ) * Height * sizeof( Uint32 );
+		ClearedSize += Cast( size_t, Width ) * Height * LayersCount * ( 2 + 4 );
+	}
+
+	return ClearedSize;
+}
+
+Bool KBuffer::IsTileSparseActive() const
+{
+	return m_IsTileSparse && m_TransparencyTechnique == TransparencyTechnique::KBuffer && m_InsertionMode == InsertionMode::Locked && m_StorageLayout == StorageLayout::PixelMajorBuffer;
+}
+
+Uint32 KBuffer::GetTilesCount() const
+{
+	return ( ( GetWidth() + TileSize - 1 ) / TileSize ) * ( ( GetHeight() + TileSize - 1 ) / TileSize );
+}
+
+size_t KBuffer::ResetTilePages()
+{
+	// The pool grows during the draws, it only shrinks once less than a quarter is used for many frames in a row :
+	// a frame with a small coverage between larger ones does not reallocate it. It keeps 1/8 of headroom over the largest of these frames.
+	if( m_UsedPagesCount * 4 < m_PagesCapacity )
+	{
+		m_UnderusedPagesPeak = ae::Math::Max( m_UnderusedPagesPeak, m_UsedPagesCount );
+		m_UnderusedPagesFramesCount++;
+	}
+	else
+	{
+		m_UnderusedPagesPeak = 0;
+		m_UnderusedPagesFramesCount = 0;
+	}
+
+	if( m_UnderusedPagesFramesCount >= PagesShrinkFramesCount )
+	{
+		m_PagesCapacity = ae::Math::Clamp( 1u, GetTilesCount(), m_UnderusedPagesPeak + m_UnderusedPagesPeak / 8 );
+		m_Fragments.Resize( Cast( size_t, m_PagesCapacity ) * TilePixelsCount * ( 1 + 2 * m_KCapacity ) * sizeof( Uint32 ) );
+
+		m_UnderusedPagesPeak = 0;
+		m_UnderusedPagesFramesCount = 0;
+	}
+
+	m_LastUsedPagesCount = m_UsedPagesCount;
+	m_UsedPagesCount = 0;
+
+	std::fill( m_TilePagesTable.begin(), m_TilePagesTable.end(), NoTilePage );
+	m_TilePages.Clear( NoTilePage );
+
+	return m_TilePages.GetSize();
+}
+
+void KBuffer::AllocateTilePages( const PixelRect& _Rect )
+{
+	if( IsRectEmpty( _Rect ) )
+		return;
+
+	Uint32 TilesPerRow = ( GetWidth() + TileSize - 1 ) / TileSize;
+	Uint32 MinTileX = _Rect.MinX / TileSize;
+	Uint32 MaxTileX = ( _Rect.MaxX + TileSize - 1 ) / TileSize;
+	Uint32 MinTileY = _Rect.MinY / TileSize;
+	Uint32 MaxTileY = ( _Rect.MaxY + TileSize - 1 ) / TileSize;
+
+	// The pool grows before the tiles of the object miss a page.
+	Uint32 MissingPagesCount = 0;
+	for( Uint32 y = MinTileY; y < MaxTileY; y++ )
+	{
+		for( Uint32 x = MinTileX; x < MaxTileX; x++ )
+		{
+			if( m_TilePagesTable[y * TilesPerRow + x] == NoTilePage )
+				MissingPagesCount++;
+		}
+	}
+
+	if( m_UsedPagesCount + MissingPagesCount > m_PagesCapacity )
+		GrowTilePages( m_UsedPagesCount + MissingPagesCount );
+
+	// The new pages follow the pages of the previous objects : they are contiguous in the pool and cleared at once.
+	Uint32 FirstNewPage = m_UsedPagesCount;
+
+	for( Uint32 y = MinTileY; y < MaxTileY; y++ )
+	{
+		Uint32 RowStart = y * TilesPerRow;
+		Bool IsRowChanged = False;
+
+		for( Uint32 x = MinTileX; x < MaxTileX; x++ )
+		{
+			Uint32& Page = m_TilePagesTable[RowStart + x];
+			if( Page != NoTilePage )
+				continue;
+
+			// The pool holds a page for every tile at most : it is never full once grown.
+			if( m_UsedPagesCount == m_PagesCapacity )
+				continue;
+
+			Page = m_UsedPagesCount++;
+			IsRowChanged = True;
+		}
+
+		if( IsRowChanged )
+			m_TilePages.SetData( &m_TilePagesTable[RowStart + MinTileX], ( MaxTileX - MinTileX ) * sizeof( Uint32 ), ( RowStart + MinTileX ) * sizeof( Uint32 ) );
+	}
+
+	if( m_UsedPagesCount == FirstNewPage )
+		return;
+
+	// The count of every pixel of the new pages to 0, the records are never read before being written.
+	size_t PageSize = TilePixelsCount * ( 1 + 2 * m_K ) * sizeof( Uint32 );
+	m_Fragments.Clear( 0, ( m_UsedPagesCount - FirstNewPage ) * PageSize, FirstNewPage * PageSize );
+	m_LastClearSize += ( m_UsedPagesCount - FirstNewPage ) * PageSize;
+}
+
+void KBuffer::GrowTilePages( Uint32 _PagesCount )
+{
+	// Doubled at least, so that the objects of a frame growing its coverage do not reallocate the pool one after the other.
+	Uint32 Capacity = ae::Math::Clamp( 1u, GetTilesCount(), ae::Math::Max( _PagesCount + _PagesCount / 8, m_PagesCapacity * 2 ) );
+	if( Capacity <= m_PagesCapacity )
+		return;
+
+	// The reallocation loses the content : the pages given to the tiles are copied out and back, the objects already stored keep their fragments.
+	size_t UsedPagesSize = m_UsedPagesCount * TilePixelsCount * ( 1 + 2 * m_K ) * sizeof( Uint32 );
+	GPUBuffer UsedPages( UsedPagesSize );
+	if( UsedPagesSize > 0 )
+	{
+		glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+		m_Fragments.CopyTo( UsedPages, UsedPagesSize );
+	}
+
+	m_PagesCapacity = Capacity;
+	m_Fragments.Resize( Cast( size_t, m_PagesCapacity ) * TilePixelsCount * ( 1 + 2 * m_KCapacity ) * sizeof( Uint32 ) );
+
+	if( UsedPagesSize > 0 )
+		UsedPages.CopyTo( m_Fragments, UsedPagesSize );
+
+	AE_ErrorCheckOpenGLError();
+}
+
+void KBuffer::ReadAllocatedFragmentsCount()
+{
+	if( m_AllocatedCountFence == nullptr )
+		return;
+
+	// Never wait for the GPU : the count is read at the next frame if the copy is not finished.
+	GLint SyncStatus = GL_UNSIGNALED;
+	glGetSynciv( m_AllocatedCountFence, GL_SYNC_STATUS, 1, nullptr, &SyncStatus );
+	AE_ErrorCheckOpenGLError();
+
+	if( SyncStatus != GL_SIGNALED )
+		return;
+
+	glDeleteSync( m_AllocatedCountFence );
+	m_AllocatedCountFence = nullptr;
+
+	m_AllocatedCountReadback.GetData( &m_LastAllocatedFragmentsCount, sizeof( Uint32 ) );
+
+	if( m_PoolOverflowPolicy != PoolOverflowPolicy::Grow || m_LastAllocatedFragmentsCount <= m_FragmentPoolCapacity )
+		return;
+
+	// 25% more than the overflowing frame, to avoid a new allocation at each small increase of the depth complexity.
+	m_FragmentPoolCapacity = m_LastAllocatedFragmentsCount + m_LastAllocatedFragmentsCount / 4;
+	m_FragmentPool.Resize( GetFragmentPoolSize() );
+}
+
+Bool KBuffer::IsAdaptiveKActive() const
+{
+	return m_IsKAdaptive && m_TransparencyTechnique == TransparencyTechnique::KBuffer && ( m_InsertionMode == InsertionMode::Locked || m_InsertionMode == InsertionMode::LockFree );
+}
+
+void KBuffer::BeginProfiledFrame()
+{
+	// The queries of a frame are reused once the GPU is done with it : at most two profiled frames are pending, the other frames are not profiled.
+	ProfiledFrame& Frame = m_ProfiledFrames[m_NextProfiledFrame];
+	m_IsFrameProfiled = ( m_IsProfiled || IsAdaptiveKActive() ) && Frame.Fence == nullptr;
+	if( !m_IsFrameProfiled )
+		return;
+
+	Frame.TimeStampsCount = 0;
+	Frame.K = m_K;
+
+	// Start of the clear pass.
+	WriteTimeStamp();
+
+	m_Statistics.Clear( 0 );
+}
+
+void KBuffer::EndProfiledFrame()
+{
+	ProfiledFrame& Frame = m_ProfiledFrames[m_NextProfiledFrame];
+
+	// End of the resolve pass.
+	WriteTimeStamp();
+
+	// The store pass is finished : the barrier of the resolve pass makes its counters visible to the buffer commands.
+	m_Statistics.CopyTo( Frame.StatisticsReadback, m_Statistics.GetSize() );
+
+	Frame.Fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	AE_ErrorCheckOpenGLError();
+
+	m_NextProfiledFrame = ( m_NextProfiledFrame + 1 ) % m_ProfiledFrames.size();
+	m_IsFrameProfiled = False;
+}
+
+void KBuffer::WriteTimeStamp()
+{
+	ProfiledFrame& Frame = m_ProfiledFrames[m_NextProfiledFrame];
+
+	// The queries are kept from a frame to the next one, a frame with more draws creates the missing ones.
+	if( Frame.TimeStampsCount == Frame.Queries.size() )
+	{
+		Frame.Queries.push_back( 0 );
+		glGenQueries( 1, &Frame.Queries.back() );
+	}
+
+	glQueryCounter( Frame.Queries[Frame.TimeStampsCount], GL_TIMESTAMP );
+	AE_ErrorCheckOpenGLError();
+
+	Frame.TimeStampsCount++;
+}
+
+void KBuffer::ReadProfiledFrames()
+{
+	// The frames are read in the order they were profiled, the oldest one is the next one to be used.
+	for( size_t i = 0; i < m_ProfiledFrames.size(); i++ )
+	{
+		ProfiledFrame& Frame = m_ProfiledFrames[( m_NextProfiledFrame + i ) % m_ProfiledFrames.size()];
+		if( Frame.Fence == nullptr )
+			continue;
+
+		// Never wait for the GPU : a frame not finished is read at a next frame, the frames after it too.
+		GLint SyncStatus = GL_UNSIGNALED;
+		glGetSynciv( Frame.Fence, GL_SYNC_STATUS, 1, nullptr, &SyncStatus );
+		AE_ErrorCheckOpenGLError();
+
+		if( SyncStatus != GL_SIGNALED )
+			return;
+
+		glDeleteSync( Frame.Fence );
+		Frame.Fence = nullptr;
+
+		// The time stamps are written before the fence : their results are available.
+		std::vector<GLuint64> TimeStamps( Frame.TimeStampsCount, 0 );
+		for( size_t TimeStamp = 0; TimeStamp < Frame.TimeStampsCount; TimeStamp++ )
+			glGetQueryObjectui64v( Frame.Queries[TimeStamp], GL_QUERY_RESULT, &TimeStamps[TimeStamp] );
+		AE_ErrorCheckOpenGLError();
+
+		// Time between a time stamp and the next one, in milliseconds.
+		auto GetElapsedTime = [&TimeStamps]( size_t _Start )
+		{
+			return TimeStamps[_Start + 1] > TimeStamps[_Start] ? Cast( float, TimeStamps[_Start + 1] - TimeStamps[_Start] ) * 1e-6f : 0.0f;
+		};
+
+		// Start and end of the clear pass, of each draw, then of the resolve pass.
+		size_t LastTimeStamp = Frame.TimeStampsCount - 1;
+
+		FrameStatistics Statistics;
+		Statistics.ClearPassTime = GetElapsedTime( 0 );
+		Statistics.ResolvePassTime = GetElapsedTime( LastTimeStamp - 1 );
+		Statistics.DrawsCount = Cast( Uint32, ( Frame.TimeStampsCount - 4 ) / 2 );
+
+		Statistics.StorePassTime = 0.0f;
+		for( size_t Draw = 2; Draw < LastTimeStamp - 1; Draw += 2 )
+			Statistics.StorePassTime += GetElapsedTime( Draw );
+
+		// Sum the counters of each statistic.
+		std::array<Uint32, StatisticsCount * StatisticCountersCount> Counters;
+		Frame.StatisticsReadback.GetData( Counters.data(), sizeof( Counters ) );
+
+		std::array<Uint32, StatisticsCount> Sums = {};
+		for( size_t Counter = 0; Counter < Counters.size(); Counter++ )
+			Sums[Counter / StatisticCountersCount] += Counters[Counter];
+
+		Statistics.StoredFragments = Sums[0];
+		Statistics.CulledFragments = Sums[1];
+		Statistics.RejectedFragments = Sums[2];
+		Statistics.EvictedFragments = Sums[3];
+		Statistics.SpinIterations = Sums[4];
+
+		m_LastFrameStatistics = Statistics;
+
+		AdaptK( Statistics, Frame.K );
+	}
+}
+
+void KBuffer::AdaptK( const FrameStatistics& _Statistics, Uint32 _K )
+{
+	// The statistics of another K tell nothing about the current one.
+	if( !IsAdaptiveKActive() || _K != m_K )
+		return;
+
+	float PassesTime = _Statistics.ClearPassTime + _Statistics.StorePassTime + _Statistics.ResolvePassTime;
+	Uint32 DroppedFragmentsCount = _Statistics.CulledFragments + _Statistics.RejectedFragments + _Statistics.EvictedFragments;
+
+	// Over the budget : one fragment less per pixel.
+	if( PassesTime > m_FrameTimeBudget )
+	{
+		if( m_K > 1 )
+			SetK( m_K - 1 );
+	}
+
+	// Fragments dropped : one more fragment per pixel if the time of K + 1, expected to grow linearly with K, keeps a margin of 10% in the budget.
+	// The margin avoids going back and forth between two values of K.
+	else if( DroppedFragmentsCount > 0 && m_K < m_KCapacity && PassesTime * Cast( float, m_K + 1 ) < 0.9f * m_FrameTimeBudget * Cast( float, m_K ) )
+		SetK( m_K + 1 );
+}
+
+Bool KBuffer::IsOccupancyRecordActive() const
+{
+	return ( m_IsOccupancyRecorded || m_DebugView != DebugView::None ) && m_TransparencyTechnique == TransparencyTechnique::KBuffer && m_InsertionMode == InsertionMode::Locked;
+}
+
+size_t KBuffer::ClearOccupancy()
+{
+	// The images are only allocated at full size while the occupancy is recorded.
+	Bool IsRecorded = IsOccupancyRecordActive();
+	Uint32 Width = IsRecorded ? GetWidth() : 1;
+	Uint32 Height = IsRecorded ? GetHeight() : 1;
+	if( m_DroppedCounts.GetWidth() != Width || m_DroppedCounts.GetHeight() != Height )
+	{
+		m_DroppedCounts.Resize( Width, Height );
+		m_SpinCounts.Resize( Width, Height );
+	}
+
+	if( !IsRecorded )
+		return 0;
+
+	glClearTexImage( m_DroppedCounts.GetTextureID(), 0, ae::ToGLFormat( m_DroppedCounts.GetFormat() ), ae::ToGLType( m_DroppedCounts.GetFormat() ), nullptr );
+	glClearTexImage( m_SpinCounts.GetTextureID(), 0, ae::ToGLFormat( m_SpinCounts.GetFormat() ), ae::ToGLType( m_SpinCounts.GetFormat() ), nullptr );
+	AE_ErrorCheckOpenGLError();
+
+	return 2 * Cast( size_t, Width ) * Height * sizeof( Uint32 );
+}
+
+void KBuffer::RecordDepthComplexityHistogram()
+{
+	// Work groups of 16x16 pixels, see DepthComplexityCompute.glsl.
+	const Uint32 GroupSize = 16;
+
+	if( m_DepthComplexityShader == nullptr )
+	{
+		m_DepthComplexityShader = std::make_unique<ComputeShader>( KBufferShadersDirectory + "DepthComplexityCompute.glsl" );
+		m_DepthComplexityShader->SetName( "K-Buffer Depth Complexity Shader" );
+	}
+
+	m_DepthComplexityBins.Clear( 0 );
+	m_DepthComplexityBins.BindAsStorage( 7 );
+
+	m_DepthComplexityShader->Bind();
+
+	BindStorage( *m_DepthComplexityShader, ae::TextureImageBindMode::ReadOnly );
+
+	// The histogram shader is not specialized : K is always a uniform.
+	ae::Shader::SetInt( m_DepthComplexityShader->GetUniformLocation( "K" ), Cast( Int32, m_K ) );
+	glUniform2i( m_DepthComplexityShader->GetUniformLocation( "ImageSize" ), Cast( GLint, m_RenderWidth ), Cast( GLint, m_RenderHeight ) );
+	AE_ErrorCheckOpenGLError();
+
+	m_DepthComplexityShader->Dispatch( ( m_RenderWidth + GroupSize - 1 ) / GroupSize, ( m_RenderHeight + GroupSize - 1 ) / GroupSize );
+	m_DepthComplexityShader->Unbind();
+
+	// The bins are copied by a buffer command.
+	glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+	AE_ErrorCheckOpenGLError();
+
+	m_DepthComplexityBins.CopyTo( m_DepthComplexityReadback, m_DepthComplexityBins.GetSize() );
+
+	m_DepthComplexityFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	AE_ErrorCheckOpenGLError();
+}
+
+void KBuffer::ReadDepthComplexityHistogram()
+{
+	if( m_DepthComplexityFence == nullptr )
+		return;
+
+	// Never wait for the GPU : the histogram is read at the next frame if the copy is not finished.
+	GLint SyncStatus = GL_UNSIGNALED;
+	glGetSynciv( m_DepthComplexityFence, GL_SYNC_STATUS, 1, nullptr, &SyncStatus );
+	AE_ErrorCheckOpenGLError();
+
+	if( SyncStatus != GL_SIGNALED )
+		return;
+
+	glDeleteSync( m_DepthComplexityFence );
+	m_DepthComplexityFence = nullptr;
+
+	m_DepthComplexityReadback.GetData( m_DepthComplexityHistogram.data(), m_DepthComplexityHistogram.size() * sizeof( Uint32 ) );
+}
+
+Bool KBuffer::IsFragmentPoolUsed() const
+{
+	return m_InsertionMode == InsertionMode::LinkedList || m_InsertionMode == InsertionMode::Counted;
+}
+
+size_t KBuffer::GetFragmentPoolSize() const
+{
+	if( !IsFragmentPoolUsed() )
+		return 0;
+
+	// The allocated count, then nodes of 3 words for the linked lists (see LinkedListCommon.glsl) or records of 2 words (see CountedFragmentsCommon.glsl).
+	size_t FragmentSize = m_InsertionMode == InsertionMode::LinkedList ? 3 : 2;
+
+	return ( 1 + FragmentSize * Cast( size_t, m_FragmentPoolCapacity ) ) * sizeof( Uint32 );
+}
+
+size_t KBuffer::GetStoragePixelsCount() const
+{
+	if( !m_UseTiledAddressing )
+		return Cast( size_t, GetWidth() ) * GetHeight();
+
+	size_t PaddedWidth = ( GetWidth() + TileSize - 1 ) / TileSize * TileSize;
+	size_t PaddedHeight = ( GetHeight() + TileSize - 1 ) / TileSize * TileSize;
+
+	return PaddedWidth * PaddedHeight;
+}
+
+void KBuffer::UpdateMaterial( const ae::Material& _Material )
+{
+	const StorePassMaterial* Material = dynamic_cast<const StorePassMaterial*>( &_Material );
+	if( Material == nullptr )
+		return;
+
+	size_t MaterialIndex = Cast( size_t, ae::Math::Max( 0, Material->GetMaterialIndex().GetValue() ) );
+
+	// The fragments of a material out of the table would read the entry of another material : warned once, the material is not stored.
+	if( MaterialIndex >= MaxStorePassMaterialsCount )
+	{
+		if( !m_IsMaterialsLimitWarned )
+			AE_LogWarning( "Material index " + std::to_string( MaterialIndex ) + " out of the " + std::to_string( MaxStorePassMaterialsCount ) + " materials of the K-Buffer, its fragments use the color of another material." );
+
+		m_IsMaterialsLimitWarned = True;
+		return;
+	}
+
+	if( MaterialIndex >= m_MaterialTable.size() )
+	{
+		m_MaterialTable.resize( MaterialIndex + 1 );
+		m_AreMaterialsDirty = True;
+	}
+
+	MaterialTableEntry Entry = GetMaterialEntry( *Material );
+
+	MaterialTableEntry& StoredEntry = m_MaterialTable[MaterialIndex];
+	if( AreMaterialEntriesEqual( StoredEntry, Entry ) )
+		return;
+
+	StoredEntry = Entry;
+	m_AreMaterialsDirty = True;
+}
+
+KBuffer::MaterialTableEntry KBuffer::GetMaterialEntry( const ae::Material& _Material )
+{
+	MaterialTableEntry Entry = {};
+
+	const StorePassMaterial* Material = dynamic_cast<const StorePassMaterial*>( &_Material );
+	if( Material == nullptr )
+		return Entry;
+
+	Entry.BaseColor = Material->GetBaseColor().GetValue();
+	Entry.TranslucentColor = Material->GetTranslucentColor().GetValue();
+	Entry.IsTranslucent = Material->GetIsTranslucent().GetValue() ? 1.0f : 0.0f;
+	Entry.MaxTranslucentThickness = Material->GetMaxTranslucentThickness().GetValue();
+
+	return Entry;
+}
+
+Bool KBuffer::AreMaterialEntriesEqual( const MaterialTableEntry& _EntryA, const MaterialTableEntry& _EntryB )
+{
+	return _EntryA.BaseColor == _EntryB.BaseColor && _EntryA.TranslucentColor == _EntryB.TranslucentColor &&
+		   _EntryA.IsTranslucent == _EntryB.IsTranslucent && _EntryA.MaxTranslucentThickness == _EntryB.MaxTranslucentThickness;
+}
+
+void KBuffer::UploadMaterials()
+{
+	if( !m_AreMaterialsDirty )
+		return;
+
+	size_t TableSize = m_MaterialTable.size() * sizeof( MaterialTableEntry );
+
+	m_Materials.Resize( TableSize );
+	m_Materials.SetData( m_MaterialTable.data(), TableSize );
+
+	m_AreMaterialsDirty = False;
+}
+
+Bool KBuffer::IsOverflowTailActive() const
+{
+	return m_UseOverflowTail && m_TransparencyTechnique == TransparencyTechnique::KBuffer && ( m_InsertionMode == InsertionMode::Locked || m_InsertionMode == InsertionMode::LockFree );
+}
+
+Bool KBuffer::AreBlendedTargetsUsed() const
+{
+	return IsOverflowTailActive() || m_TransparencyTechnique != TransparencyTechnique::KBuffer;
+}
+
+template<typename ShaderType>
+void KBuffer::BindMomentTextures( const ShaderType& _Shader )
+{
+	// The absorbance of the moment based OIT is accumulated in the revealage target.
+	glActiveTexture( GL_TEXTURE2 );
+	m_BlendedRevealages.Bind();
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "TotalAbsorbances" ), 2 );
+
+	glActiveTexture( GL_TEXTURE3 );
+	m_PowerMoments.Bind();
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "TotalPowerMoments" ), 3 );
+
+	glActiveTexture( GL_TEXTURE0 );
+	AE_ErrorCheckOpenGLError();
+}
+
+Bool KBuffer::IsRenderedInOpaquePrePass( const ae::Material& _Material ) const
+{
+	if( !m_UseOpaquePrePass )
+		return False;
+
+	const StorePassMaterial* Material = dynamic_cast<const StorePassMaterial*>( &_Material );
+	if( Material == nullptr )
+		return False;
+
+	return !Material->GetIsTranslucent().GetValue() && Material->GetBaseColor().GetValue().A() >= 1.0f;
+}
+
+template<typename ShaderType>
+void KBuffer::BindOpaqueTextures( const ShaderType& _Shader )
+{
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "UseOpaquePrePass" ), m_UseOpaquePrePass );
+
+	if( !m_UseOpaquePrePass )
+		return;
+
+	const ae::Texture* ColorTexture = GetAttachementTexture( ae::FramebufferAttachement::Type::Color_0 );
+	const ae::Texture* DepthTexture = GetAttachementTexture( ae::FramebufferAttachement::Type::Depth );
+	if( ColorTexture == nullptr || DepthTexture == nullptr )
+		return;
+
+	glActiveTexture( GL_TEXTURE0 );
+	ColorTexture->Bind();
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "OpaqueColors" ), 0 );
+
+	glActiveTexture( GL_TEXTURE1 );
+	DepthTexture->Bind();
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "OpaqueDepths" ), 1 );
+
+	glActiveTexture( GL_TEXTURE0 );
+	AE_ErrorCheckOpenGLError();
+}
+
+template<typename ShaderType>
+void KBuffer::BindTailTextures( const ShaderType& _Shader )
+{
+	if( !AreBlendedTargetsUsed() )
+		return;
+
+	glActiveTexture( GL_TEXTURE2 );
+	m_BlendedAccumulations.Bind();
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "TailAccumulations" ), 2 );
+
+	glActiveTexture( GL_TEXTURE3 );
+	m_BlendedRevealages.Bind();
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "TailRevealages" ), 3 );
+
+	glActiveTexture( GL_TEXTURE0 );
+	AE_ErrorCheckOpenGLError();
+}
+
+GraphicsShader& KBuffer::GetStorePassShader()
+{
+	// The cheaper techniques do not depend on the insertion mode nor on K.
+	if( m_TransparencyTechnique == TransparencyTechnique::WeightedBlended )
+		return GetSharedShader( m_StorePassWeightedBlendedShader, "StorePassVertex.glsl", "StorePassWeightedBlendedFragment.glsl", "K-Buffer Store Pass Weighted Blended Shader" );
+
+	// First pass of the moment based OIT, the second one is drawn by the resolve.
+	if( m_TransparencyTechnique == TransparencyTechnique::MomentBased )
+		return GetSharedShader( m_StorePassMomentsShader, "StorePassVertex.glsl", "StorePassMomentsFragment.glsl", "K-Buffer Store Pass Moments Shader" );
+
+	// The linked lists and the counted mode do not depend on K.
+	if( m_InsertionMode == InsertionMode::LinkedList )
+		return GetSharedShader( m_StorePassLinkedListShader, "StorePassVertex.glsl", "StorePassLinkedListFragment.glsl", "K-Buffer Store Pass Linked List Shader" );
+
+	// First pass of the counted mode, the second one is drawn by the resolve.
+	if( m_InsertionMode == InsertionMode::Counted )
+		return GetSharedShader( m_StorePassCountShader, "StorePassVertex.glsl", "StorePassCountFragment.glsl", "K-Buffer Store Pass Count Shader" );
+
+	ShaderPermutation& Permutation = GetShaderPermutation();
+
+	if( m_InsertionMode == InsertionMode::LockFree )
+		return GetPermutationShader( Permutation.StorePassLockFree, "StorePassVertex.glsl", "StorePassLockFreeFragment.glsl", "K-Buffer Store Pass Lock Free Shader" );
+
+	if( m_UseInterlock )
+		return GetPermutationShader( Permutation.StorePassInterlock, "StorePassVertex.glsl", "StorePassInterlockFragment.glsl", "K-Buffer Store Pass Interlock Shader" );
+
+	return GetPermutationShader( Permutation.StorePass, "StorePassVertex.glsl", "StorePassFragment.glsl", "K-Buffer Store Pass Shader" );
+}
+
+GraphicsShader& KBuffer::GetResolvePassShader()
+{
+	// The cheaper techniques only composite their accumulation.
+	if( m_TransparencyTechnique != TransparencyTechnique::KBuffer )
+		return GetSharedShader( m_ResolvePassBlendedShader, "ResolvePassVertex.glsl", "ResolvePassBlendedFragment.glsl", "K-Buffer Resolve Pass Blended Shader" );
+
+	if( m_InsertionMode == InsertionMode::LinkedList )
+		return GetSharedShader( m_ResolvePassLinkedListShader, "ResolvePassVertex.glsl", "ResolvePassLinkedListFragment.glsl", "K-Buffer Resolve Pass Linked List Shader" );
+
+	if( m_InsertionMode == InsertionMode::Counted )
+		return GetSharedShader( m_ResolvePassCountedShader, "ResolvePassVertex.glsl", "ResolvePassCountedFragment.glsl", "K-Buffer Resolve Pass Counted Shader" );
+
+	ShaderPermutation& Permutation = GetShaderPermutation();
+
+	if( m_InsertionMode == InsertionMode::LockFree )
+		return GetPermutationShader( Permutation.ResolvePassLockFree, "ResolvePassVertex.glsl", "ResolvePassLockFreeFragment.glsl", "K-Buffer Resolve Pass Lock Free Shader" );
+
+	return GetPermutationShader( Permutation.ResolvePass, "ResolvePassVertex.glsl", "ResolvePassFragment.glsl", "K-Buffer Resolve Pass Shader" );
+}
+
+ComputeShader& KBuffer::GetPrefixSumShader( size_t _Pass )
+{
+	std::unique_ptr<ComputeShader>& Shader = m_PrefixSumShaders[_Pass];
+	if( Shader != nullptr )
+		return *Shader;
+
+	// One shader per pass, independent of K.
+	Shader = std::make_unique<ComputeShader>( KBufferShadersDirectory + "PrefixSumCompute.glsl", "#define PREFIX_SUM_PASS " + std::to_string( _Pass ) + "\n" );
+	Shader->SetName( "K-Buffer Prefix Sum Shader " + std::to_string( _Pass ) );
+
+	return *Shader;
+}
+
+GraphicsShader& KBuffer::GetSharedShader( std::unique_ptr<GraphicsShader>& _Shader, const std::string& _VertexFile, const std::string& _FragmentFile, const std::string& _Name )
+{
+	if( _Shader != nullptr )
+		return *_Shader;
+
+	_Shader = std::make_unique<GraphicsShader>( KBufferShadersDirectory + _VertexFile, KBufferShadersDirectory + _FragmentFile );
+	_Shader->SetName( _Name );
+
+	return *_Shader;
+}
+
+ComputeShader& KBuffer::GetResolveClassifyShader()
+{
+	return GetPermutationComputeShader( GetShaderPermutation().ResolveClassify, "ResolveClassifyCompute.glsl", "", "K-Buffer Resolve Classify Shader" );
+}
+
+ComputeShader& KBuffer::GetResolveTileShader( size_t _Network )
+{
+	// One shader per sorting network size.
+	std::string SortSize = std::to_string( 2u << _Network );
+
+	return GetPermutationComputeShader( GetShaderPermutation().ResolveTiles[_Network], "ResolveTileCompute.glsl", "#define SORT_SIZE " + SortSize + "\n", "K-Buffer Resolve Tile Shader " + SortSize );
+}
+
+KBuffer::ShaderPermutation& KBuffer::GetShaderPermutation()
+{
+	return m_ShaderPermutations[m_IsShaderSpecialized ? m_K : 0];
+}
+
+GraphicsShader& KBuffer::GetPermutationShader( std::unique_ptr<GraphicsShader>& _Shader, const std::string& _VertexFile, const std::string& _FragmentFile, const std::string& _Name )
+{
+	if( _Shader != nullptr )
+		return *_Shader;
+
+	_Shader = std::make_unique<GraphicsShader>( KBufferShadersDirectory + _VertexFile, KBufferShadersDirectory + _FragmentFile, GetSpecializationDefines() );
+	_Shader->SetName( m_IsShaderSpecialized ? _Name + " K" + std::to_string( m_K ) : _Name );
+
+	return *_Shader;
+}
+
+ComputeShader& KBuffer::GetPermutationComputeShader( std::unique_ptr<ComputeShader>& _Shader, const std::string& _File, const std::string& _Defines, const std::string& _Name )
+{
+	if( _Shader != nullptr )
+		return *_Shader;
+
+	_Shader = std::make_unique<ComputeShader>( KBufferShadersDirectory + _File, GetSpecializationDefines() + _Defines );
+	_Shader->SetName( m_IsShaderSpecialized ? _Name + " K" + std::to_string( m_K ) : _Name );
+
+	return *_Shader;
+}
+
+std::string KBuffer::GetSpecializationDefines() const
+{
+	return m_IsShaderSpecialized ? "#define K " + std::to_string( m_K ) + "\n" : "";
+}
+
+template<typename ShaderType>
+void KBuffer::BindStorage( const ShaderType& _Shader, ae::TextureImageBindMode _AccessMode )
+{
+	// The cheaper techniques have no storage : they read the material table and their accumulation is composited like the overflow tail.
+	if( m_TransparencyTechnique != TransparencyTechnique::KBuffer )
+	{
+		ae::Shader::SetBool( _Shader.GetUniformLocation( "UseOverflowTail" ), m_TransparencyTechnique == TransparencyTechnique::WeightedBlended );
+		ae::Shader::SetBool( _Shader.GetUniformLocation( "UseMoments" ), m_TransparencyTechnique == TransparencyTechnique::MomentBased );
+		m_Materials.BindAsStorage( 1 );
+		return;
+	}
+
+	if( m_InsertionMode == InsertionMode::LockFree )
+		m_PackedFragments.BindAsStorage( 0 );
+
+	else if( m_InsertionMode == InsertionMode::LinkedList )
+	{
+		m_ListHeads.BindAsStorage( 0 );
+		m_FragmentPool.BindAsStorage( 2 );
+		ae::Shader::SetInt( _Shader.GetUniformLocation( "FragmentPoolCapacity" ), Cast( Int32, m_FragmentPoolCapacity ) );
+	}
+
+	// The counts are reset by the resolve pass : always read and written.
+	else if( m_InsertionMode == InsertionMode::Counted )
+	{
+		m_Counts.BindAsImage( 1, ae::TextureImageBindMode::ReadWrite );
+		m_FragmentPool.BindAsStorage( 2 );
+		m_CountedOffsets.BindAsStorage( 4 );
+		ae::Shader::SetInt( _Shader.GetUniformLocation( "FragmentPoolCapacity" ), Cast( Int32, m_FragmentPoolCapacity ) );
+	}
+
+	else
+	{
+		if( !m_UseInterlock )
+			m_Semaphores.BindAsImage( 0, _AccessMode );
+
+		if( m_StorageLayout == StorageLayout::PixelMajorBuffer )
+			m_Fragments.BindAsStorage( 2 );
+
+		// The page of each tile in the pool of the tile-sparse storage.
+		ae::Shader::SetBool( _Shader.GetUniformLocation( "UseSparseTiles" ), IsTileSparseActive() );
+		if( IsTileSparseActive() )
+			m_TilePages.BindAsStorage( 5 );
+
+		else
+		{
+			m_Counts.BindAsImage( 1, _AccessMode );
+			m_MaterialIndices.BindAsImage( 2, _AccessMode );
+			m_Depths.BindAsImage( 3, _AccessMode );
+		}
+
+		// The layout of the fragments must be the same in the store and the resolve pass.
+		ae::Shader::SetBool( _Shader.GetUniformLocation( "UseMaxHeap" ), m_UseMaxHeap );
+		ae::Shader::SetBool( _Shader.GetUniformLocation( "UseBufferStorage" ), m_StorageLayout == StorageLayout::PixelMajorBuffer );
+		ae::Shader::SetInt( _Shader.GetUniformLocation( "Generation" ), Cast( Int32, m_Generation ) );
+
+		// The store pass counts the occupancy of the pixels, read by the debug views and the depth complexity histogram.
+		ae::Shader::SetBool( _Shader.GetUniformLocation( "RecordOccupancy" ), IsOccupancyRecordActive() );
+		if( IsOccupancyRecordActive() )
+		{
+			m_DroppedCounts.BindAsImage( 5, _AccessMode );
+			m_SpinCounts.BindAsImage( 6, _AccessMode );
+		}
+	}
+
+	// The store pass reads the material of the dropped fragments, the resolve pass composites the tail.
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "UseOverflowTail" ), IsOverflowTailActive() );
+	if( IsOverflowTailActive() )
+		m_Materials.BindAsStorage( 1 );
+
+	// The store pass of the profiled frames counts the stored, culled, rejected and evicted fragments.
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "CollectStatistics" ), m_IsFrameProfiled );
+	if( m_IsFrameProfiled )
+		m_Statistics.BindAsStorage( 6 );
+
+	// Addressing of the pixels in the storage buffers.
+	ae::Shader::SetInt( _Shader.GetUniformLocation( "KBufferWidth" ), Cast( Int32, GetWidth() ) );
+	ae::Shader::SetBool( _Shader.GetUniformLocation( "UseTiledAddressing" ), m_UseTiledAddressing );
+
+	// Send K value to the shader, the specialized shaders have K as a constant.
+	if( !m_IsShaderSpecialized )
+		ae::Shader::SetInt( _Shader.GetUniformLocation( "K" ), Cast( Int32, m_K ) );
 }
 
 void KBuffer::ToEditor()
@@ -2,10 +2,20 @@
 
 #include <API/Code/Graphics/Texture/Texture2D.h>
 #include <API/Code/Graphics/Texture/Texture2DArray.h>
-#include <API/Code/Graphics/Texture/Texture1DArray.h>
 #include <API/Code/Graphics/Framebuffer/Framebuffer.h>
 #include <API/Code/Graphics/Framebuffer/FramebufferSprite.h>
 #include <API/Code/Graphics/Shader/Shader.h>
+#include <API/Code/Maths/Matrix/Matrix4x4.h>
+
+#include "GPUBuffer.h"
+#include "ComputeShader.h"
+#include "GraphicsShader.h"
+#include "InstancedDrawable.h"
+
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 /// <summary>
 /// Render target that store up to K fragment.<para/>
@@ -14,6 +24,171 @@
 /// </summary>
 class KBuffer : public ae::Framebuffer, public ae::Resource
 {
+public:
+	/// <summary>Algorithm used to insert the fragments in the K-Buffer during the store pass.</summary>
+	enum class InsertionMode : Uint8
+	{
+		/// <summary>
+		/// The fragments of a pixel are serialized in a critical section and stored in the K-Buffer images.<para/>
+		/// The critical section uses the fragment shader interlock when available, a per-pixel semaphore otherwise.
+		/// </summary>
+		Locked,
+
+		/// <summary>
+		/// The fragments are packed on 64 bits (depth and material) and inserted with atomic operations, without any lock.<para/>
+		/// Require GL_NV_shader_atomic_int64.
+		/// </summary>
+		LockFree,
+
+		/// <summary>
+		/// A-Buffer : every fragment is appended without lock to the linked list of its pixel, in a global pool of fragments.<para/>
+		/// The memory follows the real count of fragments instead of K per pixel and the resolve pass sorts the whole lists : K is ignored.
+		/// </summary>
+		LinkedList,
+
+		/// <summary>
+		/// A-Buffer in two geometry passes : the drawn objects only count the fragments of each pixel and are kept until the resolve.<para/>
+		/// A prefix sum of the counts gives the offset of each pixel, then the objects are drawn again to write their fragments contiguously in the fragment pool.<para/>
+		/// No link and no unused slot : the memory is the exact count of fragments, the resolve pass reads each pixel in one range. K and the tiled addressing are ignored.
+		/// </summary>
+		Counted
+	};
+
+	/// <summary>What to do when the fragment pool of the linked lists and of the counted mode is exhausted.</summary>
+	enum class PoolOverflowPolicy : Uint8
+	{
+		/// <summary>The fragments that do not fit in the pool are dropped, the pool keeps its capacity.</summary>
+		Drop,
+
+		/// <summary>The fragments that do not fit in the pool are dropped for this frame and the pool grows to fit the next frames.</summary>
+		Grow
+	};
+
+	/// <summary>Memory layout of the fragments stored by the locked insertion.</summary>
+	enum class StorageLayout : Uint8
+	{
+		/// <summary>One image per fragment attribute with K layers : the fragments of a pixel are spread in distant layers.</summary>
+		LayerMajorImages,
+
+		/// <summary>One buffer where the count and the K fragments of each pixel are contiguous.</summary>
+		PixelMajorBuffer
+	};
+
+	/// <summary>Algorithm used to sort and blend the stored fragments during the resolve pass.</summary>
+	enum class ResolveMode : Uint8
+	{
+		/// <summary>A fullscreen quad : each fragment shader invocation sorts the fragments of its pixel in a private array.</summary>
+		FragmentShader,
+
+		/// <summary>
+		/// Compute shaders : the tiles of 8x8 pixels are classified by their maximum count of fragments and the empty tiles are skipped.<para/>
+		/// The other tiles are sorted in shared memory by a sorting network of 2, 4, 8 or 16 fragments and written in the color texture of the target.<para/>
+		/// Only used by the locked insertion, with a target that has a 2D color texture.
+		/// </summary>
+		TiledCompute
+	};
+
+	/// <summary>Occupancy of the pixels shown instead of the resolved image, as a heatmap from blue to red, to see where the K-Buffer saturates.</summary>
+	enum class DebugView : Uint8
+	{
+		/// <summary>No debug view : the stored fragments are resolved.</summary>
+		None,
+
+		/// <summary>Count of fragments stored in each pixel, red at K.</summary>
+		StoredFragments,
+
+		/// <summary>Count of fragments dropped by each full pixel : culled, rejected or evicted.</summary>
+		DroppedFragments,
+
+		/// <summary>Failed attempts to lock the semaphore of each pixel.</summary>
+		SpinIterations
+	};
+
+	/// <summary>Technique used to render the translucent objects, chosen per frame with the same Draw and Resolve calls.</summary>
+	enum class TransparencyTechnique : Uint8
+	{
+		/// <summary>The fragments are stored with the insertion mode, then sorted and blended by the resolve pass.</summary>
+		KBuffer,
+
+		/// <summary>
+		/// Weighted blended OIT : every fragment is accumulated by the hardware blending with a depth weight, nothing is stored and nothing is sorted.<para/>
+		/// An approximation of the order : cheap in memory and time, the colors of close layers are averaged.
+		/// </summary>
+		WeightedBlended,
+
+		/// <summary>
+		/// Moment based OIT : the first pass accumulates the absorbance and 4 power moments of the depth of each pixel by the hardware blending.<para/>
+		/// The objects are kept until the resolve pass, which draws them again with the transmittance in front of each fragment reconstructed from the moments.
+		/// Closer to the K-Buffer than the weighted blended OIT for two geometry passes and 16 more bytes per pixel.
+		/// </summary>
+		MomentBased
+	};
+
+	/// <summary>GPU times and counters of a profiled frame. The counters are collected by the K-Buffer technique.</summary>
+	struct FrameStatistics
+	{
+		/// <summary>GPU time of the clear pass, in milliseconds.</summary>
+		float ClearPassTime;
+
+		/// <summary>Sum of the GPU times of the draws of the store pass, in milliseconds.</summary>
+		float StorePassTime;
+
+		/// <summary>GPU time of the resolve pass, with the second geometry pass of the counted mode and of the moment based OIT, in milliseconds.</summary>
+		float ResolvePassTime;
+
+		/// <summary>Number of objects drawn during the store pass.</summary>
+		Uint32 DrawsCount;
+
+		/// <summary>Fragments stored in the K-Buffer or in the fragment pool.</summary>
+		Uint32 StoredFragments;
+
+		/// <summary>Fragments of the full pixels culled before the critical section, further than every stored fragment.</summary>
+		Uint32 CulledFragments;
+
+		/// <summary>Fragments of the full pixels rejected in the critical section, and fragments that do not fit in the fragment pool.</summary>
+		Uint32 RejectedFragments;
+
+		/// <summary>Stored fragments evicted from the full pixels by a nearer fragment.</summary>
+		Uint32 EvictedFragments;
+
+		/// <summary>Failed attempts to lock the semaphore of a pixel, the contention of the locked insertion without interlock.</summary>
+		Uint32 SpinIterations;
+	};
+
+	/// <summary>Difference between two resolved images. The difference of a pixel is the average of the absolute differences of its color channels, in [0, 1].</summary>
+	struct ImageDifference
+	{
+		/// <summary>Mean of the differences of the pixels.</summary>
+		float MeanError;
+
+		/// <summary>Root mean square of the differences of the pixels, more sensitive to large local errors.</summary>
+		float RootMeanSquareError;
+
+		/// <summary>Largest difference of a pixel.</summary>
+		float MaxError;
+	};
+
+	/// <summary>
+	/// Memory read and written by the store and resolve passes of a frame, estimated from the sizes of the records and of the pixel headers of the storage.<para/>
+	/// Each fragment reaching the storage reads the header of its pixel (count, semaphore or list head), a stored fragment writes its record and the header,
+	/// a fragment dropped by a full pixel reads the furthest record. The resolve pass reads the header of each pixel and the records left in the storage,
+	/// and writes the color of a RGBA8 target. The caches and the sorting are ignored : the sizes are the traffic of the records, not of the memory bus.
+	/// </summary>
+	struct PassesTraffic
+	{
+		/// <summary>Bytes read by the store pass.</summary>
+		size_t StoreReadSize;
+
+		/// <summary>Bytes written by the store pass.</summary>
+		size_t StoreWrittenSize;
+
+		/// <summary>Bytes read by the resolve pass.</summary>
+		size_t ResolveReadSize;
+
+		/// <summary>Bytes written by the resolve pass.</summary>
+		size_t ResolveWrittenSize;
+	};
+
 public:
 	/// <summary>Build a K-Buffer to store, sort and blend <paramref name="_K"/> fragments.</summary>
 	/// <param name="_Width">The width of the K-Buffer</param>
@@ -21,14 +196,336 @@ public:
 	/// <param name="_K">The maximum number of fragment to store.</param>
 	KBuffer( Uint32 _Width, Uint32 _Height, Uint32 _K );
 
+	/// <summary>Destroy the pending synchronization objects of the K-Buffer.</summary>
+	~KBuffer();
+
 	/// <summary>Retrieve the maximum number of fragment that the K-Buffer can store.</summary>
 	/// <returns>The maximum number of fragment to store.</returns>
 	Uint32 GetK() const;
 
-	/// <summary>Set the maximum number of fragment that the K-Buffer can store [1-16].</summary>
+	/// <summary>
+	/// Set the maximum number of fragment that the K-Buffer can store [1-16].<para/>
+	/// The storage is only reallocated if K is larger than the K capacity, which grows to K. Otherwise the K first fragments of each pixel are used.<para/>
+	/// With the specialized shaders, the shaders of the new K are used : they are compiled the first time this K is used.
+	/// </summary>
 	/// <param name="_K">The new maximum number of fragment to store.</param>
 	void SetK( Uint32 _K );
 
+	/// <summary>Retrieve the number of fragments per pixel allocated in the storage : the largest K without reallocation.</summary>
+	/// <returns>The K capacity of the storage.</returns>
+	Uint32 GetKCapacity() const;
+
+	/// <summary>
+	/// Set the number of fragments per pixel allocated in the storage of the locked and lock free insertions [1-16], reallocate the storage if it changes.<para/>
+	/// K can then change up to the capacity without reallocation, the clear pass only clears the fragments of the current K.
+	/// K is lowered if it is larger than the new capacity. By default, the K of the creation.
+	/// </summary>
+	/// <param name="_Capacity">The new K capacity.</param>
+	void SetKCapacity( Uint32 _Capacity );
+
+	/// <summary>Is K adapted every frame to the GPU time of the K-Buffer passes ?</summary>
+	/// <returns>True if K is adapted, False if K only changes with SetK.</returns>
+	Bool IsKAdaptive() const;
+
+	/// <summary>
+	/// Must K be adapted every frame to the GPU time of the K-Buffer passes and to the fragments dropped by the full pixels ?<para/>
+	/// The frames are profiled like with SetIsProfiled : the statistics are a few frames late, only the frames profiled with the current K change K.<para/>
+	/// K is lowered when the passes exceed the frame time budget,
+	/// raised when fragments are dropped and the passes of K + 1 are expected within the budget.<para/>
+	/// K stays between 1 and the K capacity : the storage is never reallocated. Used by the locked and lock free insertions of the K-Buffer technique.
+	/// </summary>
+	/// <param name="_IsKAdaptive">True to adapt K, False to keep it.</param>
+	void SetIsKAdaptive( Bool _IsKAdaptive );
+
+	/// <summary>Retrieve the GPU time allowed to the K-Buffer passes by the adaptive K.</summary>
+	/// <returns>The frame time budget in milliseconds.</returns>
+	float GetFrameTimeBudget() const;
+
+	/// <summary>Set the GPU time allowed to the K-Buffer passes, from the start of the clear pass to the end of the resolve pass. 2 ms by default.</summary>
+	/// <param name="_Budget">The new frame time budget in milliseconds.</param>
+	void SetFrameTimeBudget( float _Budget );
+
+	/// <summary>Are the shaders compiled for the current K instead of reading K from a uniform ?</summary>
+	/// <returns>True if the shaders are specialized for K, False otherwise.</returns>
+	Bool IsShaderSpecialized() const;
+
+	/// <summary>
+	/// Must the shaders be compiled for each value of K instead of reading K from a uniform ?<para/>
+	/// K is defined at compile time : the loops over the fragments have a constant bound and the arrays of the resolve pass are sized for K.
+	/// Enabled by default, one permutation of the shaders is kept for each K used.
+	/// </summary>
+	/// <param name="_IsShaderSpecialized">True to specialize the shaders for K, False to read K from a uniform.</param>
+	void SetIsShaderSpecialized( Bool _IsShaderSpecialized );
+
+
+	/// <summary>Are the GPU times and the counters of the K-Buffer passes collected ?</summary>
+	/// <returns>True if the frames are profiled, False otherwise.</returns>
+	Bool IsProfiled() const;
+
+	/// <summary>
+	/// Must the GPU times of the clear pass, of each draw and of the resolve pass be measured, with the counters of the store pass ?<para/>
+	/// The times are measured with time stamp queries and the counters with atomic operations, read back without waiting for the GPU :
+	/// two frames can be in flight, the statistics are a few frames late. The frames are also profiled for the adaptive K.
+	/// </summary>
+	/// <param name="_IsProfiled">True to profile the frames, False otherwise.</param>
+	void SetIsProfiled( Bool _IsProfiled );
+
+	/// <summary>Retrieve the statistics of the last profiled frame read back.</summary>
+	/// <returns>The GPU times of the passes and the counters of the store pass.</returns>
+	const FrameStatistics& GetLastFrameStatistics() const;
+
+	/// <summary>Retrieve the occupancy of the pixels shown instead of the resolved image.</summary>
+	/// <returns>The current debug view.</returns>
+	DebugView GetDebugView() const;
+
+	/// <summary>
+	/// Set the occupancy of the pixels shown instead of the resolved image. The occupancy is recorded while a debug view is shown.<para/>
+	/// Only used by the locked insertion of the K-Buffer technique, the other cases are resolved as usual.
+	/// </summary>
+	/// <param name="_DebugView">The new debug view, None to resolve the fragments.</param>
+	void SetDebugView( DebugView _DebugView );
+
+	/// <summary>Is the occupancy of the pixels recorded when no debug view is shown ?</summary>
+	/// <returns>True if the occupancy is recorded, False otherwise.</returns>
+	Bool IsOccupancyRecorded() const;
+
+	/// <summary>
+	/// Must the store pass count the fragments dropped by each pixel and the failed attempts to lock it, and the depth complexity histogram be built ?<para/>
+	/// The histogram is read back without waiting for the GPU : it is a few frames late. Only used by the locked insertion of the K-Buffer technique.
+	/// </summary>
+	/// <param name="_IsOccupancyRecorded">True to record the occupancy, False otherwise.</param>
+	void SetIsOccupancyRecorded( Bool _IsOccupancyRecorded );
+
+	/// <summary>Retrieve the count of dropped fragments or of spin iterations shown in red by the debug views.</summary>
+	/// <returns>The hottest value of the heatmap.</returns>
+	float GetHeatmapMaxValue() const;
+
+	/// <summary>Set the count of dropped fragments or of spin iterations shown in red by the debug views, the stored fragments are red at K. 16 by default.</summary>
+	/// <param name="_MaxValue">The new hottest value of the heatmap.</param>
+	void SetHeatmapMaxValue( float _MaxValue );
+
+	/// <summary>
+	/// Retrieve the histogram of the depth complexity of the last recorded frame read back : the count of pixels for each number of fragments received by a pixel, stored or dropped.<para/>
+	/// The last bin counts the pixels with at least as many fragments as its index. The pixels with more than K fragments saturate the K-Buffer.
+	/// </summary>
+	/// <returns>The count of pixels of each depth complexity.</returns>
+	const std::vector<Uint32>& GetDepthComplexityHistogram() const;
+
+
+	/// <summary>Retrieve the algorithm used to insert the fragments during the store pass.</summary>
+	/// <returns>The current insertion mode.</returns>
+	InsertionMode GetInsertionMode() const;
+
+	/// <summary>
+	/// Set the algorithm used to insert the fragments during the store pass.<para/>
+	/// The lock free mode is ignored if the hardware does not support 64 bits atomic operations.
+	/// </summary>
+	/// <param name="_Mode">The new insertion mode.</param>
+	void SetInsertionMode( InsertionMode _Mode );
+
+	/// <summary>Is the lock free insertion supported by the hardware ?</summary>
+	/// <returns>True if 64 bits atomic operations are available, False otherwise.</returns>
+	static Bool IsLockFreeSupported();
+
+
+	/// <summary>Retrieve the technique used to render the translucent objects.</summary>
+	/// <returns>The current transparency technique.</returns>
+	TransparencyTechnique GetTransparencyTechnique() const;
+
+	/// <summary>
+	/// Set the technique used to render the translucent objects, from the next clear pass.<para/>
+	/// The storage of the K-Buffer is kept with the cheaper techniques : it can change every frame, to fall back to a cheaper technique under load.
+	/// </summary>
+	/// <param name="_Technique">The new transparency technique.</param>
+	void SetTransparencyTechnique( TransparencyTechnique _Technique );
+
+
+	/// <summary>Retrieve the number of fragments that the pool of the linked lists and of the counted mode can store.</summary>
+	/// <returns>The capacity of the fragment pool.</returns>
+	Uint32 GetFragmentPoolCapacity() const;
+
+	/// <summary>
+	/// Set the number of fragments that the pool of the linked lists and of the counted mode can store, for all the pixels.<para/>
+	/// By default, 4 fragments per pixel of the K-Buffer size at its creation.
+	/// </summary>
+	/// <param name="_Capacity">The new capacity of the fragment pool.</param>
+	void SetFragmentPoolCapacity( Uint32 _Capacity );
+
+	/// <summary>Retrieve what is done when the fragment pool of the linked lists is exhausted.</summary>
+	/// <returns>The current overflow policy.</returns>
+	PoolOverflowPolicy GetPoolOverflowPolicy() const;
+
+	/// <summary>Set what is done when the fragment pool of the linked lists is exhausted.</summary>
+	/// <param name="_Policy">The new overflow policy.</param>
+	void SetPoolOverflowPolicy( PoolOverflowPolicy _Policy );
+
+	/// <summary>
+	/// Retrieve the number of fragments that a recent frame tried to store in the fragment pool, stored or dropped.<para/>
+	/// The count is read back without waiting for the GPU : it is a few frames late.
+	/// </summary>
+	/// <returns>The count of fragments allocated by the last frame read back.</returns>
+	Uint32 GetLastAllocatedFragmentsCount() const;
+
+
+	/// <summary>Retrieve the memory layout of the fragments stored by the locked insertion.</summary>
+	/// <returns>The current storage layout.</returns>
+	StorageLayout GetStorageLayout() const;
+
+	/// <summary>Set the memory layout of the fragments stored by the locked insertion. The stored fragments are lost.</summary>
+	/// <param name="_Layout">The new storage layout.</param>
+	void SetStorageLayout( StorageLayout _Layout );
+
+	/// <summary>Are the pixels of the storage buffers addressed by tiles in Morton order ?</summary>
+	/// <returns>True if the tiled addressing is used, False if the pixels are stored row by row.</returns>
+	Bool IsTiledAddressingUsed() const;
+
+	/// <summary>
+	/// Must the pixels of the storage buffers (pixel-major and lock free) be addressed by tiles of 8x8 pixels in Morton order ?<para/>
+	/// Neighbour pixels are closer in memory. The storage is rounded up to a multiple of the tile size.
+	/// </summary>
+	/// <param name="_UseTiledAddressing">True to address the pixels by tiles, False to store them row by row.</param>
+	void SetUseTiledAddressing( Bool _UseTiledAddressing );
+
+	/// <summary>Is the pixel-major storage only allocated for the tiles covered by the translucent objects ?</summary>
+	/// <returns>True if the storage is tile-sparse, False if every pixel has its K records.</returns>
+	Bool IsTileSparse() const;
+
+	/// <summary>
+	/// Must the pixel-major storage of the locked insertion be allocated by pages of 8x8 pixels, only for the tiles covered by the translucent objects ?<para/>
+	/// The screen rectangles of the translucent objects give a page to their tiles, the shaders find the page of a tile in a page table.
+	/// The memory scales with the covered area instead of the screen size. The pool grows for the next frame when a frame needs more pages.
+	/// </summary>
+	/// <param name="_IsTileSparse">True to allocate the pages of the covered tiles, False to allocate the K records of every pixel.</param>
+	void SetIsTileSparse( Bool _IsTileSparse );
+
+	/// <summary>Retrieve the pages of the tile-sparse storage used by the last frame.</summary>
+	/// <returns>The number of tiles of 8x8 pixels covered by the translucent objects of the last frame.</returns>
+	Uint32 GetLastUsedPagesCount() const;
+
+	/// <summary>Retrieve the pages allocated in the pool of the tile-sparse storage.</summary>
+	/// <returns>The capacity of the pool in pages.</returns>
+	Uint32 GetPagesCapacity() const;
+
+	/// <summary>Are the counts of the locked insertion tagged with the generation of the frame ?</summary>
+	/// <returns>True if the clear pass only changes the generation, False if it clears the whole storage.</returns>
+	Bool IsGenerationTagged() const;
+
+	/// <summary>
+	/// Must the counts of the locked insertion be tagged with the generation of the frame instead of clearing the storage every frame ?<para/>
+	/// A count written by a previous frame reads as 0 and the fragments after the count are never read : the clear pass only changes the generation.
+	/// </summary>
+	/// <param name="_IsGenerationTagged">True to tag the counts with the generation, False to clear the whole storage every frame.</param>
+	void SetIsGenerationTagged( Bool _IsGenerationTagged );
+
+	/// <summary>Are the fragments dropped from the full pixels accumulated in the overflow tail ?</summary>
+	/// <returns>True if the overflow tail is used, False if the dropped fragments are lost.</returns>
+	Bool IsOverflowTailUsed() const;
+
+	/// <summary>
+	/// Must the fragments dropped from the full pixels be accumulated in an overflow tail instead of being lost ?<para/>
+	/// The dropped fragment (the new one or the evicted furthest one) is accumulated with weighted blended OIT by the hardware blending, without lock.
+	/// The resolve pass composites the tail behind the K sorted fragments : a small K gets closer to the quality of a large K.<para/>
+	/// Used by the locked and lock free insertions, the translucency of the dropped fragments is approximated with the color at the max thickness.
+	/// </summary>
+	/// <param name="_UseOverflowTail">True to accumulate the dropped fragments, False to drop them.</param>
+	void SetUseOverflowTail( Bool _UseOverflowTail );
+
+	/// <summary>Retrieve the memory used to store the fragments with the current settings.</summary>
+	/// <returns>The size in bytes of the render targets (opaque color, depth and the blended targets when they are used) and of the fragments storage (semaphores, counts and fragments).</returns>
+	size_t GetStorageSize() const;
+
+	/// <summary>Retrieve the memory cleared by the last clear pass.</summary>
+	/// <returns>The size in bytes written by the last clear pass.</returns>
+	size_t GetLastClearSize() const;
+
+	/// <summary>Estimate the memory traffic of the store and resolve passes of a profiled frame with the current insertion mode and storage layout.</summary>
+	/// <param name="_Statistics">The statistics of the frame, with the counters of the store pass.</param>
+	/// <returns>The bytes read and written by the passes, zero for the cheaper techniques which do not count their fragments.</returns>
+	PassesTraffic EstimatePassesTraffic( const FrameStatistics& _Statistics ) const;
+
+
+	/// <summary>Is the fragment shader interlock used for the critical section of the locked insertion ?</summary>
+	/// <returns>True if the interlock is used, False if the semaphores are used.</returns>
+	Bool IsInterlockUsed() const;
+
+	/// <summary>
+	/// Must the locked insertion use the fragment shader interlock instead of the semaphores ?<para/>
+	/// Enabled by default when supported, ignored if the hardware does not support it.
+	/// </summary>
+	/// <param name="_UseInterlock">True to use the interlock, False to use the semaphores.</param>
+	void SetUseInterlock( Bool _UseInterlock );
+
+	/// <summary>Is the fragment shader interlock supported by the hardware ?</summary>
+	/// <returns>True if GL_ARB_fragment_shader_interlock is available, False otherwise.</returns>
+	static Bool IsInterlockSupported();
+
+
+	/// <summary>Are the fragments of the locked insertion kept as a per-pixel max-heap ?</summary>
+	/// <returns>True if the max-heap is used, False if the furthest fragment is searched linearly.</returns>
+	Bool IsMaxHeapUsed() const;
+
+	/// <summary>
+	/// Must the locked insertion keep the fragments of each pixel as a max-heap ordered by depth ?<para/>
+	/// The furthest fragment stays at the root : inserting costs O(log K) instead of a O(K) search of the next furthest fragment.<para/>
+	/// The resolve pass sorts the fragments by extracting them from the heap. Ignored by the lock free insertion.
+	/// </summary>
+	/// <param name="_UseMaxHeap">True to use the max-heap, False to search the furthest fragment linearly.</param>
+	void SetUseMaxHeap( Bool _UseMaxHeap );
+
+
+	/// <summary>Are the opaque objects rendered in the opaque pre-pass instead of being stored in the K-Buffer ?</summary>
+	/// <returns>True if the opaque pre-pass is used, False if every object is stored.</returns>
+	Bool IsOpaquePrePassUsed() const;
+
+	/// <summary>
+	/// Must the opaque objects be rendered in an opaque pre-pass instead of being stored in the K-Buffer ?<para/>
+	/// An object is opaque if its store pass material is not translucent and its base color alpha is 1 : it writes its color and depth with a regular depth test.<para/>
+	/// The other objects are tested against this depth during the store pass, hidden fragments never reach the K-Buffer, and the resolve pass blends over the opaque color.<para/>
+	/// Opaque objects should be drawn first : fragments stored before them are still resolved over the opaque color only if they are in front of it.
+	/// </summary>
+	/// <param name="_UseOpaquePrePass">True to render the opaque objects in the pre-pass, False to store every object.</param>
+	void SetUseOpaquePrePass( Bool _UseOpaquePrePass );
+
+	/// <summary>Are the draws, the clear pass and the resolve pass limited to the screen rectangles covered by the drawn objects ?</summary>
+	/// <returns>True if the passes are scissored, False if they cover the whole K-Buffer.</returns>
+	Bool IsScissorUsed() const;
+
+	/// <summary>
+	/// Must the bounds of each drawn object be projected to a screen rectangle, to scissor its store pass and skip it when it is out of the screen ?<para/>
+	/// The union of the rectangles of a frame, the dirty rectangle, is the only region cleared by the next clear pass and resolved by the resolve pass :
+	/// their cost follows the area covered by the objects instead of the resolution.<para/>
+	/// The bounds are read once from the vertex buffer of the 3D drawables, the other drawables cover the whole K-Buffer. Enabled by default.
+	/// </summary>
+	/// <param name="_UseScissor">True to scissor the passes, False otherwise.</param>
+	void SetUseScissor( Bool _UseScissor );
+
+	/// <summary>Are the frames updated incrementally, only where the drawn objects changed since the last frame ?</summary>
+	/// <returns>True if the frames are incremental, False if each frame is fully stored and resolved.</returns>
+	Bool IsIncremental() const;
+
+	/// <summary>
+	/// Must the frames be updated incrementally ?<para/>
+	/// The clear pass and the draws are only recorded, the resolve pass compares them to the last frame : the transform of each object with its camera, its material and the settings of the K-Buffer.
+	/// When nothing changed, the last resolved image is copied to the target without any pass. When some objects changed, only the union of their old and new screen rectangles is cleared, stored and resolved again.<para/>
+	/// The vertices of the drawn objects are assumed static. The storage buffers (lock free, pixel-major, linked lists and counted mode) cannot be partially cleared : any change updates the whole frame.
+	/// The profiling, the adaptive K and the occupancy record need every frame : the frames are not incremental while they are used.
+	/// </summary>
+	/// <param name="_IsIncremental">True to update the frames incrementally, False otherwise.</param>
+	void SetIsIncremental( Bool _IsIncremental );
+
+	/// <summary>Retrieve the number of pixels stored and resolved again by the last incremental frame.</summary>
+	/// <returns>The area of the updated rectangle, 0 if the last resolved image was reused.</returns>
+	Uint32 GetLastUpdatedPixelsCount() const;
+
+
+	/// <summary>Retrieve the algorithm used to sort and blend the stored fragments during the resolve pass.</summary>
+	/// <returns>The current resolve mode.</returns>
+	ResolveMode GetResolveMode() const;
+
+	/// <summary>Set the algorithm used to sort and blend the stored fragments during the resolve pass.</summary>
+	/// <param name="_Mode">The new resolve mode.</param>
+	void SetResolveMode( ResolveMode _Mode );
+
 
 	/// <summary>Is the final color of the resolve pass must be tone mapped ?</summary>
 	/// <returns>True if the K-Buffer apply the tone mapping, False otherwise.</returns>
@@ -65,23 +562,92 @@ public:
 	void SetGamma( float _Gamma );
 
 
-	/// <summary>Set the number of materials to save in the store pass.</summary>
+	/// <summary>
+	/// Set the number of materials to save in the store pass.<para/>
+	/// The material table grows by itself when a new material is drawn, it avoids reallocations during the first frames.<para/>
+	/// The fragment records keep 8 bits of the material index : the table holds at most 256 materials, a larger count is clamped with a warning.
+	/// </summary>
 	/// <param name="_Count">Maximum number of materials storable.</param>
 	void SetStorePassMaterialCount( Int32 _Count );
 
-	/// <summary>Resize the K-Buffer and all its images.</summary>
+	/// <summary>
+	/// Resize the rendered area of the K-Buffer.<para/>
+	/// The framebuffer and the images are allocated with headroom, rounded up to steps of 64 pixels : the passes render in the bottom left corner of the allocation.
+	/// They are only reallocated when the new size exceeds the allocated size or when it covers less than a quarter of it, a viewport dragged every frame does not reallocate them.
+	/// </summary>
 	/// <param name="_Width">The new width of the K-Buffer.</param>
 	/// <param name="_Height">The new Height of the K-Buffer.</param>
 	void Resize( Uint32 _Width, Uint32 _Height ) override;
 
+	/// <summary>Retrieve the width rendered by the passes, GetWidth being the allocated width.</summary>
+	/// <returns>The width given to the last resize, divided by the resolution divisor, times the number of views.</returns>
+	Uint32 GetRenderWidth() const;
+
+	/// <summary>Retrieve the height rendered by the passes, GetHeight being the allocated height.</summary>
+	/// <returns>The height given to the last resize, divided by the resolution divisor.</returns>
+	Uint32 GetRenderHeight() const;
+
+	/// <summary>Retrieve the downscale factor of the K-Buffer.</summary>
+	/// <returns>1 at the resolution of the target, 2 at half resolution, up to 4.</returns>
+	Uint32 GetResolutionDivisor() const;
+
+	/// <summary>
+	/// Set the downscale factor of the K-Buffer : the store and resolve passes run at the size given to the resize divided by it, the memory and the store pass cost are divided by its square.<para/>
+	/// The resolve pass resolves the fragments in a low resolution image with their coverage, then upsamples it in the target with a bilateral filter guided by the nearest depth of the drawn objects,
+	/// written at the target resolution by a depth only draw of each object. The incremental update is not used below the target resolution.
+	/// </summary>
+	/// <param name="_Divisor">The new divisor, from 1 (target resolution) to 4.</param>
+	void SetResolutionDivisor( Uint32 _Divisor );
+
+	/// <summary>Reallocate the framebuffer and the images to the rendered size, without headroom, to release the memory of a larger size.</summary>
+	void TrimMemory();
+
+	/// <summary>Retrieve the number of views stored by each draw.</summary>
+	/// <returns>The number of cameras given to SetViews, 1 for the single view rendering.</returns>
+	Uint32 GetViewsCount() const;
+
+	/// <summary>
+	/// Set the cameras of several views of the same scene (viewport, thumbnail, stereo eyes) rendered by the same passes, up to 4.<para/>
+	/// The views are side by side in the K-Buffer, each one at the size given to the resize : each view has its own pixels, with their own K fragments.
+	/// Each draw stores the object in every view with a single instanced draw, the camera given to the draw is ignored. ResolveViews resolves every view at once.<para/>
+	/// The thickness of the translucent objects is measured with the near and far planes of the first camera. The views are rendered at the target resolution without incremental update.
+	/// </summary>
+	/// <param name="_Cameras">The cameras of the views, they must stay alive while they are set. None or a single one for the single view rendering, with the camera given to the draws.</param>
+	void SetViews( const std::vector<ae::Camera*>& _Cameras );
+
+	/// <summary>Bind the K-Buffer to hold the result of the next draws, with a viewport on the rendered size.</summary>
+	void Bind() override;
+
 	/// <summary>Remove the stored data from the K-Buffer and reset semaphores and fragment counts.</summary>
 	void ClearPass();
 
-	/// <summary>Draw an object to the K-Buffer during the "store pass".</summary>
+	/// <summary>
+	/// Draw an object to the K-Buffer during the "store pass".<para/>
+	/// In the counted mode and the moment based OIT, the translucent objects and their camera are drawn again by the resolve pass : they must stay alive until then.
+	/// </summary>
 	/// <param name="_Object">The object to draw.</param>
 	/// <param name="_Camera">Optionnal camera. If null, the current active camera will be taken.</param>
 	void Draw( const ae::Drawable& _Object, ae::Camera* _Camera = nullptr ) override;
 
+	/// <summary>
+	/// Draw several objects to the K-Buffer during the "store pass" with a single draw call.<para/>
+	/// The meshes of the translucent objects are copied once in a vertex and index arena shared by the batches, their transforms and material indices are uploaded for each batch.
+	/// The objects that cannot be batched (opaque, without a StorePassMaterial, not triangles of 3D vertices) are drawn one by one before the batch.<para/>
+	/// The counted mode, the moment based OIT, several views and the resolutions below the target draw every object one by one.
+	/// The incremental frames record the batch, stored again with one batch by the resolve pass when its pixels changed.
+	/// </summary>
+	/// <param name="_Objects">The objects to draw, in any order. Null objects are skipped.</param>
+	/// <param name="_Camera">Optionnal camera. If null, the current active camera will be taken.</param>
+	void DrawBatch( const std::vector<const ae::Drawable*>& _Objects, ae::Camera* _Camera = nullptr );
+
+	/// <summary>
+	/// Forget the bounds of the mesh of a drawable, read back from its vertex buffer to scissor its draws.<para/>
+	/// The bounds are read again when the vertex buffer is reallocated, but not when its content is updated in place :
+	/// call it after such an update, and before destroying a drawable drawn by the K-Buffer.
+	/// </summary>
+	/// <param name="_Object">The drawable whose mesh changed.</param>
+	void InvalidateMesh( const ae::Drawable& _Object );
+
 	/// <summary>
 	/// Resolve pass of the K-Buffer : <para/>
 	/// Sort the stored fragments and blend them.
@@ -92,6 +658,23 @@ public:
 	/// <param name="_Camera">Optionnal camera. If null, the current active camera will be taken.</param>
 	void Resolve( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor = ae::Color::Black, ae::Camera* _Camera = nullptr );
 
+	/// <summary>
+	/// Resolve pass of every view set with SetViews : the views are resolved together, then copied to their targets.<para/>
+	/// The targets are cleared, their depth included. With a single view, the first target is resolved like with Resolve.
+	/// </summary>
+	/// <param name="_Targets">The target of each view, in the order of the cameras. A null target skips its view.</param>
+	/// <param name="_BackgroundColor">The color of the pixels without opaque object.</param>
+	void ResolveViews( const std::vector<ae::Framebuffer*>& _Targets, const ae::Color& _BackgroundColor = ae::Color::Black );
+
+	/// <summary>
+	/// Measure the difference between two resolved images, to decide if a cheaper technique is acceptable against the K-Buffer result.<para/>
+	/// The color textures of the framebuffers are compared on their common size. Waits for the GPU : meant for tools and benchmarks, not for every frame.
+	/// </summary>
+	/// <param name="_Reference">The framebuffer of the reference image, usually resolved with the K-Buffer technique.</param>
+	/// <param name="_Compared">The framebuffer of the compared image.</param>
+	/// <returns>The mean, root mean square and max difference of the pixels, 0 if a framebuffer has no 2D color texture.</returns>
+	ImageDifference MeasureDifference( const ae::Framebuffer& _Reference, const ae::Framebuffer& _Compared );
+
 
 	/// <summary>
 	/// Function called by the editor.
@@ -100,35 +683,1010 @@ public:
 	/// </summary>
 	void ToEditor() override;
 
+private:
+	/// <summary>The shaders of the K-Buffer compiled for one value of K. Each shader is compiled the first time it is used.</summary>
+	struct ShaderPermutation
+	{
+		/// <summary>The shader used to store the fragment of drawn objects with the semaphores.</summary>
+		std::unique_ptr<GraphicsShader> StorePass;
+
+		/// <summary>The store pass shader with the fragment shader interlock critical section.</summary>
+		std::unique_ptr<GraphicsShader> StorePassInterlock;
+
+		/// <summary>The store pass shader of the lock free mode.</summary>
+		std::unique_ptr<GraphicsShader> StorePassLockFree;
+
+		/// <summary>The shader used to sort and blend the stored fragments.</summary>
+		std::unique_ptr<GraphicsShader> ResolvePass;
+
+		/// <summary>The resolve pass shader of the lock free mode.</summary>
+		std::unique_ptr<GraphicsShader> ResolvePassLockFree;
+
+		/// <summary>The compute shader classifying the tiles of the tiled resolve.</summary>
+		std::unique_ptr<ComputeShader> ResolveClassify;
+
+		/// <summary>The compute shaders resolving the tiles, one per sorting network size (2, 4, 8 and 16).</summary>
+		std::array<std::unique_ptr<ComputeShader>, 4> ResolveTiles;
+	};
+
+	/// <summary>Render targets written by a store pass draw, with the hardware blending.</summary>
+	enum class StorePassTargets : Uint8
+	{
+		/// <summary>The opaque color of the opaque pre-pass.</summary>
+		OpaqueColor,
+
+		/// <summary>No target : the fragments are only written in the storage.</summary>
+		Storage,
+
+		/// <summary>Accumulation and revealage of the overflow tail and of the weighted blended OIT.</summary>
+		WeightedBlended,
+
+		/// <summary>Absorbance and power moments of the first pass of the moment based OIT.</summary>
+		Moments,
+
+		/// <summary>Accumulation of the second pass of the moment based OIT.</summary>
+		MomentsAccumulation
+	};
+
+	/// <summary>Rectangle of pixels in the window coordinates of OpenGL, from the bottom left corner. The max bounds are excluded, the rectangle is empty when a min is not below its max.</summary>
+	struct PixelRect
+	{
+		Uint32 MinX;
+		Uint32 MinY;
+		Uint32 MaxX;
+		Uint32 MaxY;
+	};
+
+	/// <summary>Bounds of the vertices of a drawable in its local space, read back from its vertex buffer without waiting for the GPU.</summary>
+	struct LocalBounds
+	{
+		/// <summary>Minimum of the vertex positions.</summary>
+		ae::Vector3 Min;
+
+		/// <summary>Maximum of the vertex positions.</summary>
+		ae::Vector3 Max;
+
+		/// <summary>Vertex buffer and its size when the bounds were read : the bounds are read again when one of them changes.</summary>
+		Uint32 VertexBuffer;
+		Int64 BufferSize;
+
+		/// <summary>Copy of the vertices being read back and the fence signaled when the copy is done, null when no read is pending.</summary>
+		std::unique_ptr<GPUBuffer> Readback;
+		GLsync Fence;
+
+		/// <summary>Are the bounds known ? False until the vertices are read back, without vertex or for the drawables without 3D vertices.</summary>
+		Bool IsValid;
+	};
+
+	/// <summary>An object drawn by the first pass of the counted mode or of the moment based OIT, drawn again by the resolve.</summary>
+	struct ReplayedDraw
+	{
+		/// <summary>The drawn object.</summary>
+		const ae::Drawable* Object;
+
+		/// <summary>The camera used to draw it.</summary>
+		ae::Camera* Camera;
+
+		/// <summary>The screen rectangle of the object, scissoring its draws.</summary>
+		PixelRect Rect;
+	};
+
+	/// <summary>Queries and counters of a profiled frame, read back once the GPU is done with them.</summary>
+	struct ProfiledFrame
+	{
+		/// <summary>Time stamp queries in the order they are written : start and end of the clear pass, of each draw, then of the resolve pass.</summary>
+		std::vector<Uint32> Queries;
+
+		/// <summary>Number of time stamps written by the frame.</summary>
+		size_t TimeStampsCount;
+
+		/// <summary>Copy of the counters of the store pass.</summary>
+		GPUBuffer StatisticsReadback;
+
+		/// <summary>Fence signaled when the frame is done, null when the frame is not pending.</summary>
+		GLsync Fence;
+
+		/// <summary>K used by the frame.</summary>
+		Uint32 K;
+	};
+
+	/// <summary>Parameters of a store pass material as read by the resolve pass (std430 layout of the material table).</summary>
+	struct MaterialTableEntry
+	{
+		/// <summary>Surface color and opacity.</summary>
+		ae::Color BaseColor;
+
+		/// <summary>Color at the max thickness of translucent objects.</summary>
+		ae::Color TranslucentColor;
+
+		/// <summary>1.0 if the material is translucent, 0.0 otherwise.</summary>
+		float IsTranslucent;
+
+		/// <summary>Thickness where the color of translucent objects is the translucent color.</summary>
+		float MaxTranslucentThickness;
+
+		/// <summary>Padding to the std430 alignment of the entry (vec4).</summary>
+		float Padding[2];
+	};
+
+	/// <summary>An object drawn by an incremental frame, compared to the objects of the last frame.</summary>
+	struct RecordedDraw
+	{
+		/// <summary>The drawn object.</summary>
+		const ae::Drawable* Object;
+
+		/// <summary>The camera used to draw it.</summary>
+		ae::Camera* Camera;
+
+		/// <summary>Transform of the object with its camera when it was drawn.</summary>
+		ae::Matrix4x4 ModelViewProjection;
+
+		/// <summary>The material of the object when it was drawn.</summary>
+		const ae::Material* Material;
+
+		/// <summary>Parameters of the material when it was drawn.</summary>
+		MaterialTableEntry MaterialEntry;
+
+		/// <summary>Version of the instances of an instanced drawable when it was drawn, 0 for the other objects.</summary>
+		Uint64 InstancesVersion;
+
+		/// <summary>The screen rectangle of the object.</summary>
+		PixelRect Rect;
+
+		/// <summary>The batch drawing the object, numbered from 1 in the frame, 0 for the objects drawn one by one.</summary>
+		Uint32 Batch;
+	};
+
+	/// <summary>The mesh of a batched object copied in the batch arena.</summary>
+	struct BatchMesh
+	{
+		/// <summary>Vertex and elements buffers of the object when its mesh was copied : the mesh is copied again when one of them is reallocated.</summary>
+		Uint32 VertexBuffer;
+		Uint32 ElementsBuffer;
+
+		/// <summary>Number of vertices of the mesh.</summary>
+		Uint32 VerticesCount;
+
+		/// <summary>Number of indices of the mesh.</summary>
+		Uint32 IndicesCount;
+
+		/// <summary>Index of the first vertex of the mesh in the arena.</summary>
+		Uint32 FirstVertex;
+
+		/// <summary>Index of the first index of the mesh in the arena.</summary>
+		Uint32 FirstIndex;
+	};
+
+	/// <summary>Command of a multi-draw indirect with indices, as read by OpenGL.</summary>
+	struct DrawElementsCommand
+	{
+		Uint32 Count;
+		Uint32 InstanceCount;
+		Uint32 FirstIndex;
+		Int32 BaseVertex;
+		Uint32 BaseInstance;
+	};
+
+	/// <summary>Settings of the K-Buffer and of the resolve pass changing the resolved image of an incremental frame, copied from the members and parameters of the same name.</summary>
+	struct IncrementalSettings
+	{
+		Uint32 Width;
+		Uint32 Height;
+		Uint32 K;
+		Uint32 FragmentPoolCapacity;
+		TransparencyTechnique Technique;
+		InsertionMode Insertion;
+		StorageLayout Layout;
+		ResolveMode Resolve;
+		DebugView View;
+		Bool UseInterlock;
+		Bool UseMaxHeap;
+		Bool UseTiledAddressing;
+		Bool IsGenerationTagged;
+		Bool UseOverflowTail;
+		Bool UseOpaquePrePass;
+		Bool IsShaderSpecialized;
+		Bool IsToneMapped;
+		Bool IsGammaCorrected;
+		float Exposure;
+		float Gamma;
+		ae::Color BackgroundColor;
+		ae::Matrix4x4 ViewProjection;
+	};
+
+private:
+	/// <summary>Allocate the storage used by the current insertion mode and release the other one.</summary>
+	void UpdateStorage();
+
+	/// <summary>Allocate the blended targets used by the current technique and release the other ones.</summary>
+	void UpdateBlendedTargets();
+
+	/// <summary>Read the count of fragments allocated by a previous frame if the GPU is done with it, and grow the fragment pool if it overflowed.</summary>
+	void ReadAllocatedFragmentsCount();
+
+	/// <summary>Is the adaptive K used by the current technique and insertion mode ?</summary>
+	/// <returns>True if K is adaptive with the locked or lock free insertion of the K-Buffer technique, False otherwise.</returns>
+	Bool IsAdaptiveKActive() const;
+
+	/// <summary>Start to profile a frame if the profiling or the adaptive K is used and the GPU is done with the previous frame using the same queries.</summary>
+	void BeginProfiledFrame();
+
+	/// <summary>Finish the profiled frame : copy its counters and place a fence to read them back once the GPU is done.</summary>
+	void EndProfiledFrame();
+
+	/// <summary>Write a time stamp in the next query of the profiled frame, create the query if needed.</summary>
+	void WriteTimeStamp();
+
+	/// <summary>Read the statistics of the profiled frames the GPU is done with, and adapt K to them.</summary>
+	void ReadProfiledFrames();
+
+	/// <summary>Adapt K to the statistics of a frame.</summary>
+	/// <param name="_Statistics">The statistics of the profiled frame.</param>
+	/// <param name="_K">K used by the profiled frame : the statistics of another K do not change K.</param>
+	void AdaptK( const FrameStatistics& _Statistics, Uint32 _K );
+
+	/// <summary>Is the occupancy of the pixels recorded by the current technique and insertion mode ?</summary>
+	/// <returns>True if a debug view is shown or the occupancy is recorded with the locked insertion of the K-Buffer technique, False otherwise.</returns>
+	Bool IsOccupancyRecordActive() const;
+
+	/// <summary>Allocate the occupancy images when the occupancy is recorded and clear them, release them otherwise.</summary>
+	/// <returns>The size in bytes of the cleared images.</returns>
+	size_t ClearOccupancy();
+
+	/// <summary>Build the depth complexity histogram from the occupancy of the store pass and copy it to read it once the GPU is done.</summary>
+	void RecordDepthComplexityHistogram();
+
+	/// <summary>Read the depth complexity histogram of a previous frame if the GPU is done with it.</summary>
+	void ReadDepthComplexityHistogram();
+
+	/// <summary>Show the occupancy of the debug view with a fullscreen quad in the bound target.</summary>
+	void ResolveDebugView();
+
+	/// <summary>Clear the storage of the locked insertion used by the current K : semaphores, counts and fragments.</summary>
+	/// <param name="_Rect">The cleared pixels of the images, the pixel-major buffer is always fully cleared.</param>
+	/// <returns>The size in bytes of the cleared storage.</returns>
+	size_t ClearLockedStorage( const PixelRect& _Rect );
+
+	/// <summary>Is the tile-sparse storage used by the current settings : pixel-major layout of the locked insertion ?</summary>
+	/// <returns>True if the fragments are stored in the pages of the covered tiles.</returns>
+	Bool IsTileSparseActive() const;
+
+	/// <summary>Retrieve the number of tiles of 8x8 pixels of the storage.</summary>
+	/// <returns>The number of entries of the page table.</returns>
+	Uint32 GetTilesCount() const;
+
+	/// <summary>Tile-sparse storage : shrink the pool when it was underused for many frames and remove the pages of every tile.</summary>
+	/// <returns>The size in bytes of the cleared page table.</returns>
+	size_t ResetTilePages();
+
+	/// <summary>Tile-sparse storage : give a cleared page to the tiles of the rectangle without page, growing the pool when it has not enough free pages.</summary>
+	/// <param name="_Rect">The screen rectangle of a translucent object.</param>
+	void AllocateTilePages( const PixelRect& _Rect );
+
+	/// <summary>Tile-sparse storage : reallocate a larger pool, keeping the pages already given to the tiles.</summary>
+	/// <param name="_PagesCount">The number of pages needed.</param>
+	void GrowTilePages( Uint32 _PagesCount );
+
+	/// <summary>Retrieve the rectangle of all the pixels of the K-Buffer.</summary>
+	/// <returns>The full screen rectangle.</returns>
+	PixelRect GetFullRect() const;
+
+	/// <summary>Project the bounds of an object to the screen, the whole view without scissor or when the bounds are unknown or behind the camera.</summary>
+	/// <param name="_Object">The drawn object.</param>
+	/// <param name="_Camera">The camera used to draw it.</param>
+	/// <param name="_ViewRect">The pixels of the view of the camera in the K-Buffer.</param>
+	/// <returns>The pixels covered by the object, empty if it is out of the view.</returns>
+	PixelRect GetScreenRect( const ae::Drawable& _Object, ae::Camera& _Camera, const PixelRect& _ViewRect );
+
+	/// <summary>Are several views set ?</summary>
+	/// <returns>True if the draws are stored in several views side by side, False otherwise.</returns>
+	Bool IsMultiView() const;
+
+	/// <summary>Is the K-Buffer rendered below the target resolution ? Never with several views.</summary>
+	/// <returns>True if the resolve pass upsamples the stored fragments, False otherwise.</returns>
+	Bool IsUpsampled() const;
+
+	/// <summary>Retrieve the pixels of a view in the K-Buffer.</summary>
+	/// <param name="_View">The index of the view.</param>
+	/// <returns>The column of the rendered area of the view.</returns>
+	PixelRect GetViewRect( Uint32 _View ) const;
+
+	/// <summary>Send the view projection of each view to a store pass shader, the draws of several views are instanced once per view.</summary>
+	/// <typeparam name="ShaderType">ae::Shader for the opaque pre-pass, GraphicsShader otherwise.</typeparam>
+	/// <param name="_Shader">The bound shader of the store pass.</param>
+	template<typename ShaderType>
+	void SendViews( const ShaderType& _Shader );
+
+	/// <summary>Send the camera to the bound shader, through the engine for its own shaders.</summary>
+	/// <param name="_Shader">The bound shader.</param>
+	/// <param name="_Camera">The camera to send.</param>
+	static void SendCamera( const ae::Shader& _Shader, ae::Camera& _Camera );
+
+	/// <summary>Send the camera to the bound shader : the view and projection matrices, the position and the clipping planes, like the engine does for its shaders.</summary>
+	/// <param name="_Shader">The bound shader.</param>
+	/// <param name="_Camera">The camera to send.</param>
+	static void SendCamera( const GraphicsShader& _Shader, ae::Camera& _Camera );
+
+	/// <summary>Send the material parameters and the transform of an object to the bound shader, through the engine for its own shaders.</summary>
+	/// <param name="_Shader">The bound shader.</param>
+	/// <param name="_Object">The drawn object.</param>
+	static void SendObject( const ae::Shader& _Shader, const ae::Drawable& _Object );
+
+	/// <summary>Send the transform and the material index of an object to the bound store pass shader, the other material parameters are in the material table.</summary>
+	/// <param name="_Shader">The bound shader.</param>
+	/// <param name="_Object">The drawn object.</param>
+	static void SendObject( const GraphicsShader& _Shader, const ae::Drawable& _Object );
+
+	/// <summary>Draw the instances of an object with the bound shader : one per view, times the instances of an instanced drawable.</summary>
+	/// <param name="_Object">The drawn object.</param>
+	void DrawInstances( const ae::Drawable& _Object );
+
+	/// <summary>Retrieve the nearest depths guiding the upsampling, created cleared or reallocated with the headroom of the K-Buffer at the target size.</summary>
+	/// <returns>The framebuffer of the guide depths.</returns>
+	ae::Framebuffer& GetGuideDepths();
+
+	/// <summary>Retrieve the resolved image, created or reallocated with the allocated size.</summary>
+	/// <returns>The framebuffer of the resolved image.</returns>
+	ae::Framebuffer& GetResolvedImage();
+
+	/// <summary>
+	/// Retrieve the local bounds of an object, read back from its vertex buffer the first time it is drawn or when its buffer is reallocated.<para/>
+	/// The read back never waits for the GPU : the bounds are unknown for the frames drawn before the copy of the vertices is done.
+	/// </summary>
+	/// <param name="_Object">The drawn object.</param>
+	/// <returns>The bounds of its vertices.</returns>
+	const LocalBounds& GetLocalBounds( const ae::Drawable& _Object );
+
+	/// <summary>Cancel the pending read back of some bounds.</summary>
+	/// <param name="_Bounds">The bounds of an object.</param>
+	static void ReleaseBoundsReadback( LocalBounds& _Bounds );
+
+	/// <summary>Compute the transform of an object with a camera, as done by the store pass vertex shader.</summary>
+	/// <param name="_Object">The drawn object.</param>
+	/// <param name="_Camera">The camera used to draw it.</param>
+	/// <returns>The model view projection matrix of the object.</returns>
+	static ae::Matrix4x4 GetModelViewProjection( const ae::Drawable& _Object, ae::Camera& _Camera );
+
+	/// <summary>Compute the smallest rectangle containing two rectangles, an empty rectangle is ignored.</summary>
+	/// <param name="_RectA">The first rectangle.</param>
+	/// <param name="_RectB">The second rectangle.</param>
+	/// <returns>The union of the rectangles.</returns>
+	static PixelRect UniteRects( const PixelRect& _RectA, const PixelRect& _RectB );
+
+	/// <summary>Compute the pixels common to two rectangles.</summary>
+	/// <param name="_RectA">The first rectangle.</param>
+	/// <param name="_RectB">The second rectangle.</param>
+	/// <returns>The intersection of the rectangles, empty if they do not overlap.</returns>
+	static PixelRect IntersectRects( const PixelRect& _RectA, const PixelRect& _RectB );
+
+	/// <summary>Is a rectangle empty ?</summary>
+	/// <param name="_Rect">The rectangle to check.</param>
+	/// <returns>True if the rectangle has no pixel, False otherwise.</returns>
+	static Bool IsRectEmpty( const PixelRect& _Rect );
+
+	/// <summary>Retrieve the rectangle of all the allocated pixels, larger than the full rectangle with the headroom of the resizes.</summary>
+	/// <returns>The rectangle of the allocated size.</returns>
+	PixelRect GetAllocatedRect() const;
+
+	/// <summary>Compute the allocated size for a rendered size, with headroom for the next resizes.</summary>
+	/// <param name="_Size">The rendered width or height.</param>
+	/// <returns>The size plus an eighth, rounded up to a multiple of 64 pixels.</returns>
+	static Uint32 GetAllocatedSize( Uint32 _Size );
+
+	/// <summary>Change the rendered size, the framebuffer and the images are reallocated only if it does not fit or if it is far below the allocated size.</summary>
+	/// <param name="_Width">The new rendered width.</param>
+	/// <param name="_Height">The new rendered height.</param>
+	void ResizeRenderedArea( Uint32 _Width, Uint32 _Height );
+
+	/// <summary>Must an allocation be reallocated for a new size ?</summary>
+	/// <param name="_Width">The new width.</param>
+	/// <param name="_Height">The new height.</param>
+	/// <param name="_AllocatedWidth">The allocated width.</param>
+	/// <param name="_AllocatedHeight">The allocated height.</param>
+	/// <returns>True if the size does not fit the allocation or covers less than a quarter of it, False otherwise.</returns>
+	static Bool IsReallocationNeeded( Uint32 _Width, Uint32 _Height, Uint32 _AllocatedWidth, Uint32 _AllocatedHeight );
+
+	/// <summary>Allocate the guide depths for the size given to the resize and clear them.</summary>
+	void ClearGuideDepths();
+
+	/// <summary>Draw the depth of an object in the guide depths at the size given to the resize, the K-Buffer is bound again after.</summary>
+	/// <param name="_Object">The drawn object.</param>
+	/// <param name="_Camera">The camera used to draw it.</param>
+	void DrawGuideDepth( const ae::Drawable& _Object, ae::Camera& _Camera );
+
+	/// <summary>Resolve the stored fragments in the low resolution image and upsample it in a target.</summary>
+	/// <param name="_Target">The final texture to draw on.</param>
+	/// <param name="_ClearTarget">Must the <paramref name="_Target"/> be cleared ?</param>
+	/// <param name="_BackgroundColor">The color of the pixels without opaque object.</param>
+	/// <param name="_Camera">The camera of the resolve pass.</param>
+	void ResolveUpsampled( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera& _Camera );
+
+	/// <summary>Copy pixels of the resolved image to a cleared target, scaled to the size of the target.</summary>
+	/// <param name="_Target">The target of the resolve pass.</param>
+	/// <param name="_SourceRect">The copied pixels of the resolved image : the rendered pixels or the pixels of a view.</param>
+	/// <param name="_BackgroundColor">The clear color of the target.</param>
+	void BlitResolvedImage( ae::Framebuffer& _Target, const PixelRect& _SourceRect, const ae::Color& _BackgroundColor );
+
+	/// <summary>Enable the scissor test of OpenGL on a rectangle of pixels.</summary>
+	/// <param name="_Rect">The pixels that can be written.</param>
+	static void EnableScissor( const PixelRect& _Rect );
+
+	/// <summary>Is the fragment pool used by the current insertion mode ?</summary>
+	/// <returns>True for the linked lists and the counted mode, False otherwise.</returns>
+	Bool IsFragmentPoolUsed() const;
+
+	/// <summary>Retrieve the size of the fragment pool for the current insertion mode and capacity.</summary>
+	/// <returns>The size in bytes of the allocated count and the fragments of the pool, 0 if the pool is not used.</returns>
+	size_t GetFragmentPoolSize() const;
+
+	/// <summary>Clear the storage and the targets of the K-Buffer in the dirty rectangle, with the whole buffers of the storage.</summary>
+	/// <param name="_IsPartialUpdate">Is it the partial update of an incremental frame ? The generation is kept : the pixels out of the dirty rectangle keep their fragments.</param>
+	void ClearStoredFragments( Bool _IsPartialUpdate );
+
+	/// <summary>Store an object in the bound K-Buffer, or in the opaque color for the opaque pre-pass.</summary>
+	/// <param name="_Object">The object to draw.</param>
+	/// <param name="_Camera">The camera to draw the object with.</param>
+	/// <param name="_Rect">The screen rectangle of the object, not empty.</param>
+	void StoreObject( const ae::Drawable& _Object, ae::Camera& _Camera, const PixelRect& _Rect );
+
+	/// <summary>Store the batched objects in the bound K-Buffer with one multi-draw.</summary>
+	/// <param name="_Camera">The camera to draw the objects with.</param>
+	void StoreBatch( ae::Camera& _Camera );
+
+	/// <summary>Put the materials of a translucent object in the material table and allocate the pages of the tiles it covers, before it stores its fragments.</summary>
+	/// <param name="_Object">The object to store.</param>
+	/// <param name="_Rect">The screen rectangle of the object.</param>
+	void PrepareStoredObject( const ae::Drawable& _Object, const PixelRect& _Rect );
+
+	/// <summary>Record an object drawn by an incremental frame, stored by the resolve pass if its pixels changed.</summary>
+	/// <param name="_Object">The drawn object.</param>
+	/// <param name="_Camera">The camera to draw the object with.</param>
+	/// <param name="_Rect">The screen rectangle of the object, empty out of the screen.</param>
+	/// <param name="_Batch">The batch drawing the object, 0 if it is drawn alone.</param>
+	void RecordDraw( const ae::Drawable& _Object, ae::Camera& _Camera, const PixelRect& _Rect, Uint32 _Batch );
+
+	/// <summary>Sort and blend the stored fragments in a target.</summary>
+	/// <param name="_Target">The final texture to draw on.</param>
+	/// <param name="_ClearTarget">Must the <paramref name="_Target"/> be cleared ?</param>
+	/// <param name="_BackgroundColor">The color of the pixels without opaque object.</param>
+	/// <param name="_Camera">The camera of the resolve pass.</param>
+	void ResolveStoredFragments( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera& _Camera );
+
+	/// <summary>Are the frames recorded to be updated incrementally by the resolve pass ?</summary>
+	/// <returns>True if the frames are incremental and no feature needs every frame, False otherwise.</returns>
+	Bool IsIncrementalActive() const;
+
+	/// <summary>Can the storage of the current insertion be cleared in a rectangle, for a partial update of an incremental frame ?</summary>
+	/// <returns>True for the cheaper techniques and the layer-major images of the locked insertion, with or without generation, False otherwise.</returns>
+	Bool IsPartialUpdateSupported() const;
+
+	/// <summary>Retrieve the settings changing the resolved image of an incremental frame.</summary>
+	/// <param name="_BackgroundColor">The background color of the resolve pass.</param>
+	/// <param name="_Camera">The camera of the resolve pass.</param>
+	/// <returns>The current settings.</returns>
+	IncrementalSettings GetIncrementalSettings( const ae::Color& _BackgroundColor, ae::Camera& _Camera ) const;
+
+	/// <summary>Compute the pixels of an incremental frame that changed since the last frame.</summary>
+	/// <param name="_Settings">The settings of the frame.</param>
+	/// <returns>The whole K-Buffer when the settings or the list of objects changed, the union of the old and new rectangles of the changed objects otherwise.</returns>
+	PixelRect GetIncrementalUpdateRect( const IncrementalSettings& _Settings ) const;
+
+	/// <summary>Store and resolve again the changed pixels of a recorded frame in the last resolved image, and copy it to a target.</summary>
+	/// <param name="_Target">The final texture to draw on.</param>
+	/// <param name="_ClearTarget">Must the <paramref name="_Target"/> be cleared ? Without clear, the frame is fully resolved in the target.</param>
+	/// <param name="_BackgroundColor">The color of the pixels without opaque object.</param>
+	/// <param name="_Camera">The camera of the resolve pass.</param>
+	void ResolveIncremental( ae::Framebuffer& _Target, Bool _ClearTarget, const ae::Color& _BackgroundColor, ae::Camera& _Camera );
+
+	/// <summary>Read the parameters of a store pass material, as written in the material table.</summary>
+	/// <param name="_Material">The material to read.</param>
+	/// <returns>The entry of the material, zero for the materials which are not store pass materials.</returns>
+	static MaterialTableEntry GetMaterialEntry( const ae::Material& _Material );
+
+	/// <summary>Are the parameters of two entries of the material table equal ?</summary>
+	/// <param name="_EntryA">The first entry.</param>
+	/// <param name="_EntryB">The second entry.</param>
+	/// <returns>True if every parameter is equal, False otherwise.</returns>
+	static Bool AreMaterialEntriesEqual( const MaterialTableEntry& _EntryA, const MaterialTableEntry& _EntryB );
+
+	/// <summary>Draw an object with a store pass shader in the bound K-Buffer.</summary>
+	/// <typeparam name="ShaderType">ae::Shader for the opaque pre-pass, GraphicsShader otherwise.</typeparam>
+	/// <param name="_Object">The object to draw.</param>
+	/// <param name="_Camera">The camera to draw the object with.</param>
+	/// <param name="_Targets">The render targets written by the pass, the opaque color for the opaque pre-pass.</param>
+	/// <param name="_Shader">The shader of the pass : opaque pre-pass, store pass, count pass or pass of a cheaper technique.</param>
+	/// <param name="_Rect">The screen rectangle of the object, the draw is scissored to it.</param>
+	template<typename ShaderType>
+	void DrawStorePass( const ae::Drawable& _Object, ae::Camera& _Camera, StorePassTargets _Targets, ShaderType& _Shader, const PixelRect& _Rect );
+
+	/// <summary>Set the depth test, the draw buffers and the blending of a store pass.</summary>
+	/// <param name="_Targets">The render targets written by the pass.</param>
+	void BeginStorePass( StorePassTargets _Targets );
+
+	/// <summary>Bind a store pass shader with the camera and the storage of its targets.</summary>
+	/// <typeparam name="ShaderType">ae::Shader for the opaque pre-pass, GraphicsShader otherwise.</typeparam>
+	/// <param name="_Camera">The camera to draw the objects with.</param>
+	/// <param name="_Targets">The render targets written by the pass.</param>
+	/// <param name="_Shader">The shader of the pass.</param>
+	/// <param name="_HasInstanceAttributes">Are the transforms and the material indices per instance attributes, of a batch or of an instanced drawable ?</param>
+	template<typename ShaderType>
+	void BindStorePassShader( ae::Camera& _Camera, StorePassTargets _Targets, ShaderType& _Shader, Bool _HasInstanceAttributes );
+
+	/// <summary>Restore the draw buffers and the depth mode of the K-Buffer after a store pass.</summary>
+	/// <param name="_Targets">The render targets written by the pass.</param>
+	void EndStorePass( StorePassTargets _Targets );
+
+	/// <summary>Can the draws be batched with the current settings ?</summary>
+	/// <returns>True if the translucent objects can be stored by one multi-draw, False if every object must be drawn one by one.</returns>
+	Bool IsBatchSupported() const;
+
+	/// <summary>Can an object be stored by a batch ?</summary>
+	/// <param name="_Object">The object to draw.</param>
+	/// <returns>True for the translucent objects of a StorePassMaterial made of indexed triangles of 3D vertices, False otherwise.</returns>
+	Bool IsBatchable( const ae::Drawable& _Object );
+
+	/// <summary>Copy the meshes of the batched objects missing from the batch arena, compacted to the meshes of the batch when it is full and grown only when they do not fit.</summary>
+	void UpdateBatchMeshes();
+
+	/// <summary>Store the batched objects with one multi-draw indirect of the store pass shader.</summary>
+	/// <param name="_Camera">The camera to draw the objects with.</param>
+	/// <param name="_Targets">The render targets written by the pass, the storage or the weighted blended accumulations.</param>
+	/// <param name="_Rect">The union of the screen rectangles of the objects, the draw is scissored to it.</param>
+	void DrawStorePassBatch( ae::Camera& _Camera, StorePassTargets _Targets, const PixelRect& _Rect );
+
+	/// <summary>Retrieve the model matrix of an object, identity for the objects without transform.</summary>
+	/// <param name="_Object">The drawn object.</param>
+	/// <returns>The model matrix of the object.</returns>
+	static ae::Matrix4x4 GetModelMatrix( const ae::Drawable& _Object );
+
+	/// <summary>Counted mode : turn the counts into offsets with a prefix sum and draw the counted objects again to write their fragments.</summary>
+	void StoreCountedFragments();
+
+	/// <summary>Moment based OIT : draw the objects again, weighted by the transmittance reconstructed from the moments of the first pass.</summary>
+	void AccumulateMomentFragments();
+
+	/// <summary>Retrieve the number of pixels allocated in the storage buffers, rounded up to the tiles with the tiled addressing.</summary>
+	/// <returns>The number of pixels in the storage buffers.</returns>
+	size_t GetStoragePixelsCount() const;
+
+	/// <summary>Copy the parameters of a store pass material in the CPU material table if they changed.</summary>
+	/// <param name="_Material">The material of a drawn object. Ignored if it is not a store pass material.</param>
+	void UpdateMaterial( const ae::Material& _Material );
+
+	/// <summary>Upload the CPU material table to the GPU if it changed since the last upload.</summary>
+	void UploadMaterials();
+
+	/// <summary>Is the overflow tail used by the current insertion mode ?</summary>
+	/// <returns>True if the overflow tail is enabled with the locked or lock free insertion, False otherwise.</returns>
+	Bool IsOverflowTailActive() const;
+
+	/// <summary>Are the accumulation and the revealage targets used ?</summary>
+	/// <returns>True with the overflow tail and the cheaper techniques, False otherwise.</returns>
+	Bool AreBlendedTargetsUsed() const;
+
+	/// <summary>Bind the total absorbance and the power moments of the first pass of the moment based OIT as textures and send them to the bound shader.</summary>
+	/// <typeparam name="ShaderType">ae::Shader or GraphicsShader.</typeparam>
+	/// <param name="_Shader">The bound shader of the second pass.</param>
+	template<typename ShaderType>
+	void BindMomentTextures( const ShaderType& _Shader );
+
+	/// <summary>Bind the accumulation and the revealage of the overflow tail or of a cheaper technique as textures and send them to the bound resolve shader.</summary>
+	/// <typeparam name="ShaderType">GraphicsShader or ComputeShader.</typeparam>
+	/// <param name="_Shader">The bound resolve shader.</param>
+	template<typename ShaderType>
+	void BindTailTextures( const ShaderType& _Shader );
+
+	/// <summary>Is a material rendered in the opaque pre-pass ?</summary>
+	/// <param name="_Material">The material of a drawn object.</param>
+	/// <returns>True if the material is an opaque store pass material and the opaque pre-pass is used, False otherwise.</returns>
+	Bool IsRenderedInOpaquePrePass( const ae::Material& _Material ) const;
+
+	/// <summary>Bind the color and the depth of the opaque pre-pass as textures and send them to the bound resolve shader.</summary>
+	/// <typeparam name="ShaderType">GraphicsShader or ComputeShader.</typeparam>
+	/// <param name="_Shader">The bound resolve shader.</param>
+	template<typename ShaderType>
+	void BindOpaqueTextures( const ShaderType& _Shader );
+
+	/// <summary>Retrieve the store pass shader of the current insertion mode.</summary>
+	/// <returns>The shader to use for the store pass.</returns>
+	GraphicsShader& GetStorePassShader();
+
+	/// <summary>Retrieve the resolve pass shader of the current insertion mode.</summary>
+	/// <returns>The shader to use for the resolve pass.</returns>
+	GraphicsShader& GetResolvePassShader();
+
+	/// <summary>Retrieve a pass of the prefix sum of the counted mode.</summary>
+	/// <param name="_Pass">Index of the pass, see PrefixSumCompute.glsl.</param>
+	/// <returns>The shader to use for the pass.</returns>
+	ComputeShader& GetPrefixSumShader( size_t _Pass );
+
+	/// <summary>Retrieve a shader independent of K, compile it the first time.</summary>
+	/// <param name="_Shader">The shader.</param>
+	/// <param name="_VertexFile">The vertex file name in the K-Buffer shaders directory.</param>
+	/// <param name="_FragmentFile">The fragment file name in the K-Buffer shaders directory.</param>
+	/// <param name="_Name">The name of the shader.</param>
+	/// <returns>The compiled shader.</returns>
+	GraphicsShader& GetSharedShader( std::unique_ptr<GraphicsShader>& _Shader, const std::string& _VertexFile, const std::string& _FragmentFile, const std::string& _Name );
+
+	/// <summary>Retrieve the compute shader classifying the tiles of the tiled resolve.</summary>
+	/// <returns>The shader to use for the classification.</returns>
+	ComputeShader& GetResolveClassifyShader();
+
+	/// <summary>Retrieve the compute shader resolving the tiles of a sorting network.</summary>
+	/// <param name="_Network">Index of the sorting network : 0, 1, 2 and 3 for 2, 4, 8 and 16 fragments.</param>
+	/// <returns>The shader to use for the tiles of the sorting network.</returns>
+	ComputeShader& GetResolveTileShader( size_t _Network );
+
+	/// <summary>Retrieve the shaders of the current K, or the shaders reading K from a uniform if the shaders are not specialized.</summary>
+	/// <returns>The shaders to use.</returns>
+	ShaderPermutation& GetShaderPermutation();
+
+	/// <summary>Retrieve a shader of the current permutation, compile it the first time.</summary>
+	/// <param name="_Shader">The shader of the permutation.</param>
+	/// <param name="_VertexFile">The vertex file name in the K-Buffer shaders directory.</param>
+	/// <param name="_FragmentFile">The fragment file name in the K-Buffer shaders directory.</param>
+	/// <param name="_Name">The name of the shader.</param>
+	/// <returns>The compiled shader, specialized for the current K by the defines of both stages.</returns>
+	GraphicsShader& GetPermutationShader( std::unique_ptr<GraphicsShader>& _Shader, const std::string& _VertexFile, const std::string& _FragmentFile, const std::string& _Name );
+
+	/// <summary>Retrieve a compute shader of the current permutation, compile it the first time.</summary>
+	/// <param name="_Shader">The compute shader of the permutation.</param>
+	/// <param name="_File">The compute file name in the K-Buffer shaders directory.</param>
+	/// <param name="_Defines">Other defines of the shader.</param>
+	/// <param name="_Name">The name of the shader.</param>
+	/// <returns>The compiled compute shader.</returns>
+	ComputeShader& GetPermutationComputeShader( std::unique_ptr<ComputeShader>& _Shader, const std::string& _File, const std::string& _Defines, const std::string& _Name );
+
+	/// <summary>Retrieve the code defining K for the specialized shaders.</summary>
+	/// <returns>The #define of K, empty if the shaders are not specialized.</returns>
+	std::string GetSpecializationDefines() const;
+
+	/// <summary>Resolve the stored fragments with a fullscreen quad in the bound target.</summary>
+	/// <param name="_BackgroundColor">The color behind the fragments where there is no opaque object.</param>
+	/// <param name="_Camera">The camera used for the store pass.</param>
+	void ResolveFullscreen( const ae::Color& _BackgroundColor, ae::Camera& _Camera );
+
+	/// <summary>Resolve the stored fragments by tiles with the compute shaders, in the color texture of the target.</summary>
+	/// <param name="_Target">The target with a 2D color texture.</param>
+	/// <param name="_BackgroundColor">The color behind the fragments where there is no opaque object.</param>
+	/// <param name="_Camera">The camera used for the store pass.</param>
+	void ResolveTiles( ae::Framebuffer& _Target, const ae::Color& _BackgroundColor, ae::Camera& _Camera );
+
+	/// <summary>Bind the K-Buffer storage, the material table and the opaque pre-pass and send the blending settings to the bound resolve shader.</summary>
+	/// <typeparam name="ShaderType">GraphicsShader for the fullscreen resolve, ComputeShader for the tiled resolve.</typeparam>
+	/// <param name="_Shader">The bound resolve shader.</param>
+	/// <param name="_BackgroundColor">The color behind the fragments where there is no opaque object.</param>
+	/// <param name="_Camera">The camera used for the store pass.</param>
+	template<typename ShaderType>
+	void SendResolveParameters( const ShaderType& _Shader, const ae::Color& _BackgroundColor, ae::Camera& _Camera );
+
+	/// <summary>Bind the K-Buffer storage of the current insertion mode and send its settings to the bound shader.</summary>
+	/// <typeparam name="ShaderType">ae::Shader, GraphicsShader or ComputeShader.</typeparam>
+	/// <param name="_Shader">The bound shader.</param>
+	/// <param name="_AccessMode">Access to the K-Buffer images.</param>
+	template<typename ShaderType>
+	void BindStorage( const ShaderType& _Shader, ae::TextureImageBindMode _AccessMode );
+
 private:	
+	/// <summary>Width given to the last resize, the width of the target.</summary>
+	Uint32 m_OutputWidth;
+
+	/// <summary>Height given to the last resize, the height of the target.</summary>
+	Uint32 m_OutputHeight;
+
+	/// <summary>Downscale factor from the size given to the resize to the rendered size.</summary>
+	Uint32 m_ResolutionDivisor;
+
+	/// <summary>Cameras of the views side by side in the K-Buffer, empty for the single view rendering.</summary>
+	std::vector<ae::Camera*> m_Views;
+
+	/// <summary>Width rendered by the passes, below the allocated width.</summary>
+	Uint32 m_RenderWidth;
+
+	/// <summary>Height rendered by the passes, below the allocated height.</summary>
+	Uint32 m_RenderHeight;
+
 	/// <summary>The maximum fragments that the K-Buffer can store.</summary>
 	Uint32 m_K;
 
+	/// <summary>Number of fragments per pixel allocated in the storage, the largest K without reallocation.</summary>
+	Uint32 m_KCapacity;
+
+	/// <summary>Algorithm used to insert the fragments in the K-Buffer.</summary>
+	InsertionMode m_InsertionMode;
+
+	/// <summary>Technique used to render the translucent objects.</summary>
+	TransparencyTechnique m_TransparencyTechnique;
+
+	/// <summary>Does the locked insertion use the fragment shader interlock instead of the semaphores ?</summary>
+	Bool m_UseInterlock;
+
+	/// <summary>Are the fragments of the locked insertion kept as a max-heap ?</summary>
+	Bool m_UseMaxHeap;
+
+	/// <summary>Memory layout of the fragments stored by the locked insertion.</summary>
+	StorageLayout m_StorageLayout;
+
+	/// <summary>Are the pixels of the storage buffers addressed by tiles ?</summary>
+	Bool m_UseTiledAddressing;
+
+	/// <summary>Is the pixel-major storage only allocated for the tiles covered by the translucent objects ?</summary>
+	Bool m_IsTileSparse;
+
+	/// <summary>Capacity of the pool of pages of the tile-sparse storage.</summary>
+	Uint32 m_PagesCapacity;
+
+	/// <summary>Pages given to the tiles since the clear pass.</summary>
+	Uint32 m_UsedPagesCount;
+
+	/// <summary>Number of frames in a row using less than a quarter of the pool, and the most pages used by one of them : the pool shrinks after enough of them.</summary>
+	Uint32 m_UnderusedPagesFramesCount;
+	Uint32 m_UnderusedPagesPeak;
+
+	/// <summary>Pages used by the last frame.</summary>
+	Uint32 m_LastUsedPagesCount;
+
+	/// <summary>Are the counts of the locked insertion tagged with the generation of the frame ?</summary>
+	Bool m_IsGenerationTagged;
+
+	/// <summary>Generation of the current frame, 0 when the storage must be fully cleared.</summary>
+	Uint32 m_Generation;
+
+	/// <summary>Bytes written by the last clear pass.</summary>
+	size_t m_LastClearSize;
+
+	/// <summary>Are the opaque objects rendered in the opaque pre-pass ?</summary>
+	Bool m_UseOpaquePrePass;
+
+	/// <summary>Are the passes scissored to the screen rectangles of the objects ?</summary>
+	Bool m_UseScissor;
+
+	/// <summary>Union of the screen rectangles of the objects drawn since the clear pass : the pixels written by the frame, cleared by the next clear pass.</summary>
+	PixelRect m_DirtyRect;
+
+	/// <summary>Local bounds of the drawn objects.</summary>
+	std::unordered_map<const ae::Drawable*, LocalBounds> m_LocalBounds;
+
+	/// <summary>Are the frames updated incrementally ?</summary>
+	Bool m_IsIncremental;
+
+	/// <summary>Has the current frame been recorded by the clear pass to be updated by the resolve pass ?</summary>
+	Bool m_IsFrameRecorded;
+
+	/// <summary>The objects drawn by the current incremental frame.</summary>
+	std::vector<RecordedDraw> m_RecordedDraws;
+
+	/// <summary>The objects drawn by the last incremental frame.</summary>
+	std::vector<RecordedDraw> m_LastRecordedDraws;
+
+	/// <summary>Number of batches recorded by the current incremental frame.</summary>
+	Uint32 m_RecordedBatchesCount;
+
+	/// <summary>Settings of the last incremental frame.</summary>
+	IncrementalSettings m_LastIncrementalSettings;
+
+	/// <summary>Resolved image of the last incremental frame or of the views with the allocated size, created when first used.</summary>
+	std::unique_ptr<ae::Framebuffer> m_ResolvedImage;
+
+	/// <summary>Nearest depth of the drawn objects at the size given to the resize, guiding the upsampling below the target resolution. Created when first used.</summary>
+	std::unique_ptr<ae::Framebuffer> m_GuideDepths;
+
+	/// <summary>Resolved colors and coverage below the target resolution, with the allocated size. Created when first used.</summary>
+	std::unique_ptr<ae::Framebuffer> m_LowResolutionImage;
+
+	/// <summary>Does the resolved image hold the last incremental frame ?</summary>
+	Bool m_IsResolvedImageValid;
+
+	/// <summary>Number of pixels updated by the last incremental frame.</summary>
+	Uint32 m_LastUpdatedPixelsCount;
+
+	/// <summary>Are the dropped fragments accumulated in the overflow tail ?</summary>
+	Bool m_UseOverflowTail;
+
+	/// <summary>Algorithm used to sort and blend the stored fragments.</summary>
+	ResolveMode m_ResolveMode;
+
+	/// <summary>Are the shaders compiled for the current K ?</summary>
+	Bool m_IsShaderSpecialized;
+
+	/// <summary>Number of fragments that the pool of the linked lists can store.</summary>
+	Uint32 m_FragmentPoolCapacity;
+
+	/// <summary>What to do when the fragment pool is exhausted.</summary>
+	PoolOverflowPolicy m_PoolOverflowPolicy;
+
+	/// <summary>Count of fragments allocated by the last frame read back.</summary>
+	Uint32 m_LastAllocatedFragmentsCount;
+
+	/// <summary>Is K adapted to the GPU time of the passes ?</summary>
+	Bool m_IsKAdaptive;
 
-	/// <summary>The shader used to store the fragment of drawn objects into the K-Buffer.</summary>
-	ae::Shader m_StorePassShader;
+	/// <summary>GPU time allowed to the K-Buffer passes in milliseconds.</summary>
+	float m_FrameTimeBudget;
 
-	/// <summary>The shader used to sort and blend the stored fragments.</summary>
-	ae::Shader m_ResolvePassShader;
+	/// <summary>Are the frames profiled ?</summary>
+	Bool m_IsProfiled;
 
+	/// <summary>Statistics of the last profiled frame read back.</summary>
+	FrameStatistics m_LastFrameStatistics;
 
-	/// <summary>K-Buffer semaphores ( 0 or 1 ).</summary>
+	/// <summary>Is the current frame profiled, from the clear pass to the resolve pass ?</summary>
+	Bool m_IsFrameProfiled;
+
+	/// <summary>Occupancy of the pixels shown instead of the resolved image.</summary>
+	DebugView m_DebugView;
+
+	/// <summary>Is the occupancy recorded without debug view ?</summary>
+	Bool m_IsOccupancyRecorded;
+
+	/// <summary>Count of dropped fragments or spin iterations shown in red by the debug views.</summary>
+	float m_HeatmapMaxValue;
+
+	/// <summary>Depth complexity histogram of the last recorded frame read back.</summary>
+	std::vector<Uint32> m_DepthComplexityHistogram;
+
+
+	/// <summary>The shader used to render the opaque objects in the opaque pre-pass.</summary>
+	ae::Shader m_OpaquePassShader;
+
+	/// <summary>The shaders reading K from a uniform (index 0) and the shaders specialized for each K (index K).</summary>
+	std::array<ShaderPermutation, 17> m_ShaderPermutations;
+
+	/// <summary>The store pass shader of the linked lists mode, independent of K. Created the first time the mode is used.</summary>
+	std::unique_ptr<GraphicsShader> m_StorePassLinkedListShader;
+
+	/// <summary>The resolve pass shader of the linked lists mode, independent of K. Created the first time the mode is used.</summary>
+	std::unique_ptr<GraphicsShader> m_ResolvePassLinkedListShader;
+
+	/// <summary>The first store pass shader of the counted mode, counting the fragments of each pixel.</summary>
+	std::unique_ptr<GraphicsShader> m_StorePassCountShader;
+
+	/// <summary>The second store pass shader of the counted mode, writing the fragments in the range of their pixel.</summary>
+	std::unique_ptr<GraphicsShader> m_StorePassCountedShader;
+
+	/// <summary>The resolve pass shader of the counted mode.</summary>
+	std::unique_ptr<GraphicsShader> m_ResolvePassCountedShader;
+
+	/// <summary>The shader showing the occupancy of the debug views.</summary>
+	std::unique_ptr<GraphicsShader> m_ResolvePassDebugShader;
+
+	/// <summary>The shader upsampling the low resolution image in the target.</summary>
+	std::unique_ptr<GraphicsShader> m_UpsampleShader;
+
+	/// <summary>The compute shader building the depth complexity histogram. Created the first time the occupancy is recorded.</summary>
+	std::unique_ptr<ComputeShader> m_DepthComplexityShader;
+
+	/// <summary>The 3 passes of the prefix sum of the counted mode.</summary>
+	std::array<std::unique_ptr<ComputeShader>, 3> m_PrefixSumShaders;
+
+	/// <summary>The store pass shader of the weighted blended OIT.</summary>
+	std::unique_ptr<GraphicsShader> m_StorePassWeightedBlendedShader;
+
+	/// <summary>The first store pass shader of the moment based OIT, accumulating the moments.</summary>
+	std::unique_ptr<GraphicsShader> m_StorePassMomentsShader;
+
+	/// <summary>The second store pass shader of the moment based OIT, accumulating the colors weighted by the transmittance.</summary>
+	std::unique_ptr<GraphicsShader> m_StorePassMomentsBlendShader;
+
+	/// <summary>The resolve pass shader of the weighted blended and moment based OIT.</summary>
+	std::unique_ptr<GraphicsShader> m_ResolvePassBlendedShader;
+
+	/// <summary>The compute shader measuring the difference between two resolved images. Created the first time a difference is measured.</summary>
+	std::unique_ptr<ComputeShader> m_ImageDifferenceShader;
+
+
+	/// <summary>K-Buffer semaphores ( 0 or 1 ). Not allocated when the interlock is used.</summary>
 	ae::Texture2D m_Semaphores;
 	
-	/// <summary>Count of fragments stored.</summary>
+	/// <summary>Count of fragments stored, or counted by the first pass of the counted mode.</summary>
 	ae::Texture2D m_Counts;
 
-	/// <summary>Index of the material for each fragment stored.</summary>
+	/// <summary>Count of fragments dropped by each pixel when the occupancy is recorded.</summary>
+	ae::Texture2D m_DroppedCounts;
+
+	/// <summary>Failed attempts to lock the semaphore of each pixel when the occupancy is recorded.</summary>
+	ae::Texture2D m_SpinCounts;
+
+	/// <summary>Index of the material and facing flag for each fragment stored. The positions are rebuilt from the depths.</summary>
 	ae::Texture2DArray m_MaterialIndices;
 
 	/// <summary>Depth of each fragment stored.</summary>
 	ae::Texture2DArray m_Depths;
 
-	/// <summary>Position of each fragment stored.</summary>
-	ae::Texture2DArray m_Positions;
+	/// <summary>Accumulated colors and revealages of the overflow tail and of the cheaper techniques, the revealages hold the absorbances of the moment based OIT. 1x1 when no technique blends.</summary>
+	ae::Texture2D m_BlendedAccumulations;
+	ae::Texture2D m_BlendedRevealages;
+
+	/// <summary>Power moments of the moment based OIT, 1x1 for the other techniques.</summary>
+	ae::Texture2D m_PowerMoments;
+
+	/// <summary>Material datas for each different StorePassMaterial met, indexed by material index.</summary>
+	std::vector<MaterialTableEntry> m_MaterialTable;
+
+	/// <summary>GPU copy of the material table, read by the resolve pass.</summary>
+	GPUBuffer m_Materials;
+
+	/// <summary>Has the material table changed since the last upload ?</summary>
+	Bool m_AreMaterialsDirty;
+
+	/// <summary>Has a material index out of the table been warned ? Warned once, not every frame.</summary>
+	Bool m_IsMaterialsLimitWarned;
+
+	/// <summary>K packed fragments (depth and material) per pixel for the lock free mode.</summary>
+	GPUBuffer m_PackedFragments;
+
+	/// <summary>Count and K fragments per pixel, contiguous, for the pixel-major storage layout. Pool of pages of 8x8 pixels for the tile-sparse storage.</summary>
+	GPUBuffer m_Fragments;
+
+	/// <summary>Page of each tile in the pool for the tile-sparse storage, and its CPU copy.</summary>
+	GPUBuffer m_TilePages;
+	std::vector<Uint32> m_TilePagesTable;
+
+	/// <summary>Link to the first fragment of the list of each pixel for the linked lists mode.</summary>
+	GPUBuffer m_ListHeads;
+
+	/// <summary>Count of fragments allocated by the frame followed by the fragments of all the linked lists, or of all the ranges of the counted mode.</summary>
+	GPUBuffer m_FragmentPool;
+
+	/// <summary>Offset of the range of each pixel in the fragment pool, followed by the total count, for the counted mode.</summary>
+	GPUBuffer m_CountedOffsets;
+
+	/// <summary>Sum of the counts of each block of pixels, then offset of each block, for the prefix sum of the counted mode.</summary>
+	GPUBuffer m_BlockSums;
+
+	/// <summary>The objects drawn since the clear pass, drawn again by the resolve pass in the counted mode and the moment based OIT.</summary>
+	std::vector<ReplayedDraw> m_ReplayedDraws;
+
+	/// <summary>The objects of the batch being drawn with their screen rectangle.</summary>
+	std::vector<ReplayedDraw> m_BatchedDraws;
+
+	/// <summary>Meshes copied in the batch arena, by batched object.</summary>
+	std::unordered_map<const ae::Drawable*, BatchMesh> m_BatchMeshes;
+
+	/// <summary>Vertices and indices of the meshes of the batches, and the count used by the copied meshes.</summary>
+	GPUBuffer m_BatchVertices;
+	GPUBuffer m_BatchIndices;
+	Uint32 m_BatchVerticesCount;
+	Uint32 m_BatchIndicesCount;
+
+	/// <summary>Per instance attributes and draw commands of the batch, and their CPU copies.</summary>
+	GPUBuffer m_BatchInstances;
+	GPUBuffer m_BatchCommands;
+	std::vector<InstancedDrawable::InstanceAttributes> m_BatchInstancesData;
+	std::vector<DrawElementsCommand> m_BatchCommandsData;
+
+	/// <summary>Vertex array reading the positions of the batch arena and the per instance attributes.</summary>
+	Uint32 m_BatchVertexArray;
+
+	/// <summary>Sums of the differences of each work group when measuring the difference between two images.</summary>
+	GPUBuffer m_DifferenceSums;
+
+	/// <summary>Copy of the allocated count of a frame, read by the CPU once the fence is signaled.</summary>
+	GPUBuffer m_AllocatedCountReadback;
+
+	/// <summary>Fence signaled when the copy of the allocated count is done, null when no copy is pending.</summary>
+	GLsync m_AllocatedCountFence;
+
+	/// <summary>Counters of the store pass of the profiled frame, see StatisticsCommon.glsl.</summary>
+	GPUBuffer m_Statistics;
+
+	/// <summary>Queries and counters of the two last profiled frames, used in turn.</summary>
+	std::array<ProfiledFrame, 2> m_ProfiledFrames;
+
+	/// <summary>Index of the profiled frame used by the next frame.</summary>
+	size_t m_NextProfiledFrame;
+
+	/// <summary>Count of pixels of each depth complexity, see DepthComplexityCompute.glsl.</summary>
+	GPUBuffer m_DepthComplexityBins;
+
+	/// <summary>Copy of the depth complexity histogram of a frame, read by the CPU once the fence is signaled.</summary>
+	GPUBuffer m_DepthComplexityReadback;
+
+	/// <summary>Fence signaled when the copy of the depth complexity histogram is done, null when no copy is pending.</summary>
+	GLsync m_DepthComplexityFence;
 
-	/// <summary>Material datas for each different StorePassMaterial met.</summary>
-	ae::Texture1DArray m_Materials;
+	/// <summary>Indirect dispatch arguments and lists of tiles of each sorting network for the tiled resolve.</summary>
+	GPUBuffer m_ResolveTiles;
 
 	/// <summary>Sprite for fullscreen passes.</summary>
 	ae::FramebufferSprite m_FullscreenSprite;
@@ -0,0 +1,249 @@
+#include "KBufferBenchmark.h"
+
+#include <API/Code/Graphics/Dependencies/OpenGL.h>
+#include <API/Code/Graphics/Camera/Camera.h>
+#include <API/Code/Maths/Functions/MathsFunctions.h>
+#include <API/Code/Aero/Aero.h>
+#include <API/Code/Debugging/Debugging.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+KBufferBenchmark::KBufferBenchmark( Uint32 _LayersCount, Uint32 _FramesCount ) :
+	m_FramesCount( ae::Math::Max( 1u, _FramesCount ) )
+{
+	m_LayerMaterials[0].SetName( "Benchmark Layer Material" );
+	m_LayerMaterials[0].GetBaseColor().SetValue( ae::Color( 0.2f, 0.4f, 0.8f, 0.2f ) );
+
+	m_LayerMaterials[1].SetName( "Benchmark Layer Material Alternate" );
+	m_LayerMaterials[1].GetBaseColor().SetValue( ae::Color( 0.8f, 0.3f, 0.1f, 0.3f ) );
+
+	// Planes facing the camera, spread between the camera orbit center and the camera.
+	for( Uint32 l = 0; l < _LayersCount; l++ )
+	{
+		std::unique_ptr<ae::Shape::PlaneStatic> Layer = std::make_unique<ae::Shape::PlaneStatic>( 20.0f );
+		Layer->SetName( "Benchmark Layer " + std::to_string( l ) );
+		Layer->SetRotation( ae::Math::PiDivBy2(), 0.0f, 0.0f );
+		Layer->SetPosition( 0.0f, 0.5f, -1.0f + 2.0f * Cast( float, l ) / Cast( float, ae::Math::Max( 1u, _LayersCount ) ) );
+		Layer->SetMaterial( m_LayerMaterials[l % m_LayerMaterials.size()] );
+
+		m_Layers.push_back( std::move( Layer ) );
+	}
+}
+
+void KBufferBenchmark::AddConfiguration( const std::string& _Name, const Configuration& _Setup )
+{
+	m_Configurations.push_back( { _Name, _Setup } );
+}
+
+void KBufferBenchmark::AddOpaqueOccluder()
+{
+	m_OccluderMaterial.SetName( "Benchmark Occluder Material" );
+	m_OccluderMaterial.GetBaseColor().SetValue( ae::Color( 0.8f, 0.8f, 0.2f, 1.0f ) );
+
+	m_Occluder = std::make_unique<ae::Shape::PlaneStatic>( 20.0f );
+	m_Occluder->SetName( "Benchmark Occluder" );
+	m_Occluder->SetRotation( ae::Math::PiDivBy2(), 0.0f, 0.0f );
+	m_Occluder->SetPosition( 0.0f, 0.5f, 0.0f );
+	m_Occluder->SetMaterial( m_OccluderMaterial );
+}
+
+void KBufferBenchmark::AddProps( Uint32 _PropsCount, PropsMode _Mode )
+{
+	// Square grid covering the screen, the props of a row overlap their neighbours and the rows alternate their depth.
+	Uint32 GridSize = ae::Math::Max( 1u, Cast( Uint32, std::ceil( std::sqrt( Cast( float, _PropsCount ) ) ) ) );
+	float Spacing = 4.0f / Cast( float, GridSize );
+
+	ae::Shape::PlaneStatic PropMesh( Spacing * 1.5f );
+	PropMesh.SetRotation( ae::Math::PiDivBy2(), 0.0f, 0.0f );
+
+	if( _Mode == PropsMode::Instanced )
+	{
+		m_InstancedProps = std::make_unique<InstancedDrawable>( PropMesh );
+		m_InstancedProps->SetName( "Benchmark Instanced Props" );
+		m_InstancedProps->SetMaterial( m_LayerMaterials[0] );
+	}
+
+	for( Uint32 p = 0; p < _PropsCount; p++ )
+	{
+		Uint32 Column = p % GridSize;
+		Uint32 Row = p / GridSize;
+
+		ae::Vector3 Position( -2.0f + ( Cast( float, Column ) + 0.5f ) * Spacing, -1.5f + ( Cast( float, Row ) + 0.5f ) * Spacing, 0.5f * Cast( float, Row % 4 ) - 1.0f );
+		const StorePassMaterial& PropMaterial = m_LayerMaterials[p % m_LayerMaterials.size()];
+
+		if( _Mode == PropsMode::Instanced )
+		{
+			PropMesh.SetPosition( Position );
+			m_InstancedProps->AddInstance( PropMesh.GetMatrix(), PropMaterial );
+			continue;
+		}
+
+		std::unique_ptr<ae::Shape::PlaneStatic> Prop = std::make_unique<ae::Shape::PlaneStatic>( Spacing * 1.5f );
+		Prop->SetName( "Benchmark Prop " + std::to_string( p ) );
+		Prop->SetRotation( ae::Math::PiDivBy2(), 0.0f, 0.0f );
+		Prop->SetPosition( Position );
+		Prop->SetMaterial( m_LayerMaterials[p % m_LayerMaterials.size()] );
+
+		if( _Mode == PropsMode::Batched )
+			m_BatchedProps.push_back( Prop.get() );
+
+		m_Props.push_back( std::move( Prop ) );
+	}
+}
+
+void KBufferBenchmark::SetQualityReference( const Configuration& _Setup )
+{
+	m_QualityReference = _Setup;
+}
+
+void KBufferBenchmark::Run( KBuffer& _KBuffer, ae::Framebuffer& _Target )
+{
+	// The first frames of a configuration can include shader compilation or allocations, they are not measured.
+	const Uint32 WarmUpFramesCount = 5;
+
+	_KBuffer.SetStorePassMaterialCount( StorePassMaterial::GetStorePassMaterialCount() );
+	_KBuffer.Resize( _Target.GetWidth(), _Target.GetHeight() );
+
+	std::array<GLuint, PassCount> Queries;
+	glGenQueries( PassCount, Queries.data() );
+	AE_ErrorCheckOpenGLError();
+
+	// The frame of the reference is kept to compare the configurations with it.
+	std::unique_ptr<ae::Framebuffer> Reference;
+	if( m_QualityReference )
+	{
+		m_QualityReference( _KBuffer );
+
+		for( Uint32 f = 0; f < WarmUpFramesCount; f++ )
+			RenderFrame( _KBuffer, _Target, nullptr );
+
+		Reference = std::make_unique<ae::Framebuffer>( _Target.GetWidth(), _Target.GetHeight() );
+		Reference->Blit( _Target );
+	}
+
+	for( const Entry& Configuration : m_Configurations )
+	{
+		Configuration.Setup( _KBuffer );
+
+		std::array<double, PassCount> TotalTimes = { 0.0, 0.0, 0.0 };
+		double TotalCPUTime = 0.0;
+
+		for( Uint32 f = 0; f < WarmUpFramesCount + m_FramesCount; f++ )
+		{
+			double CPUTime = RenderFrame( _KBuffer, _Target, Queries.data() );
+
+			if( f < WarmUpFramesCount )
+				continue;
+
+			TotalCPUTime += CPUTime;
+
+			// Wait for the results : the benchmark does not care about stalling the pipeline.
+			for( Uint32 p = 0; p < PassCount; p++ )
+			{
+				GLuint64 Time = 0;
+				glGetQueryObjectui64v( Queries[p], GL_QUERY_RESULT, &Time );
+				TotalTimes[p] += Cast( double, Time ) * 1e-6;
+			}
+		}
+
+		// The counters of the store pass give the fragments behind the traffic of the passes. They are collected after the measures : their atomic operations
+		// would be measured too. The statistics are read back a few frames late, the frame after the finish reads them all.
+		Bool WasProfiled = _KBuffer.IsProfiled();
+		_KBuffer.SetIsProfiled( True );
+
+		for( Uint32 f = 0; f < WarmUpFramesCount; f++ )
+			RenderFrame( _KBuffer, _Target, nullptr );
+
+		glFinish();
+		RenderFrame( _KBuffer, _Target, nullptr );
+
+		KBuffer::PassesTraffic Traffic = _KBuffer.EstimatePassesTraffic( _KBuffer.GetLastFrameStatistics() );
+		_KBuffer.SetIsProfiled( WasProfiled );
+
+		std::ostringstream Result;
+		Result << std::fixed << std::setprecision( 3 );
+		Result << "K-Buffer benchmark [" << Configuration.Name << "] layers: " << m_Layers.size() << ", K: " << _KBuffer.GetK();
+		if( !m_Props.empty() || m_InstancedProps != nullptr )
+			Result << ", props: " << ( m_InstancedProps != nullptr ? m_InstancedProps->GetInstancesCount() : m_Props.size() ) << ( m_InstancedProps != nullptr ? " instanced" : m_BatchedProps.empty() ? "" : " batched" );
+
+		Result << " | frame (CPU): " << TotalCPUTime / m_FramesCount << " ms";
+		// Bandwidth of the clear pass : the memory it writes over its time.
+		double StorageSize = Cast( double, _KBuffer.GetStorageSize() );
+		double ClearSize = Cast( double, _KBuffer.GetLastClearSize() );
+		double ClearTime = TotalTimes[ClearPass] / m_FramesCount;
+		Result << " | storage: " << StorageSize / ( 1024.0 * 1024.0 ) << " MB";
+		Result << " | cleared: " << ClearSize / ( 1024.0 * 1024.0 ) << " MB";
+		Result << " | clear: " << ClearTime << " ms (" << ClearSize / ( ae::Math::Max( ClearTime, 1e-6 ) * 1e6 ) << " GB/s)";
+
+		// Bandwidth of the store and resolve passes : the memory of the records they read and write over their time.
+		auto WritePass = [&Result]( const char* _Name, double _Time, size_t _ReadSize, size_t _WrittenSize )
+		{
+			Result << " | " << _Name << ": " << _Time << " ms";
+			if( _ReadSize + _WrittenSize > 0 )
+				Result << " (read " << _ReadSize / ( 1024.0 * 1024.0 ) << " MB, written " << _WrittenSize / ( 1024.0 * 1024.0 ) << " MB, " << ( _ReadSize + _WrittenSize ) / ( ae::Math::Max( _Time, 1e-6 ) * 1e6 ) << " GB/s)";
+		};
+
+		WritePass( "store", TotalTimes[StorePass] / m_FramesCount, Traffic.StoreReadSize, Traffic.StoreWrittenSize );
+		WritePass( "resolve", TotalTimes[ResolvePass] / m_FramesCount, Traffic.ResolveReadSize, Traffic.ResolveWrittenSize );
+
+		// The target holds the last frame of the configuration.
+		if( Reference != nullptr )
+		{
+			KBuffer::ImageDifference Difference = _KBuffer.MeasureDifference( *Reference, _Target );
+			Result << std::setprecision( 5 );
+			Result << " | error: mean " << Difference.MeanError << ", rms " << Difference.RootMeanSquareError << ", max " << Difference.MaxError;
+		}
+
+		AE_LogMessage( Result.str() );
+	}
+
+	glDeleteQueries( PassCount, Queries.data() );
+	AE_ErrorCheckOpenGLError();
+}
+
+double KBufferBenchmark::RenderFrame( KBuffer& _KBuffer, ae::Framebuffer& _Target, const Uint32* _Queries )
+{
+	std::chrono::high_resolution_clock::time_point Start = std::chrono::high_resolution_clock::now();
+
+	auto BeginPass = [_Queries]( Pass _Pass ) { if( _Queries != nullptr ) glBeginQuery( GL_TIME_ELAPSED, _Queries[_Pass] ); };
+	auto EndPass = [_Queries]() { if( _Queries != nullptr ) glEndQuery( GL_TIME_ELAPSED ); };
+
+	_KBuffer.Bind();
+
+	BeginPass( ClearPass );
+	_KBuffer.ClearPass();
+	EndPass();
+
+	BeginPass( StorePass );
+	if( m_Occluder != nullptr )
+		_KBuffer.Draw( *m_Occluder );
+
+	for( const std::unique_ptr<ae::Shape::PlaneStatic>& Layer : m_Layers )
+		_KBuffer.Draw( *Layer );
+
+	if( !m_BatchedProps.empty() )
+		_KBuffer.DrawBatch( m_BatchedProps );
+	else
+	{
+		for( const std::unique_ptr<ae::Shape::PlaneStatic>& Prop : m_Props )
+			_KBuffer.Draw( *Prop );
+	}
+
+	if( m_InstancedProps != nullptr )
+		_KBuffer.Draw( *m_InstancedProps );
+	EndPass();
+
+	_KBuffer.Unbind();
+
+	BeginPass( ResolvePass );
+	_KBuffer.Resolve( _Target, True, ae::Color::White );
+	EndPass();
+
+	AE_ErrorCheckOpenGLError();
+
+	return std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - Start ).count();
+}
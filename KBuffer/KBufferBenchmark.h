@@ -0,0 +1,129 @@
+#pragma once
+
+#include "KBuffer.h"
+#include "StorePassMaterial.h"
+#include "InstancedDrawable.h"
+
+#include <API/Code/Graphics/Shapes/3D/PlaneStatic.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Measure the GPU time of the K-Buffer passes on a contention scene.<para/>
+/// The scene is a stack of planes covering the screen : every pixel receives one fragment per plane, all at the same time.<para/>
+/// Each configuration is applied to the K-Buffer, rendered several frames and the average time of each pass is logged,
+/// with the CPU time of the frame, the size of the fragments storage, the memory written by the clear pass and its bandwidth.
+/// The memory read and written by the store and resolve passes is estimated from the counters of profiled frames rendered after the measures, with their bandwidth.<para/>
+/// Small translucent props can be added to the scene, drawn one by one, by one batch or by one instanced drawable, to measure the cost of many draws.<para/>
+/// With a quality reference, the last frame of each configuration is also compared with the frame of the reference.
+/// </summary>
+class KBufferBenchmark
+{
+public:
+	/// <summary>Function that setups the K-Buffer before measuring a configuration.</summary>
+	using Configuration = std::function<void( KBuffer& )>;
+
+	/// <summary>How the props are drawn.</summary>
+	enum class PropsMode : Uint32
+	{
+		/// <summary>Each prop is a drawable with its own draw.</summary>
+		Separate,
+
+		/// <summary>Each prop is a drawable, all the props are drawn by one batch.</summary>
+		Batched,
+
+		/// <summary>The props are the instances of one instanced drawable.</summary>
+		Instanced
+	};
+
+public:
+	/// <summary>Build the contention scene.</summary>
+	/// <param name="_LayersCount">Number of planes stacked in front of the camera (depth complexity of each pixel).</param>
+	/// <param name="_FramesCount">Number of frames measured for each configuration.</param>
+	KBufferBenchmark( Uint32 _LayersCount, Uint32 _FramesCount = 100 );
+
+	/// <summary>Add a configuration to measure.</summary>
+	/// <param name="_Name">The name of the configuration, used in the logs.</param>
+	/// <param name="_Setup">Function to call to setup the K-Buffer for this configuration.</param>
+	void AddConfiguration( const std::string& _Name, const Configuration& _Setup );
+
+	/// <summary>Add an opaque plane in the middle of the stack, drawn before the layers : it hides the furthest half of the layers.</summary>
+	void AddOpaqueOccluder();
+
+	/// <summary>Add small translucent planes in a grid covering the screen, drawn after the layers.</summary>
+	/// <param name="_PropsCount">Number of props.</param>
+	/// <param name="_Mode">How the props are drawn.</param>
+	void AddProps( Uint32 _PropsCount, PropsMode _Mode );
+
+	/// <summary>Set the configuration rendering the reference frame : the difference of each configuration with it is logged.</summary>
+	/// <param name="_Setup">Function to call to setup the K-Buffer for the reference, usually the K-Buffer technique with a K large enough for the layers.</param>
+	void SetQualityReference( const Configuration& _Setup );
+
+	/// <summary>Measure all the configurations and log the results.</summary>
+	/// <param name="_KBuffer">The K-Buffer to measure. It is resized to the target and left with the last configuration.</param>
+	/// <param name="_Target">The framebuffer to resolve the K-Buffer in.</param>
+	void Run( KBuffer& _KBuffer, ae::Framebuffer& _Target );
+
+private:
+	/// <summary>Passes measured for each frame.</summary>
+	enum Pass : Uint32
+	{
+		ClearPass,
+		StorePass,
+		ResolvePass,
+		PassCount
+	};
+
+	/// <summary>A configuration to measure.</summary>
+	struct Entry
+	{
+		/// <summary>The name of the configuration.</summary>
+		std::string Name;
+
+		/// <summary>Function to setup the K-Buffer.</summary>
+		Configuration Setup;
+	};
+
+private:
+	/// <summary>Render a frame of the scene : clear, store and resolve passes.</summary>
+	/// <param name="_KBuffer">The K-Buffer to render with.</param>
+	/// <param name="_Target">The framebuffer to resolve the K-Buffer in.</param>
+	/// <param name="_Queries">Optional time queries of the passes, null if the frame is not measured.</param>
+	/// <returns>The CPU time in milliseconds spent to submit the frame.</returns>
+	double RenderFrame( KBuffer& _KBuffer, ae::Framebuffer& _Target, const Uint32* _Queries );
+
+private:
+	/// <summary>Materials of the planes, alternated to have different colors to blend.</summary>
+	std::array<StorePassMaterial, 2> m_LayerMaterials;
+
+	/// <summary>The planes of the contention scene.</summary>
+	std::vector<std::unique_ptr<ae::Shape::PlaneStatic>> m_Layers;
+
+	/// <summary>Material of the opaque occluder.</summary>
+	StorePassMaterial m_OccluderMaterial;
+
+	/// <summary>Optional opaque plane hiding half of the layers.</summary>
+	std::unique_ptr<ae::Shape::PlaneStatic> m_Occluder;
+
+	/// <summary>The props drawn one by one or by one batch.</summary>
+	std::vector<std::unique_ptr<ae::Shape::PlaneStatic>> m_Props;
+
+	/// <summary>The props drawn by one batch, empty if they are drawn one by one.</summary>
+	std::vector<const ae::Drawable*> m_BatchedProps;
+
+	/// <summary>The props drawn as the instances of one drawable.</summary>
+	std::unique_ptr<InstancedDrawable> m_InstancedProps;
+
+	/// <summary>The configurations to measure.</summary>
+	std::vector<Entry> m_Configurations;
+
+	/// <summary>Configuration of the reference frame, empty to not measure the quality.</summary>
+	Configuration m_QualityReference;
+
+	/// <summary>Number of frames measured for each configuration.</summary>
+	Uint32 m_FramesCount;
+};
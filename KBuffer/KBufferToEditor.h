@@ -6,15 +6,179 @@
 #include <API/Code/UI/Dependencies/IncludeImGui.h>
 #include <API/Code/Maths/Functions/MathsFunctions.h>
 
+#include <cfloat>
+#include <vector>
+
 inline void KBufferToEditor( KBuffer& _KBuffer )
 {
 	ImGui::Text( "K-Buffer" );
+
+	ImGui::Text( "Rendered Size : %u x %u (allocated %u x %u)", _KBuffer.GetRenderWidth(), _KBuffer.GetRenderHeight(), _KBuffer.GetWidth(), _KBuffer.GetHeight() );
+	if( _KBuffer.GetViewsCount() > 1 )
+		ImGui::Text( "Views : %u", _KBuffer.GetViewsCount() );
+	if( ImGui::Button( "Trim Memory" ) )
+		_KBuffer.TrimMemory();
+
+	int ResolutionDivisor = Cast( int, _KBuffer.GetResolutionDivisor() );
+	if( ImGui::SliderInt( "Resolution Divisor", &ResolutionDivisor, 1, 4 ) )
+		_KBuffer.SetResolutionDivisor( Cast( Uint32, ResolutionDivisor ) );
 	
 
 	int K = Cast( int, _KBuffer.GetK() );
 	if( ImGui::SliderInt( "K", &K, 1, 16 ) )
 		_KBuffer.SetK( Cast( Uint32, K ) );
 
+	int KCapacity = Cast( int, _KBuffer.GetKCapacity() );
+	if( ImGui::SliderInt( "K Capacity", &KCapacity, 1, 16 ) )
+		_KBuffer.SetKCapacity( Cast( Uint32, KCapacity ) );
+
+	Bool IsKAdaptive = _KBuffer.IsKAdaptive();
+	if( ImGui::Checkbox( "Adaptive K", &IsKAdaptive ) )
+		_KBuffer.SetIsKAdaptive( IsKAdaptive );
+
+	if( _KBuffer.IsKAdaptive() )
+	{
+		float FrameTimeBudget = _KBuffer.GetFrameTimeBudget();
+		if( ImGui::DragFloat( "Frame Time Budget (ms)", &FrameTimeBudget, 0.01f, 0.0f, 100.0f ) )
+			_KBuffer.SetFrameTimeBudget( FrameTimeBudget );
+	}
+
+	Bool IsProfiled = _KBuffer.IsProfiled();
+	if( ImGui::Checkbox( "Profiling", &IsProfiled ) )
+		_KBuffer.SetIsProfiled( IsProfiled );
+
+	if( _KBuffer.IsProfiled() || _KBuffer.IsKAdaptive() )
+	{
+		const KBuffer::FrameStatistics& Statistics = _KBuffer.GetLastFrameStatistics();
+		ImGui::Text( "Clear Pass : %.3f ms", Statistics.ClearPassTime );
+		ImGui::Text( "Store Pass : %.3f ms (%u draws)", Statistics.StorePassTime, Statistics.DrawsCount );
+		ImGui::Text( "Resolve Pass : %.3f ms", Statistics.ResolvePassTime );
+		ImGui::Text( "Stored Fragments : %u", Statistics.StoredFragments );
+		ImGui::Text( "Culled Fragments : %u", Statistics.CulledFragments );
+		ImGui::Text( "Rejected Fragments : %u", Statistics.RejectedFragments );
+		ImGui::Text( "Evicted Fragments : %u", Statistics.EvictedFragments );
+		ImGui::Text( "Spin Iterations : %u", Statistics.SpinIterations );
+	}
+
+	const char* TransparencyTechniques[] = { "K-Buffer", "Weighted Blended", "Moment Based" };
+	int TransparencyTechnique = Cast( int, _KBuffer.GetTransparencyTechnique() );
+	if( ImGui::Combo( "Technique", &TransparencyTechnique, TransparencyTechniques, IM_ARRAYSIZE( TransparencyTechniques ) ) )
+		_KBuffer.SetTransparencyTechnique( Cast( KBuffer::TransparencyTechnique, TransparencyTechnique ) );
+
+	const char* InsertionModes[] = { "Locked", "Lock Free", "Linked List", "Counted" };
+	int InsertionMode = Cast( int, _KBuffer.GetInsertionMode() );
+	if( ImGui::Combo( "Insertion Mode", &InsertionMode, InsertionModes, IM_ARRAYSIZE( InsertionModes ) ) )
+		_KBuffer.SetInsertionMode( Cast( KBuffer::InsertionMode, InsertionMode ) );
+
+	if( _KBuffer.GetInsertionMode() == KBuffer::InsertionMode::LinkedList || _KBuffer.GetInsertionMode() == KBuffer::InsertionMode::Counted )
+	{
+		int FragmentPoolCapacity = Cast( int, _KBuffer.GetFragmentPoolCapacity() );
+		if( ImGui::InputInt( "Fragment Pool Capacity", &FragmentPoolCapacity, 65536, 1048576, ImGuiInputTextFlags_EnterReturnsTrue ) )
+			_KBuffer.SetFragmentPoolCapacity( Cast( Uint32, ae::Math::Max( 1, FragmentPoolCapacity ) ) );
+
+		const char* PoolOverflowPolicies[] = { "Drop", "Grow" };
+		int PoolOverflowPolicy = Cast( int, _KBuffer.GetPoolOverflowPolicy() );
+		if( ImGui::Combo( "Pool Overflow", &PoolOverflowPolicy, PoolOverflowPolicies, IM_ARRAYSIZE( PoolOverflowPolicies ) ) )
+			_KBuffer.SetPoolOverflowPolicy( Cast( KBuffer::PoolOverflowPolicy, PoolOverflowPolicy ) );
+
+		ImGui::Text( "Allocated Fragments : %u", _KBuffer.GetLastAllocatedFragmentsCount() );
+	}
+
+	if( KBuffer::IsInterlockSupported() )
+	{
+		Bool UseInterlock = _KBuffer.IsInterlockUsed();
+		if( ImGui::Checkbox( "Use Interlock", &UseInterlock ) )
+			_KBuffer.SetUseInterlock( UseInterlock );
+	}
+
+	const char* StorageLayouts[] = { "Layer-Major Images", "Pixel-Major Buffer" };
+	int StorageLayout = Cast( int, _KBuffer.GetStorageLayout() );
+	if( ImGui::Combo( "Storage Layout", &StorageLayout, StorageLayouts, IM_ARRAYSIZE( StorageLayouts ) ) )
+		_KBuffer.SetStorageLayout( Cast( KBuffer::StorageLayout, StorageLayout ) );
+
+	Bool UseTiledAddressing = _KBuffer.IsTiledAddressingUsed();
+	if( ImGui::Checkbox( "Tiled Addressing", &UseTiledAddressing ) )
+		_KBuffer.SetUseTiledAddressing( UseTiledAddressing );
+
+	if( _KBuffer.GetStorageLayout() == KBuffer::StorageLayout::PixelMajorBuffer )
+	{
+		Bool IsTileSparse = _KBuffer.IsTileSparse();
+		if( ImGui::Checkbox( "Tile-Sparse Storage", &IsTileSparse ) )
+			_KBuffer.SetIsTileSparse( IsTileSparse );
+
+		if( IsTileSparse )
+			ImGui::Text( "Used Pages : %u / %u", _KBuffer.GetLastUsedPagesCount(), _KBuffer.GetPagesCapacity() );
+	}
+
+	Bool IsGenerationTagged = _KBuffer.IsGenerationTagged();
+	if( ImGui::Checkbox( "Generation Tagged", &IsGenerationTagged ) )
+		_KBuffer.SetIsGenerationTagged( IsGenerationTagged );
+
+	Bool UseMaxHeap = _KBuffer.IsMaxHeapUsed();
+	if( ImGui::Checkbox( "Max Heap", &UseMaxHeap ) )
+		_KBuffer.SetUseMaxHeap( UseMaxHeap );
+
+	Bool UseOverflowTail = _KBuffer.IsOverflowTailUsed();
+	if( ImGui::Checkbox( "Overflow Tail", &UseOverflowTail ) )
+		_KBuffer.SetUseOverflowTail( UseOverflowTail );
+
+	Bool UseOpaquePrePass = _KBuffer.IsOpaquePrePassUsed();
+	if( ImGui::Checkbox( "Opaque Pre-Pass", &UseOpaquePrePass ) )
+		_KBuffer.SetUseOpaquePrePass( UseOpaquePrePass );
+
+	Bool UseScissor = _KBuffer.IsScissorUsed();
+	if( ImGui::Checkbox( "Screen Scissor", &UseScissor ) )
+		_KBuffer.SetUseScissor( UseScissor );
+
+	Bool IsIncremental = _KBuffer.IsIncremental();
+	if( ImGui::Checkbox( "Incremental Update", &IsIncremental ) )
+		_KBuffer.SetIsIncremental( IsIncremental );
+
+	if( IsIncremental )
+		ImGui::Text( "Updated Pixels : %u", _KBuffer.GetLastUpdatedPixelsCount() );
+
+	const char* ResolveModes[] = { "Fragment Shader", "Tiled Compute" };
+	int ResolveMode = Cast( int, _KBuffer.GetResolveMode() );
+	if( ImGui::Combo( "Resolve Mode", &ResolveMode, ResolveModes, IM_ARRAYSIZE( ResolveModes ) ) )
+		_KBuffer.SetResolveMode( Cast( KBuffer::ResolveMode, ResolveMode ) );
+
+	Bool IsShaderSpecialized = _KBuffer.IsShaderSpecialized();
+	if( ImGui::Checkbox( "Specialized Shaders", &IsShaderSpecialized ) )
+		_KBuffer.SetIsShaderSpecialized( IsShaderSpecialized );
+
+
+	const char* DebugViews[] = { "None", "Stored Fragments", "Dropped Fragments", "Spin Iterations" };
+	int DebugView = Cast( int, _KBuffer.GetDebugView() );
+	if( ImGui::Combo( "Debug View", &DebugView, DebugViews, IM_ARRAYSIZE( DebugViews ) ) )
+		_KBuffer.SetDebugView( Cast( KBuffer::DebugView, DebugView ) );
+
+	Bool IsOccupancyRecorded = _KBuffer.IsOccupancyRecorded();
+	if( ImGui::Checkbox( "Record Occupancy", &IsOccupancyRecorded ) )
+		_KBuffer.SetIsOccupancyRecorded( IsOccupancyRecorded );
+
+	if( _KBuffer.GetDebugView() != KBuffer::DebugView::None || _KBuffer.IsOccupancyRecorded() )
+	{
+		float HeatmapMaxValue = _KBuffer.GetHeatmapMaxValue();
+		if( ImGui::DragFloat( "Heatmap Max Value", &HeatmapMaxValue, 0.1f, 1.0f, 1024.0f ) )
+			_KBuffer.SetHeatmapMaxValue( HeatmapMaxValue );
+
+		// Pixels of each depth complexity, and the covered pixels receiving more than K fragments.
+		const std::vector<Uint32>& Histogram = _KBuffer.GetDepthComplexityHistogram();
+		std::vector<float> Bins( Histogram.begin(), Histogram.end() );
+		ImGui::PlotHistogram( "Depth Complexity", Bins.data(), Cast( int, Bins.size() ), 0, nullptr, 0.0f, FLT_MAX, ImVec2( 0.0f, 80.0f ) );
+
+		Uint32 CoveredPixels = 0;
+		Uint32 SaturatedPixels = 0;
+		for( size_t b = 1; b < Histogram.size(); b++ )
+		{
+			CoveredPixels += Histogram[b];
+			if( b > _KBuffer.GetK() )
+				SaturatedPixels += Histogram[b];
+		}
+
+		ImGui::Text( "Saturated Pixels : %u / %u", SaturatedPixels, CoveredPixels );
+	}
+
 
 	Bool IsToneMapped = _KBuffer.IsToneMapped();
 	if( ImGui::Checkbox( "Tone Map", &IsToneMapped ) )
@@ -0,0 +1,190 @@
+#include "ShaderProgram.h"
+
+#include <API/Code/Graphics/Dependencies/OpenGL.h>
+#include <API/Code/Debugging/Debugging.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+ShaderProgram::ShaderProgram( const std::string& _Defines ) :
+	m_ProgramID( 0 ),
+	m_Defines( _Defines )
+{
+}
+
+ShaderProgram::~ShaderProgram()
+{
+	FreeResource();
+}
+
+void ShaderProgram::Bind() const
+{
+	glUseProgram( m_ProgramID );
+	AE_ErrorCheckOpenGLError();
+}
+
+void ShaderProgram::Unbind() const
+{
+	glUseProgram( 0 );
+	AE_ErrorCheckOpenGLError();
+}
+
+Int32 ShaderProgram::GetUniformLocation( const std::string& _Name ) const
+{
+	auto Location = m_CachedLocations.find( _Name );
+	if( Location != m_CachedLocations.end() )
+		return Location->second;
+
+	Int32 NewLocation = glGetUniformLocation( m_ProgramID, _Name.c_str() );
+	AE_ErrorCheckOpenGLError();
+
+	m_CachedLocations[_Name] = NewLocation;
+
+	return NewLocation;
+}
+
+Uint32 ShaderProgram::GetProgramID() const
+{
+	return m_ProgramID;
+}
+
+void ShaderProgram::SetName( const std::string& _NewName )
+{
+	ae::Resource::SetName( _NewName );
+
+	glObjectLabel( GL_PROGRAM, m_ProgramID, Cast( GLsizei, _NewName.size() ), _NewName.c_str() );
+	AE_ErrorCheckOpenGLError();
+}
+
+void ShaderProgram::FreeResource()
+{
+	if( m_ProgramID == 0 )
+		return;
+
+	glDeleteProgram( m_ProgramID );
+	AE_ErrorCheckOpenGLError();
+
+	m_ProgramID = 0;
+	m_CachedLocations.clear();
+}
+
+Uint32 ShaderProgram::CompileStage( const std::string& _Path, Uint32 _StageType ) const
+{
+	std::string Content;
+	std::vector<std::string> IncludeHistory = { _Path };
+	if( !ReadEntireFile( Content, _Path ) || !ProcessIncludes( Content, _Path, IncludeHistory ) )
+		return 0;
+
+	// The defines must follow the #version directive.
+	size_t VersionEnd = Content.find( "#version" );
+	VersionEnd = VersionEnd == std::string::npos ? 0 : Content.find( '\n', VersionEnd ) + 1;
+	Content.insert( VersionEnd, m_Defines );
+
+	Uint32 StageID = glCreateShader( _StageType );
+	const char* Source = Content.c_str();
+	glShaderSource( StageID, 1, &Source, nullptr );
+	glCompileShader( StageID );
+
+	GLint IsCompiled = GL_FALSE;
+	glGetShaderiv( StageID, GL_COMPILE_STATUS, &IsCompiled );
+	if( IsCompiled == GL_FALSE )
+	{
+		char InfoLog[1024];
+		glGetShaderInfoLog( StageID, 1024, nullptr, InfoLog );
+		AE_LogError( "Shader " + _Path + " compilation failed : " + InfoLog );
+
+		glDeleteShader( StageID );
+		return 0;
+	}
+
+	return StageID;
+}
+
+void ShaderProgram::LinkStages( const std::vector<Uint32>& _Stages, const std::string& _Description )
+{
+	// A stage that failed to compile already logged its error.
+	if( std::find( _Stages.begin(), _Stages.end(), 0u ) == _Stages.end() )
+	{
+		m_ProgramID = glCreateProgram();
+		for( Uint32 Stage : _Stages )
+			glAttachShader( m_ProgramID, Stage );
+
+		glLinkProgram( m_ProgramID );
+
+		GLint IsLinked = GL_FALSE;
+		glGetProgramiv( m_ProgramID, GL_LINK_STATUS, &IsLinked );
+		if( IsLinked == GL_FALSE )
+		{
+			char InfoLog[1024];
+			glGetProgramInfoLog( m_ProgramID, 1024, nullptr, InfoLog );
+			AE_LogError( _Description + " link failed : " + InfoLog );
+		}
+
+		for( Uint32 Stage : _Stages )
+			glDetachShader( m_ProgramID, Stage );
+	}
+
+	for( Uint32 Stage : _Stages )
+	{
+		if( Stage != 0 )
+			glDeleteShader( Stage );
+	}
+
+	AE_ErrorCheckOpenGLError();
+}
+
+Bool ShaderProgram::ProcessIncludes( std::string& _Content, const std::string& _Path, std::vector<std::string>& _IncludeHistory ) const
+{
+	const std::string IncludeDirective = "#include";
+
+	// Includes are relative to the including file.
+	size_t LastSlash = _Path.find_last_of( "/\\" );
+	std::string Directory = LastSlash == std::string::npos ? "" : _Path.substr( 0, LastSlash + 1 );
+
+	size_t Start = _Content.find( IncludeDirective );
+	while( Start != std::string::npos )
+	{
+		size_t LineEnd = _Content.find( '\n', Start );
+		size_t FirstQuote = _Content.find( '"', Start );
+		size_t LastQuote = FirstQuote == std::string::npos ? std::string::npos : _Content.find( '"', FirstQuote + 1 );
+		if( LastQuote == std::string::npos || LastQuote > LineEnd )
+		{
+			AE_LogError( "Bad #include directive in " + _Path + "." );
+			return False;
+		}
+
+		std::string IncludePath = Directory + _Content.substr( FirstQuote + 1, LastQuote - FirstQuote - 1 );
+		std::string IncludeContent;
+
+		// A file already included is replaced by nothing.
+		if( std::find( _IncludeHistory.begin(), _IncludeHistory.end(), IncludePath ) == _IncludeHistory.end() )
+		{
+			_IncludeHistory.push_back( IncludePath );
+
+			if( !ReadEntireFile( IncludeContent, IncludePath ) || !ProcessIncludes( IncludeContent, IncludePath, _IncludeHistory ) )
+				return False;
+		}
+
+		_Content.replace( Start, LastQuote + 1 - Start, IncludeContent );
+		Start = _Content.find( IncludeDirective, Start + IncludeContent.size() );
+	}
+
+	return True;
+}
+
+Bool ShaderProgram::ReadEntireFile( std::string& _Content, const std::string& _Path ) const
+{
+	std::ifstream File( _Path );
+	if( !File.is_open() )
+	{
+		AE_LogError( "Failed to open the shader file " + _Path + "." );
+		return False;
+	}
+
+	std::stringstream Stream;
+	Stream << File.rdbuf();
+	_Content = Stream.str();
+
+	return True;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <API/Code/Toolbox/Toolbox.h>
+#include <API/Code/Resources/Resource/Resource.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Base of the OpenGL programs built by the K-Buffer from its shader files.<para/>
+/// The sources are read and specialized in memory : the #include directives are processed like the engine shaders, relatively to the including file,
+/// and the defines are inserted after the #version directive of each stage.<para/>
+/// The uniforms are set with the static setters of ae::Shader.
+/// </summary>
+class ShaderProgram : public ae::Resource
+{
+public:
+	/// <summary>Destroy the OpenGL program.</summary>
+	~ShaderProgram();
+
+	/// <summary>Bind the program to the rendering system. Draw and dispatch calls after this call will use this program.</summary>
+	void Bind() const;
+
+	/// <summary>Unbind the program from the rendering system.</summary>
+	void Unbind() const;
+
+	/// <summary>Retrieve the location of a uniform variable from its name.</summary>
+	/// <param name="_Name">The name of the uniform variable.</param>
+	/// <returns>The location of the variable in the program.</returns>
+	Int32 GetUniformLocation( const std::string& _Name ) const;
+
+	/// <summary>Get the OpenGL program ID.</summary>
+	/// <returns>Program ID of the shader.</returns>
+	Uint32 GetProgramID() const;
+
+	/// <summary>Set the name of the program.</summary>
+	/// <param name="_NewName">The new name to apply to the program.</param>
+	void SetName( const std::string& _NewName ) override;
+
+	/// <summary>Free the OpenGL program.</summary>
+	void FreeResource() override;
+
+protected:
+	/// <summary>Create an empty program, the derived shader compiles its stages.</summary>
+	/// <param name="_Defines">Code inserted after the #version directive of each stage, to specialize the shader (#define lines).</param>
+	explicit ShaderProgram( const std::string& _Defines );
+
+	/// <summary>Read, specialize and compile a stage of the program.</summary>
+	/// <param name="_Path">The shader file path.</param>
+	/// <param name="_StageType">The OpenGL type of the stage.</param>
+	/// <returns>The OpenGL ID of the compiled stage, 0 if the stage cannot be read or compiled.</returns>
+	Uint32 CompileStage( const std::string& _Path, Uint32 _StageType ) const;
+
+	/// <summary>Link the compiled stages in the program, then delete them.</summary>
+	/// <param name="_Stages">The compiled stages, the program is not created if one of them is 0.</param>
+	/// <param name="_Description">Description of the program for the error messages.</param>
+	void LinkStages( const std::vector<Uint32>& _Stages, const std::string& _Description );
+
+private:
+	/// <summary>Replace the #include directives with the content of the files, relatively to the including file.</summary>
+	/// <param name="_Content">The shader code to process.</param>
+	/// <param name="_Path">Path of the file of the shader code.</param>
+	/// <param name="_IncludeHistory">Files already included, they are not included twice.</param>
+	/// <returns>True if all the files have been included, False otherwise.</returns>
+	Bool ProcessIncludes( AE_InOut std::string& _Content, const std::string& _Path, std::vector<std::string>& _IncludeHistory ) const;
+
+	/// <summary>Retrieve the entire content of a file.</summary>
+	/// <param name="_Content">The content of the file.</param>
+	/// <param name="_Path">Path to the file to read.</param>
+	/// <returns>True if the reading was sucessfull, False otherwise.</returns>
+	Bool ReadEntireFile( AE_Out std::string& _Content, const std::string& _Path ) const;
+
+private:
+	/// <summary>OpenGL program ID.</summary>
+	Uint32 m_ProgramID;
+
+	/// <summary>Code inserted after the #version directive.</summary>
+	std::string m_Defines;
+
+	/// <summary>Locations saved the first time a uniform location is asked.</summary>
+	mutable std::unordered_map<std::string, Int32> m_CachedLocations;
+};
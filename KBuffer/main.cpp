@@ -1,5 +1,6 @@
 #include "StorePassMaterial.h"
 #include "KBuffer.h"
+#include "KBufferBenchmark.h"
 
 #include "API\Code\Includes.h"
 
@@ -11,7 +12,274 @@ void GetViewportWidthAndHeight( Uint32& _OutWidth, Uint32& _OutHeight, const ae:
 	_OutHeight = Cast( Uint32, ViewportRect.GetHeight() );
 }
 
-int main()
+void RunBenchmarks( KBuffer& _KBuffer )
+{
+	ae::Framebuffer Target( 1920, 1080 );
+
+	// Contention : every layer hits every pixel, from less to more fragments than K.
+	for( Uint32 LayersCount : { 4u, 16u, 64u } )
+	{
+		KBufferBenchmark Benchmark( LayersCount );
+
+		Benchmark.AddConfiguration( "Locked Semaphore", []( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetUseInterlock( False );
+		} );
+
+		if( KBuffer::IsInterlockSupported() )
+			Benchmark.AddConfiguration( "Locked Interlock", []( KBuffer& _KBuffer )
+			{
+				_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+				_KBuffer.SetUseInterlock( True );
+			} );
+
+		if( KBuffer::IsLockFreeSupported() )
+			Benchmark.AddConfiguration( "Lock Free", []( KBuffer& _KBuffer ) { _KBuffer.SetInsertionMode( KBuffer::InsertionMode::LockFree ); } );
+
+		// Every fragment is kept : the pool grows during the warm up frames.
+		Benchmark.AddConfiguration( "Linked List", []( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::LinkedList );
+			_KBuffer.SetPoolOverflowPolicy( KBuffer::PoolOverflowPolicy::Grow );
+		} );
+
+		// Every fragment is kept without links, but the layers are drawn twice : the second geometry pass is measured with the resolve.
+		Benchmark.AddConfiguration( "Counted", []( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Counted );
+			_KBuffer.SetPoolOverflowPolicy( KBuffer::PoolOverflowPolicy::Grow );
+		} );
+
+		Benchmark.Run( _KBuffer, Target );
+	}
+
+	// Insertion cost for each K : more layers than the largest K, so every pixel replaces fragments.
+	KBufferBenchmark Benchmark( 32u );
+	for( Uint32 K : { 2u, 4u, 8u, 16u } )
+	{
+		Benchmark.AddConfiguration( "Furthest Search", [K]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetUseMaxHeap( False );
+			_KBuffer.SetK( K );
+		} );
+
+		Benchmark.AddConfiguration( "Max Heap", [K]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetUseMaxHeap( True );
+			_KBuffer.SetK( K );
+		} );
+	}
+
+	Benchmark.Run( _KBuffer, Target );
+
+	// Storage layouts : the same locked insertion in layer-major images and in the pixel-major buffer.
+	KBufferBenchmark LayoutsBenchmark( 32u );
+	for( Uint32 K : { 4u, 16u } )
+	{
+		LayoutsBenchmark.AddConfiguration( "Layer-Major Images", [K]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetStorageLayout( KBuffer::StorageLayout::LayerMajorImages );
+			_KBuffer.SetUseTiledAddressing( False );
+			_KBuffer.SetKCapacity( K );
+			_KBuffer.SetK( K );
+		} );
+
+		LayoutsBenchmark.AddConfiguration( "Pixel-Major Buffer", [K]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetStorageLayout( KBuffer::StorageLayout::PixelMajorBuffer );
+			_KBuffer.SetUseTiledAddressing( False );
+			_KBuffer.SetKCapacity( K );
+			_KBuffer.SetK( K );
+		} );
+
+		LayoutsBenchmark.AddConfiguration( "Pixel-Major Buffer Tiled", [K]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetStorageLayout( KBuffer::StorageLayout::PixelMajorBuffer );
+			_KBuffer.SetUseTiledAddressing( True );
+			_KBuffer.SetKCapacity( K );
+			_KBuffer.SetK( K );
+		} );
+	}
+
+	LayoutsBenchmark.Run( _KBuffer, Target );
+
+	// Clear pass : the whole storage cleared every frame or only a new generation for the counts.
+	KBufferBenchmark ClearBenchmark( 16u );
+	for( KBuffer::StorageLayout Layout : { KBuffer::StorageLayout::LayerMajorImages, KBuffer::StorageLayout::PixelMajorBuffer } )
+	{
+		std::string LayoutName = Layout == KBuffer::StorageLayout::LayerMajorImages ? "Images" : "Buffer";
+
+		ClearBenchmark.AddConfiguration( LayoutName + " Full Clear", [Layout]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetStorageLayout( Layout );
+			_KBuffer.SetIsGenerationTagged( False );
+			_KBuffer.SetK( 16 );
+		} );
+
+		ClearBenchmark.AddConfiguration( LayoutName + " Generation Tagged", [Layout]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetStorageLayout( Layout );
+			_KBuffer.SetIsGenerationTagged( True );
+			_KBuffer.SetK( 16 );
+		} );
+	}
+
+	ClearBenchmark.Run( _KBuffer, Target );
+
+	// Opaque pre-pass : an opaque plane hides half of the layers, they are stored or rejected by the depth test.
+	KBufferBenchmark OpaqueBenchmark( 32u );
+	OpaqueBenchmark.AddOpaqueOccluder();
+	for( Bool UseOpaquePrePass : { False, True } )
+	{
+		OpaqueBenchmark.AddConfiguration( UseOpaquePrePass ? "Opaque Pre-Pass" : "Opaque Stored", [UseOpaquePrePass]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetStorageLayout( KBuffer::StorageLayout::LayerMajorImages );
+			_KBuffer.SetUseOpaquePrePass( UseOpaquePrePass );
+			_KBuffer.SetK( 16 );
+		} );
+	}
+
+	OpaqueBenchmark.Run( _KBuffer, Target );
+
+	// Resolve modes : the fullscreen fragment shader and the tiled compute shaders with sorting networks.
+	for( Uint32 LayersCount : { 4u, 32u } )
+	{
+		KBufferBenchmark ResolveBenchmark( LayersCount );
+		for( Uint32 K : { 4u, 16u } )
+		{
+			ResolveBenchmark.AddConfiguration( "Fragment Shader Resolve", [K]( KBuffer& _KBuffer )
+			{
+				_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+				_KBuffer.SetResolveMode( KBuffer::ResolveMode::FragmentShader );
+				_KBuffer.SetK( K );
+			} );
+
+			ResolveBenchmark.AddConfiguration( "Tiled Compute Resolve", [K]( KBuffer& _KBuffer )
+			{
+				_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+				_KBuffer.SetResolveMode( KBuffer::ResolveMode::TiledCompute );
+				_KBuffer.SetK( K );
+			} );
+		}
+
+		ResolveBenchmark.Run( _KBuffer, Target );
+	}
+
+	// Shaders reading K from a uniform and shaders compiled for K. The shaders compiled in the warm up frames are not measured.
+	KBufferBenchmark SpecializationBenchmark( 32u );
+	for( Uint32 K : { 2u, 4u, 8u, 16u } )
+	{
+		for( Bool IsShaderSpecialized : { False, True } )
+		{
+			SpecializationBenchmark.AddConfiguration( IsShaderSpecialized ? "Specialized K" : "Uniform K", [K, IsShaderSpecialized]( KBuffer& _KBuffer )
+			{
+				_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+				_KBuffer.SetResolveMode( KBuffer::ResolveMode::FragmentShader );
+				_KBuffer.SetIsShaderSpecialized( IsShaderSpecialized );
+				_KBuffer.SetK( K );
+			} );
+		}
+	}
+
+	SpecializationBenchmark.Run( _KBuffer, Target );
+
+	// Hybrid K-Buffer : a small K with the dropped fragments in the overflow tail, against a small and a large K without it.
+	KBufferBenchmark TailBenchmark( 32u );
+	for( Uint32 K : { 4u, 16u } )
+	{
+		TailBenchmark.AddConfiguration( "Dropped Fragments", [K]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetResolveMode( KBuffer::ResolveMode::FragmentShader );
+			_KBuffer.SetUseOverflowTail( False );
+			_KBuffer.SetK( K );
+		} );
+	}
+
+	TailBenchmark.AddConfiguration( "Overflow Tail", []( KBuffer& _KBuffer )
+	{
+		_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+		_KBuffer.SetResolveMode( KBuffer::ResolveMode::FragmentShader );
+		_KBuffer.SetUseOverflowTail( True );
+		_KBuffer.SetK( 4 );
+	} );
+
+	TailBenchmark.Run( _KBuffer, Target );
+
+	// Cheaper techniques : time and difference with the K-Buffer storing every layer, against a small K.
+	KBufferBenchmark TechniquesBenchmark( 16u );
+	TechniquesBenchmark.SetQualityReference( []( KBuffer& _KBuffer )
+	{
+		_KBuffer.SetTransparencyTechnique( KBuffer::TransparencyTechnique::KBuffer );
+		_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+		_KBuffer.SetResolveMode( KBuffer::ResolveMode::FragmentShader );
+		_KBuffer.SetUseOverflowTail( False );
+		_KBuffer.SetK( 16 );
+	} );
+
+	TechniquesBenchmark.AddConfiguration( "K-Buffer", []( KBuffer& _KBuffer )
+	{
+		_KBuffer.SetTransparencyTechnique( KBuffer::TransparencyTechnique::KBuffer );
+		_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+		_KBuffer.SetResolveMode( KBuffer::ResolveMode::FragmentShader );
+		_KBuffer.SetUseOverflowTail( False );
+		_KBuffer.SetK( 4 );
+	} );
+
+	TechniquesBenchmark.AddConfiguration( "Weighted Blended", []( KBuffer& _KBuffer ) { _KBuffer.SetTransparencyTechnique( KBuffer::TransparencyTechnique::WeightedBlended ); } );
+	TechniquesBenchmark.AddConfiguration( "Moment Based", []( KBuffer& _KBuffer ) { _KBuffer.SetTransparencyTechnique( KBuffer::TransparencyTechnique::MomentBased ); } );
+
+	TechniquesBenchmark.Run( _KBuffer, Target );
+
+	// Adaptive K : K follows the frame time budget below the capacity, the logged K is the one reached at the end of the measured frames.
+	KBufferBenchmark AdaptiveBenchmark( 32u );
+	for( Uint32 Budget : { 1u, 2u, 4u } )
+	{
+		AdaptiveBenchmark.AddConfiguration( "Adaptive K " + std::to_string( Budget ) + " ms", [Budget]( KBuffer& _KBuffer )
+		{
+			_KBuffer.SetTransparencyTechnique( KBuffer::TransparencyTechnique::KBuffer );
+			_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+			_KBuffer.SetKCapacity( 16 );
+			_KBuffer.SetK( 4 );
+			_KBuffer.SetIsKAdaptive( True );
+			_KBuffer.SetFrameTimeBudget( Cast( float, Budget ) );
+		} );
+	}
+
+	AdaptiveBenchmark.Run( _KBuffer, Target );
+	_KBuffer.SetIsKAdaptive( False );
+
+	// Batching and instancing : many small translucent props drawn one by one, by one batch or by one instanced draw, the frame time against the count of props.
+	for( Uint32 PropsCount : { 256u, 1024u, 4096u, 16384u } )
+	{
+		for( KBufferBenchmark::PropsMode Mode : { KBufferBenchmark::PropsMode::Separate, KBufferBenchmark::PropsMode::Batched, KBufferBenchmark::PropsMode::Instanced } )
+		{
+			const char* ModeName = Mode == KBufferBenchmark::PropsMode::Separate ? "Separate Props" : Mode == KBufferBenchmark::PropsMode::Batched ? "Batched Props" : "Instanced Props";
+
+			KBufferBenchmark InstancingBenchmark( 0u, 20u );
+			InstancingBenchmark.AddProps( PropsCount, Mode );
+			InstancingBenchmark.AddConfiguration( ModeName, []( KBuffer& _KBuffer )
+			{
+				_KBuffer.SetTransparencyTechnique( KBuffer::TransparencyTechnique::KBuffer );
+				_KBuffer.SetInsertionMode( KBuffer::InsertionMode::Locked );
+				_KBuffer.SetK( 4 );
+			} );
+
+			InstancingBenchmark.Run( _KBuffer, Target );
+		}
+	}
+}
+
+int main( int _ArgumentsCount, char** _Arguments )
 {
 	// Call once to initialize everything.
 	Aero;
@@ -92,6 +360,17 @@ int main()
 	kBuffer.Unbind();
 	
 
+	// Measure the K-Buffer passes instead of running the viewer.
+	if( _ArgumentsCount > 1 && std::string( _Arguments[1] ) == "-benchmark" )
+	{
+		RunBenchmarks( kBuffer );
+		MyWindow.Destroy();
+		return 0;
+	}
+
+
+	// The viewer is static most of the time : only the pixels of the changed objects are stored and resolved again.
+	kBuffer.SetIsIncremental( True );
 
 	ae::UI::InitImGUI( MyWindow );
 	ae::Editor Editor;	
@@ -113,9 +392,7 @@ int main()
 		kBuffer.ClearPass();
 
 		// Store pass.
-		kBuffer.Draw( Plane );
-		kBuffer.Draw( Dragon );
-		kBuffer.Draw( ShaderBall );
+		kBuffer.DrawBatch( { &Plane, &Dragon, &ShaderBall } );
 
 		kBuffer.Unbind();
 		